@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    AllocationTrap.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "AllocationTrap.h"
+
+#if EQ1_ALLOCATION_TRAP
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local int noAllocationDepth = 0;
+    std::atomic<int> numTrapped { 0 };
+
+    void checkAllocation() noexcept
+    {
+        if (noAllocationDepth == 0)
+            return;
+
+        ++numTrapped;
+
+        // The assertion logs a String, which allocates, so the trap is lifted while it fires
+        auto depth = noAllocationDepth;
+        noAllocationDepth = 0;
+        jassertfalse;   // allocating or freeing on the audio thread
+        noAllocationDepth = depth;
+    }
+
+    void* allocate (std::size_t size)
+    {
+        checkAllocation();
+
+        if (auto* p = std::malloc (size == 0 ? 1 : size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void release (void* p) noexcept
+    {
+        if (p == nullptr)
+            return;
+
+        checkAllocation();
+        std::free (p);
+    }
+}
+
+namespace AllocationTrap
+{
+    ScopedNoAllocation::ScopedNoAllocation() noexcept      { ++noAllocationDepth; }
+    ScopedNoAllocation::~ScopedNoAllocation() noexcept     { --noAllocationDepth; }
+
+    int getNumTrappedAllocations() noexcept                 { return numTrapped.load(); }
+}
+
+//==============================================================================
+void* operator new (std::size_t size)                                      { return allocate (size); }
+void* operator new[] (std::size_t size)                                    { return allocate (size); }
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate (size); } catch (...) { return nullptr; }
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate (size); } catch (...) { return nullptr; }
+}
+
+void operator delete (void* p) noexcept                                    { release (p); }
+void operator delete[] (void* p) noexcept                                  { release (p); }
+void operator delete (void* p, std::size_t) noexcept                       { release (p); }
+void operator delete[] (void* p, std::size_t) noexcept                     { release (p); }
+void operator delete (void* p, const std::nothrow_t&) noexcept             { release (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept           { release (p); }
+
+#endif
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    AllocationTrap.h
+
+    Catches heap allocation on the audio thread. In debug builds the global
+    operator new and delete are replaced, and any allocation or deallocation
+    made while a ScopedNoAllocation is alive on the calling thread hits an
+    assertion. Release builds compile all of this away.
+
+    Define EQ1_ALLOCATION_TRAP=0 to keep the default operators in a debug
+    build, e.g. when a host or another library replaces them too.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef EQ1_ALLOCATION_TRAP
+ #define EQ1_ALLOCATION_TRAP JUCE_DEBUG
+#endif
+
+namespace AllocationTrap
+{
+   #if EQ1_ALLOCATION_TRAP
+    /** Marks a region of the calling thread that must not allocate, e.g. processBlock. */
+    struct ScopedNoAllocation
+    {
+        ScopedNoAllocation() noexcept;
+        ~ScopedNoAllocation() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedNoAllocation)
+    };
+
+    /** Allocations caught on any thread so far. */
+    int getNumTrappedAllocations() noexcept;
+   #else
+    struct ScopedNoAllocation
+    {
+        ScopedNoAllocation() noexcept {}
+    };
+
+    inline int getNumTrappedAllocations() noexcept      { return 0; }
+   #endif
+}
@@ -0,0 +1,876 @@
+/*
+  ==============================================================================
+
+    BiquadKernels.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "BiquadKernels.h"
+#include "BiquadSIMD.h"
+
+//==============================================================================
+void BlockBiquadCoefficients::design (const BiquadCoefficients& c) noexcept
+{
+    source = c;
+
+    // Each column is the response of the four outputs to a unit value in one input
+    for (int column = 0; column < numColumns; column++)
+    {
+        double x1 = column == stateA1 ? 1.0 : 0.0;
+        double x2 = column == stateA2 ? 1.0 : 0.0;
+        double z1 = column == stateB1 ? 1.0 : 0.0;
+        double z2 = column == stateB2 ? 1.0 : 0.0;
+
+        for (int k = 0; k < blockSize; k++)
+        {
+            double x = column == input0 + k ? 1.0 : 0.0;
+            double z = c.a0 * x + (double) c.a1 * x1 + (double) c.a2 * x2 - (double) c.b1 * z1 - (double) c.b2 * z2;
+
+            x2 = x1;
+            x1 = x;
+            z2 = z1;
+            z1 = z;
+
+            columns[column][k] = (float) z;
+
+            if (column == stateB1 || column == stateB2)
+                feedbackResidual[column - stateB1][k] = (float) (z - (double) columns[column][k]);
+        }
+    }
+}
+
+//==============================================================================
+void BiquadState::prepare (int newNumChannels)
+{
+    numChannels = newNumChannels;
+    paddedChannels = juce::jmax (maxLanes, (newNumChannels + maxLanes - 1) / maxLanes * maxLanes);
+
+    auto bytesPerLine = (size_t) paddedChannels * sizeof (float);
+    storage.calloc ((size_t) numDelayLines * bytesPerLine + alignment);
+
+    auto base = reinterpret_cast<uintptr_t> (storage.get());
+    auto aligned = (base + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+    for (int i = 0; i < numDelayLines; i++)
+        delayLines[i] = reinterpret_cast<float*> (aligned + (size_t) i * bytesPerLine);
+}
+
+void BiquadState::reset() noexcept
+{
+    for (auto* line : delayLines)
+        if (line != nullptr)
+            std::fill (line, line + paddedChannels, 0.0f);
+}
+
+//==============================================================================
+namespace
+{
+    using namespace BiquadSIMD;
+
+    /*
+        Scalar kernel. Keeps the state of one channel in locals for the whole block,
+        so it stays in registers instead of going through memory every sample.
+    */
+    void processScalarChannel (float* data, int channel, int numSamples,
+                               const BiquadCoefficients& c, BiquadState& state) noexcept
+    {
+        BiquadKernel<float, float>::process (data, numSamples, c,
+                                             state.getDelayLine (BiquadState::a1Delay)[channel],
+                                             state.getDelayLine (BiquadState::a2Delay)[channel],
+                                             state.getDelayLine (BiquadState::b1Delay)[channel],
+                                             state.getDelayLine (BiquadState::b2Delay)[channel]);
+    }
+
+    /* Ramp kernel, used while coefficients are being smoothed. */
+    void processRampChannel (float* data, int channel, int numSamples, const BiquadCoefficients& start,
+                             const BiquadCoefficients& increment, BiquadState& state) noexcept
+    {
+        BiquadKernel<float, float>::processRamp (data, numSamples, start, increment,
+                                                 state.getDelayLine (BiquadState::a1Delay)[channel],
+                                                 state.getDelayLine (BiquadState::a2Delay)[channel],
+                                                 state.getDelayLine (BiquadState::b1Delay)[channel],
+                                                 state.getDelayLine (BiquadState::b2Delay)[channel]);
+    }
+
+    /*
+        The scalar kernel for a fixed number of channels side by side. Their
+        recursions are independent, so with two channels each one's multiplies
+        fill the other's wait for its previous output.
+    */
+    template <BiquadCoefficients::Form form, int numChannels>
+    void processScalarChannels (float* const* channelData, int firstChannel, int numSamples,
+                                const BiquadCoefficients& c, BiquadState& state) noexcept
+    {
+        if constexpr (form == BiquadCoefficients::Form::stateVariable)
+        {
+            for (int i = 0; i < numChannels; i++)
+                processScalarChannel (channelData[firstChannel + i], firstChannel + i, numSamples, c, state);
+
+            return;
+        }
+
+        using Equation = BiquadEquation<form>;
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay) + firstChannel;
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay) + firstChannel;
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay) + firstChannel;
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay) + firstChannel;
+
+        float* data[numChannels];
+        float x1[numChannels], x2[numChannels], z1[numChannels], z2[numChannels];
+
+        for (int i = 0; i < numChannels; i++)
+        {
+            data[i] = channelData[firstChannel + i];
+            x1[i] = xz1[i];
+            x2[i] = xz2[i];
+            z1[i] = zz1[i];
+            z2[i] = zz2[i];
+        }
+
+        for (int n = 0; n < numSamples; n++)
+        {
+            for (int i = 0; i < numChannels; i++)
+            {
+                auto x = data[i][n];
+                auto z = Equation::getZ (x, x1[i], x2[i], z1[i], z2[i], c.a0, c.a1, c.a2, c.b1, c.b2);
+
+                x2[i] = x1[i];
+                x1[i] = x;
+                z2[i] = z1[i];
+                z1[i] = z;
+
+                data[i][n] = Equation::getOutput (z, x, c.c0, c.d0);
+            }
+        }
+
+        for (int i = 0; i < numChannels; i++)
+        {
+            xz1[i] = x1[i];
+            xz2[i] = x2[i];
+            zz1[i] = z1[i];
+            zz2[i] = z2[i];
+        }
+    }
+
+    //==============================================================================
+    /*
+        Time-parallel kernels. These run one channel at a time and produce four
+        outputs per step from BlockBiquadCoefficients. The previous block's outputs
+        only enter through the two state columns, which are added last so the rest
+        of the product doesn't wait on them.
+    */
+    void processTimeParallelScalar (float* const* channelData, int firstChannel, int numChannels, int numSamples,
+                                    const BlockBiquadCoefficients& block, BiquadState& state) noexcept
+    {
+        using Block = BlockBiquadCoefficients;
+        const auto& c = block.source;
+        const auto& m = block.columns;
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay);
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay);
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay);
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay);
+
+        for (int channel = firstChannel; channel < firstChannel + numChannels; channel++)
+        {
+            auto* data = channelData[channel];
+
+            float x1 = xz1[channel], x2 = xz2[channel];
+            float z1 = zz1[channel], z2 = zz2[channel];
+
+            int n = 0;
+
+            for (; n + Block::blockSize <= numSamples; n += Block::blockSize)
+            {
+                float z[Block::blockSize];
+
+                for (int k = 0; k < Block::blockSize; k++)
+                {
+                    float acc = m[Block::stateA1][k] * x1 + m[Block::stateA2][k] * x2;
+
+                    for (int i = 0; i < Block::blockSize; i++)
+                        acc += m[Block::input0 + i][k] * data[n + i];
+
+                    float feedback = (m[Block::stateB1][k] * z1 + m[Block::stateB2][k] * z2)
+                                   + (block.feedbackResidual[0][k] * z1 + block.feedbackResidual[1][k] * z2);
+
+                    z[k] = acc + feedback;
+                }
+
+                x1 = data[n + 3];
+                x2 = data[n + 2];
+                z1 = z[3];
+                z2 = z[2];
+
+                for (int k = 0; k < Block::blockSize; k++)
+                    data[n + k] = z[k] * c.c0 + data[n + k] * c.d0;
+            }
+
+            xz1[channel] = x1;
+            xz2[channel] = x2;
+            zz1[channel] = z1;
+            zz2[channel] = z2;
+
+            // The last few samples go through the ordinary recursion
+            processScalarChannel (data + n, channel, numSamples - n, c, state);
+        }
+    }
+
+   #if JUCE_INTEL
+    EQ1_TARGET_SSE2 void processTimeParallelSSE2 (float* const* channelData, int firstChannel, int numChannels, int numSamples,
+                                                  const BlockBiquadCoefficients& block, BiquadState& state) noexcept
+    {
+        using Block = BlockBiquadCoefficients;
+        const auto& c = block.source;
+
+        const auto mA1 = _mm_load_ps (block.columns[Block::stateA1]);
+        const auto mA2 = _mm_load_ps (block.columns[Block::stateA2]);
+        const auto mB1 = _mm_load_ps (block.columns[Block::stateB1]);
+        const auto mB2 = _mm_load_ps (block.columns[Block::stateB2]);
+        const auto rB1 = _mm_load_ps (block.feedbackResidual[0]);
+        const auto rB2 = _mm_load_ps (block.feedbackResidual[1]);
+        const auto mX0 = _mm_load_ps (block.columns[Block::input0]);
+        const auto mX1 = _mm_load_ps (block.columns[Block::input0 + 1]);
+        const auto mX2 = _mm_load_ps (block.columns[Block::input0 + 2]);
+        const auto mX3 = _mm_load_ps (block.columns[Block::input0 + 3]);
+        const auto c0 = _mm_set1_ps (c.c0);
+        const auto d0 = _mm_set1_ps (c.d0);
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay);
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay);
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay);
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay);
+
+        for (int channel = firstChannel; channel < firstChannel + numChannels; channel++)
+        {
+            auto* data = channelData[channel];
+
+            // The state is kept broadcast across all four lanes
+            auto x1 = _mm_set1_ps (xz1[channel]), x2 = _mm_set1_ps (xz2[channel]);
+            auto z1 = _mm_set1_ps (zz1[channel]), z2 = _mm_set1_ps (zz2[channel]);
+
+            int n = 0;
+
+            for (; n + Block::blockSize <= numSamples; n += Block::blockSize)
+            {
+                auto x = _mm_loadu_ps (data + n);
+
+                auto in0 = _mm_shuffle_ps (x, x, _MM_SHUFFLE (0, 0, 0, 0));
+                auto in1 = _mm_shuffle_ps (x, x, _MM_SHUFFLE (1, 1, 1, 1));
+                auto in2 = _mm_shuffle_ps (x, x, _MM_SHUFFLE (2, 2, 2, 2));
+                auto in3 = _mm_shuffle_ps (x, x, _MM_SHUFFLE (3, 3, 3, 3));
+
+                auto forward = _mm_add_ps (_mm_add_ps (_mm_mul_ps (mA1, x1), _mm_mul_ps (mA2, x2)),
+                                           _mm_add_ps (_mm_add_ps (_mm_mul_ps (mX0, in0), _mm_mul_ps (mX1, in1)),
+                                                       _mm_add_ps (_mm_mul_ps (mX2, in2), _mm_mul_ps (mX3, in3))));
+
+                auto feedback = _mm_add_ps (_mm_add_ps (_mm_mul_ps (mB1, z1), _mm_mul_ps (mB2, z2)),
+                                            _mm_add_ps (_mm_mul_ps (rB1, z1), _mm_mul_ps (rB2, z2)));
+                auto z = _mm_add_ps (forward, feedback);
+
+                x1 = in3;
+                x2 = in2;
+                z1 = _mm_shuffle_ps (z, z, _MM_SHUFFLE (3, 3, 3, 3));
+                z2 = _mm_shuffle_ps (z, z, _MM_SHUFFLE (2, 2, 2, 2));
+
+                _mm_storeu_ps (data + n, _mm_add_ps (_mm_mul_ps (z, c0), _mm_mul_ps (x, d0)));
+            }
+
+            xz1[channel] = _mm_cvtss_f32 (x1);
+            xz2[channel] = _mm_cvtss_f32 (x2);
+            zz1[channel] = _mm_cvtss_f32 (z1);
+            zz2[channel] = _mm_cvtss_f32 (z2);
+
+            // The last few samples go through the ordinary recursion
+            processScalarChannel (data + n, channel, numSamples - n, c, state);
+        }
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    void processTimeParallelNEON (float* const* channelData, int firstChannel, int numChannels, int numSamples,
+                                  const BlockBiquadCoefficients& block, BiquadState& state) noexcept
+    {
+        using Block = BlockBiquadCoefficients;
+        const auto& c = block.source;
+
+        const auto mA1 = vld1q_f32 (block.columns[Block::stateA1]);
+        const auto mA2 = vld1q_f32 (block.columns[Block::stateA2]);
+        const auto mB1 = vld1q_f32 (block.columns[Block::stateB1]);
+        const auto mB2 = vld1q_f32 (block.columns[Block::stateB2]);
+        const auto rB1 = vld1q_f32 (block.feedbackResidual[0]);
+        const auto rB2 = vld1q_f32 (block.feedbackResidual[1]);
+        const auto mX0 = vld1q_f32 (block.columns[Block::input0]);
+        const auto mX1 = vld1q_f32 (block.columns[Block::input0 + 1]);
+        const auto mX2 = vld1q_f32 (block.columns[Block::input0 + 2]);
+        const auto mX3 = vld1q_f32 (block.columns[Block::input0 + 3]);
+        const auto c0 = vdupq_n_f32 (c.c0);
+        const auto d0 = vdupq_n_f32 (c.d0);
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay);
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay);
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay);
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay);
+
+        for (int channel = firstChannel; channel < firstChannel + numChannels; channel++)
+        {
+            auto* data = channelData[channel];
+
+            auto x1 = vdupq_n_f32 (xz1[channel]), x2 = vdupq_n_f32 (xz2[channel]);
+            auto z1 = vdupq_n_f32 (zz1[channel]), z2 = vdupq_n_f32 (zz2[channel]);
+
+            int n = 0;
+
+            for (; n + Block::blockSize <= numSamples; n += Block::blockSize)
+            {
+                auto x = vld1q_f32 (data + n);
+
+                auto in0 = vdupq_n_f32 (vgetq_lane_f32 (x, 0));
+                auto in1 = vdupq_n_f32 (vgetq_lane_f32 (x, 1));
+                auto in2 = vdupq_n_f32 (vgetq_lane_f32 (x, 2));
+                auto in3 = vdupq_n_f32 (vgetq_lane_f32 (x, 3));
+
+                auto forward = vaddq_f32 (vaddq_f32 (vmulq_f32 (mA1, x1), vmulq_f32 (mA2, x2)),
+                                          vaddq_f32 (vaddq_f32 (vmulq_f32 (mX0, in0), vmulq_f32 (mX1, in1)),
+                                                     vaddq_f32 (vmulq_f32 (mX2, in2), vmulq_f32 (mX3, in3))));
+
+                auto feedback = vaddq_f32 (vaddq_f32 (vmulq_f32 (mB1, z1), vmulq_f32 (mB2, z2)),
+                                           vaddq_f32 (vmulq_f32 (rB1, z1), vmulq_f32 (rB2, z2)));
+                auto z = vaddq_f32 (forward, feedback);
+
+                x1 = in3;
+                x2 = in2;
+                z1 = vdupq_n_f32 (vgetq_lane_f32 (z, 3));
+                z2 = vdupq_n_f32 (vgetq_lane_f32 (z, 2));
+
+                vst1q_f32 (data + n, vaddq_f32 (vmulq_f32 (z, c0), vmulq_f32 (x, d0)));
+            }
+
+            xz1[channel] = vgetq_lane_f32 (x1, 0);
+            xz2[channel] = vgetq_lane_f32 (x2, 0);
+            zz1[channel] = vgetq_lane_f32 (z1, 0);
+            zz2[channel] = vgetq_lane_f32 (z2, 0);
+
+            processScalarChannel (data + n, channel, numSamples - n, c, state);
+        }
+    }
+   #endif
+
+   #if JUCE_INTEL
+    //==============================================================================
+    /*
+        SSE2 kernel for a group of four channels. Samples are loaded four at a time
+        from each channel and transposed, so each register holds one sample instant
+        across the four channels.
+    */
+    template <BiquadCoefficients::Form form>
+    EQ1_TARGET_SSE2 void processSSE2Group (float* const* channelData, int firstChannel, int numSamples,
+                                           const BiquadCoefficients& coefficients, BiquadState& state) noexcept
+    {
+        using Coefficients = std::conditional_t<form == BiquadCoefficients::Form::stateVariable,
+                                                SSE2StateVariableCoefficients, SSE2Coefficients>;
+        const Coefficients c (coefficients);
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay) + firstChannel;
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay) + firstChannel;
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay) + firstChannel;
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay) + firstChannel;
+
+        auto x1 = _mm_load_ps (xz1), x2 = _mm_load_ps (xz2);
+        auto z1 = _mm_load_ps (zz1), z2 = _mm_load_ps (zz2);
+
+        float* ch[4] = { channelData[firstChannel],     channelData[firstChannel + 1],
+                         channelData[firstChannel + 2], channelData[firstChannel + 3] };
+
+        int n = 0;
+
+        for (; n + 4 <= numSamples; n += 4)
+        {
+            auto r0 = _mm_loadu_ps (ch[0] + n);
+            auto r1 = _mm_loadu_ps (ch[1] + n);
+            auto r2 = _mm_loadu_ps (ch[2] + n);
+            auto r3 = _mm_loadu_ps (ch[3] + n);
+
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+            r0 = stepSSE2<form> (r0, c, x1, x2, z1, z2);
+            r1 = stepSSE2<form> (r1, c, x1, x2, z1, z2);
+            r2 = stepSSE2<form> (r2, c, x1, x2, z1, z2);
+            r3 = stepSSE2<form> (r3, c, x1, x2, z1, z2);
+
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+            _mm_storeu_ps (ch[0] + n, r0);
+            _mm_storeu_ps (ch[1] + n, r1);
+            _mm_storeu_ps (ch[2] + n, r2);
+            _mm_storeu_ps (ch[3] + n, r3);
+        }
+
+        for (; n < numSamples; n++)
+        {
+            alignas (16) float lanes[4];
+            auto y = stepSSE2<form> (_mm_setr_ps (ch[0][n], ch[1][n], ch[2][n], ch[3][n]), c, x1, x2, z1, z2);
+            _mm_store_ps (lanes, y);
+
+            for (int i = 0; i < 4; i++)
+                ch[i][n] = lanes[i];
+        }
+
+        _mm_store_ps (xz1, x1);
+        _mm_store_ps (xz2, x2);
+        _mm_store_ps (zz1, z1);
+        _mm_store_ps (zz2, z2);
+    }
+
+    //==============================================================================
+    /*
+        AVX2 kernel for a group of eight channels, using an 8x8 transpose.
+    */
+    struct AVX2Coefficients
+    {
+        EQ1_TARGET_AVX2 explicit AVX2Coefficients (const BiquadCoefficients& c) noexcept
+            : a0 (_mm256_set1_ps (c.a0)), a1 (_mm256_set1_ps (c.a1)), a2 (_mm256_set1_ps (c.a2)),
+              b1 (_mm256_set1_ps (c.b1)), b2 (_mm256_set1_ps (c.b2)),
+              c0 (_mm256_set1_ps (c.c0)), d0 (_mm256_set1_ps (c.d0)) {}
+
+        __m256 a0, a1, a2, b1, b2, c0, d0;
+    };
+
+    template <BiquadCoefficients::Form form>
+    EQ1_TARGET_AVX2 inline __m256 stepAVX2 (__m256 x, const AVX2Coefficients& c,
+                                            __m256& x1, __m256& x2, __m256& z1, __m256& z2) noexcept
+    {
+        using Form = BiquadCoefficients::Form;
+        __m256 z;
+
+        if constexpr (form == Form::general || form == Form::shelf)
+        {
+            auto feedback = _mm256_sub_ps (_mm256_sub_ps (_mm256_add_ps (_mm256_mul_ps (c.a1, x1), _mm256_mul_ps (c.a2, x2)),
+                                                          _mm256_mul_ps (c.b1, z1)),
+                                           _mm256_mul_ps (c.b2, z2));
+            z = _mm256_add_ps (_mm256_mul_ps (c.a0, x), feedback);
+        }
+        else
+        {
+            __m256 forward;
+
+            if constexpr (form == Form::peak)
+                forward = _mm256_sub_ps (x, x2);
+            else if constexpr (form == Form::highPass)
+                forward = _mm256_sub_ps (_mm256_add_ps (x, x2), _mm256_add_ps (x1, x1));
+            else
+                forward = _mm256_add_ps (_mm256_add_ps (x, x2), _mm256_add_ps (x1, x1));
+
+            z = _mm256_sub_ps (_mm256_mul_ps (c.a0, forward), _mm256_add_ps (_mm256_mul_ps (c.b1, z1), _mm256_mul_ps (c.b2, z2)));
+        }
+
+        x2 = x1;
+        x1 = x;
+        z2 = z1;
+        z1 = z;
+
+        if constexpr (form == Form::general)
+            return _mm256_add_ps (_mm256_mul_ps (z, c.c0), _mm256_mul_ps (x, c.d0));
+        else if constexpr (form == Form::peak)
+            return _mm256_add_ps (x, _mm256_mul_ps (z, c.c0));
+        else
+            return z;
+    }
+
+    struct AVX2StateVariableCoefficients
+    {
+        EQ1_TARGET_AVX2 explicit AVX2StateVariableCoefficients (const BiquadCoefficients& c) noexcept
+            : outputX (_mm256_set1_ps (c.stateVariable.outputX)), outputV1 (_mm256_set1_ps (c.stateVariable.outputV1)),
+              outputV2 (_mm256_set1_ps (c.stateVariable.outputV2))
+        {
+            float s1, s2, s3;
+            StateVariableEquation::getCoefficients (c.stateVariable.g, c.stateVariable.k, s1, s2, s3);
+
+            a1 = _mm256_set1_ps (s1);
+            a2 = _mm256_set1_ps (s2);
+            a3 = _mm256_set1_ps (s3);
+        }
+
+        __m256 a1, a2, a3, outputX, outputV1, outputV2;
+    };
+
+    template <BiquadCoefficients::Form form>
+    EQ1_TARGET_AVX2 inline __m256 stepAVX2 (__m256 x, const AVX2StateVariableCoefficients& c,
+                                            __m256& ic1, __m256& ic2, __m256&, __m256&) noexcept
+    {
+        static_assert (form == BiquadCoefficients::Form::stateVariable);
+
+        auto v3 = _mm256_sub_ps (x, ic2);
+        auto v1 = _mm256_add_ps (_mm256_mul_ps (c.a1, ic1), _mm256_mul_ps (c.a2, v3));
+        auto v2 = _mm256_add_ps (_mm256_add_ps (ic2, _mm256_mul_ps (c.a2, ic1)), _mm256_mul_ps (c.a3, v3));
+
+        ic1 = _mm256_sub_ps (_mm256_add_ps (v1, v1), ic1);
+        ic2 = _mm256_sub_ps (_mm256_add_ps (v2, v2), ic2);
+
+        return _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (c.outputX, x), _mm256_mul_ps (c.outputV1, v1)),
+                              _mm256_mul_ps (c.outputV2, v2));
+    }
+
+    EQ1_TARGET_AVX2 inline void transpose8x8 (__m256* r) noexcept
+    {
+        auto t0 = _mm256_unpacklo_ps (r[0], r[1]);
+        auto t1 = _mm256_unpackhi_ps (r[0], r[1]);
+        auto t2 = _mm256_unpacklo_ps (r[2], r[3]);
+        auto t3 = _mm256_unpackhi_ps (r[2], r[3]);
+        auto t4 = _mm256_unpacklo_ps (r[4], r[5]);
+        auto t5 = _mm256_unpackhi_ps (r[4], r[5]);
+        auto t6 = _mm256_unpacklo_ps (r[6], r[7]);
+        auto t7 = _mm256_unpackhi_ps (r[6], r[7]);
+
+        auto s0 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (1, 0, 1, 0));
+        auto s1 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (3, 2, 3, 2));
+        auto s2 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (1, 0, 1, 0));
+        auto s3 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (3, 2, 3, 2));
+        auto s4 = _mm256_shuffle_ps (t4, t6, _MM_SHUFFLE (1, 0, 1, 0));
+        auto s5 = _mm256_shuffle_ps (t4, t6, _MM_SHUFFLE (3, 2, 3, 2));
+        auto s6 = _mm256_shuffle_ps (t5, t7, _MM_SHUFFLE (1, 0, 1, 0));
+        auto s7 = _mm256_shuffle_ps (t5, t7, _MM_SHUFFLE (3, 2, 3, 2));
+
+        r[0] = _mm256_permute2f128_ps (s0, s4, 0x20);
+        r[1] = _mm256_permute2f128_ps (s1, s5, 0x20);
+        r[2] = _mm256_permute2f128_ps (s2, s6, 0x20);
+        r[3] = _mm256_permute2f128_ps (s3, s7, 0x20);
+        r[4] = _mm256_permute2f128_ps (s0, s4, 0x31);
+        r[5] = _mm256_permute2f128_ps (s1, s5, 0x31);
+        r[6] = _mm256_permute2f128_ps (s2, s6, 0x31);
+        r[7] = _mm256_permute2f128_ps (s3, s7, 0x31);
+    }
+
+    template <BiquadCoefficients::Form form>
+    EQ1_TARGET_AVX2 void processAVX2Group (float* const* channelData, int firstChannel, int numSamples,
+                                           const BiquadCoefficients& coefficients, BiquadState& state) noexcept
+    {
+        using Coefficients = std::conditional_t<form == BiquadCoefficients::Form::stateVariable,
+                                                AVX2StateVariableCoefficients, AVX2Coefficients>;
+        const Coefficients c (coefficients);
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay) + firstChannel;
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay) + firstChannel;
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay) + firstChannel;
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay) + firstChannel;
+
+        auto x1 = _mm256_load_ps (xz1), x2 = _mm256_load_ps (xz2);
+        auto z1 = _mm256_load_ps (zz1), z2 = _mm256_load_ps (zz2);
+
+        float* ch[8];
+
+        for (int i = 0; i < 8; i++)
+            ch[i] = channelData[firstChannel + i];
+
+        int n = 0;
+
+        for (; n + 8 <= numSamples; n += 8)
+        {
+            __m256 r[8];
+
+            for (int i = 0; i < 8; i++)
+                r[i] = _mm256_loadu_ps (ch[i] + n);
+
+            transpose8x8 (r);
+
+            for (int i = 0; i < 8; i++)
+                r[i] = stepAVX2<form> (r[i], c, x1, x2, z1, z2);
+
+            transpose8x8 (r);
+
+            for (int i = 0; i < 8; i++)
+                _mm256_storeu_ps (ch[i] + n, r[i]);
+        }
+
+        for (; n < numSamples; n++)
+        {
+            alignas (32) float lanes[8];
+
+            for (int i = 0; i < 8; i++)
+                lanes[i] = ch[i][n];
+
+            _mm256_store_ps (lanes, stepAVX2<form> (_mm256_load_ps (lanes), c, x1, x2, z1, z2));
+
+            for (int i = 0; i < 8; i++)
+                ch[i][n] = lanes[i];
+        }
+
+        _mm256_store_ps (xz1, x1);
+        _mm256_store_ps (xz2, x2);
+        _mm256_store_ps (zz1, z1);
+        _mm256_store_ps (zz2, z2);
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    //==============================================================================
+    /*
+        NEON kernel for a group of four channels.
+    */
+    inline void transpose4x4 (float32x4_t& r0, float32x4_t& r1, float32x4_t& r2, float32x4_t& r3) noexcept
+    {
+        auto t01 = vtrnq_f32 (r0, r1);
+        auto t23 = vtrnq_f32 (r2, r3);
+
+        r0 = vcombine_f32 (vget_low_f32  (t01.val[0]), vget_low_f32  (t23.val[0]));
+        r1 = vcombine_f32 (vget_low_f32  (t01.val[1]), vget_low_f32  (t23.val[1]));
+        r2 = vcombine_f32 (vget_high_f32 (t01.val[0]), vget_high_f32 (t23.val[0]));
+        r3 = vcombine_f32 (vget_high_f32 (t01.val[1]), vget_high_f32 (t23.val[1]));
+    }
+
+    template <BiquadCoefficients::Form form>
+    void processNEONGroup (float* const* channelData, int firstChannel, int numSamples,
+                           const BiquadCoefficients& coefficients, BiquadState& state) noexcept
+    {
+        using Coefficients = std::conditional_t<form == BiquadCoefficients::Form::stateVariable,
+                                                NEONStateVariableCoefficients, NEONCoefficients>;
+        const Coefficients c (coefficients);
+
+        auto* xz1 = state.getDelayLine (BiquadState::a1Delay) + firstChannel;
+        auto* xz2 = state.getDelayLine (BiquadState::a2Delay) + firstChannel;
+        auto* zz1 = state.getDelayLine (BiquadState::b1Delay) + firstChannel;
+        auto* zz2 = state.getDelayLine (BiquadState::b2Delay) + firstChannel;
+
+        auto x1 = vld1q_f32 (xz1), x2 = vld1q_f32 (xz2);
+        auto z1 = vld1q_f32 (zz1), z2 = vld1q_f32 (zz2);
+
+        float* ch[4] = { channelData[firstChannel],     channelData[firstChannel + 1],
+                         channelData[firstChannel + 2], channelData[firstChannel + 3] };
+
+        int n = 0;
+
+        for (; n + 4 <= numSamples; n += 4)
+        {
+            auto r0 = vld1q_f32 (ch[0] + n);
+            auto r1 = vld1q_f32 (ch[1] + n);
+            auto r2 = vld1q_f32 (ch[2] + n);
+            auto r3 = vld1q_f32 (ch[3] + n);
+
+            transpose4x4 (r0, r1, r2, r3);
+
+            r0 = stepNEON<form> (r0, c, x1, x2, z1, z2);
+            r1 = stepNEON<form> (r1, c, x1, x2, z1, z2);
+            r2 = stepNEON<form> (r2, c, x1, x2, z1, z2);
+            r3 = stepNEON<form> (r3, c, x1, x2, z1, z2);
+
+            transpose4x4 (r0, r1, r2, r3);
+
+            vst1q_f32 (ch[0] + n, r0);
+            vst1q_f32 (ch[1] + n, r1);
+            vst1q_f32 (ch[2] + n, r2);
+            vst1q_f32 (ch[3] + n, r3);
+        }
+
+        for (; n < numSamples; n++)
+        {
+            float lanes[4] = { ch[0][n], ch[1][n], ch[2][n], ch[3][n] };
+            vst1q_f32 (lanes, stepNEON<form> (vld1q_f32 (lanes), c, x1, x2, z1, z2));
+
+            for (int i = 0; i < 4; i++)
+                ch[i][n] = lanes[i];
+        }
+
+        vst1q_f32 (xz1, x1);
+        vst1q_f32 (xz2, x2);
+        vst1q_f32 (zz1, z1);
+        vst1q_f32 (zz2, z2);
+    }
+   #endif
+
+    //==============================================================================
+    /*
+        The channel-parallel path for one kernel and form. With a fixed channel count
+        (1, 2 or 8) the group loops are resolved at compile time; 0 takes the count
+        at runtime. Kernels the platform doesn't have fall through to the scalar code.
+    */
+    template <BiquadEngine::Kernel kernel, BiquadCoefficients::Form form, int fixedChannels>
+    void processChannels (float* const* channelData, int numChannels, int numSamples,
+                          const BiquadCoefficients& c, BiquadState& state) noexcept
+    {
+        const auto count = fixedChannels > 0 ? fixedChannels : numChannels;
+
+        // Mono and stereo don't fill a register, and run side by side in scalar code
+        if constexpr (fixedChannels == 1 || fixedChannels == 2)
+        {
+            processScalarChannels<form, fixedChannels> (channelData, 0, numSamples, c, state);
+            return;
+        }
+
+        int channel = 0;
+
+       #if JUCE_INTEL
+        if constexpr (kernel == BiquadEngine::Kernel::avx2)
+            for (; channel + 8 <= count; channel += 8)
+                processAVX2Group<form> (channelData, channel, numSamples, c, state);
+
+        if constexpr (kernel == BiquadEngine::Kernel::avx2 || kernel == BiquadEngine::Kernel::sse2)
+            for (; channel + 4 <= count; channel += 4)
+                processSSE2Group<form> (channelData, channel, numSamples, c, state);
+       #endif
+
+       #if EQ1_HAS_NEON
+        if constexpr (kernel == BiquadEngine::Kernel::neon)
+            for (; channel + 4 <= count; channel += 4)
+                processNEONGroup<form> (channelData, channel, numSamples, c, state);
+       #endif
+
+        for (; channel < count; channel++)
+            processScalarChannels<form, 1> (channelData, channel, numSamples, c, state);
+    }
+
+    using ChannelFunction = void (*) (float* const*, int, int, const BiquadCoefficients&, BiquadState&) noexcept;
+
+    // The channel counts with an instance of their own; the last entry is any other count
+    constexpr int fixedChannelCounts[] = { 1, 2, 8, 0 };
+    constexpr int numLayouts = (int) std::size (fixedChannelCounts);
+    constexpr int numKernels = (int) BiquadEngine::Kernel::neon + 1;
+
+    using LayoutFunctions = std::array<ChannelFunction, numLayouts>;
+    using FormFunctions = std::array<LayoutFunctions, BiquadCoefficients::numForms>;
+
+    int getLayoutIndex (int numChannels) noexcept
+    {
+        for (int i = 0; i < numLayouts - 1; i++)
+            if (fixedChannelCounts[i] == numChannels)
+                return i;
+
+        return numLayouts - 1;
+    }
+
+    template <BiquadEngine::Kernel kernel, BiquadCoefficients::Form form, size_t... layouts>
+    constexpr LayoutFunctions getLayoutFunctions (std::index_sequence<layouts...>) noexcept
+    {
+        return { { &processChannels<kernel, form, fixedChannelCounts[layouts]>... } };
+    }
+
+    template <BiquadEngine::Kernel kernel, size_t... forms>
+    constexpr FormFunctions getFormFunctions (std::index_sequence<forms...>) noexcept
+    {
+        return { { getLayoutFunctions<kernel, (BiquadCoefficients::Form) forms> (std::make_index_sequence<numLayouts>())... } };
+    }
+
+    template <size_t... kernels>
+    constexpr std::array<FormFunctions, sizeof... (kernels)> getDispatchTable (std::index_sequence<kernels...>) noexcept
+    {
+        return { { getFormFunctions<(BiquadEngine::Kernel) kernels> (std::make_index_sequence<BiquadCoefficients::numForms>())... } };
+    }
+
+    // Every instance, indexed by kernel, form and layout
+    constexpr auto dispatchTable = getDispatchTable (std::make_index_sequence<numKernels>());
+}
+
+//==============================================================================
+BiquadEngine::BiquadEngine()
+    : kernel (getBestAvailableKernel())
+{
+}
+
+void BiquadEngine::prepare (int maxNumChannels)
+{
+    state.prepare (maxNumChannels);
+}
+
+void BiquadEngine::reset() noexcept
+{
+    state.reset();
+}
+
+void BiquadEngine::processRamp (float* const* channelData, int numChannels, int numSamples,
+                                const BiquadCoefficients& start, const BiquadCoefficients& increment) noexcept
+{
+    jassert (numChannels <= state.getNumChannels());
+    numChannels = juce::jmin (numChannels, state.getNumChannels());
+
+    for (int channel = 0; channel < numChannels; channel++)
+        processRampChannel (channelData[channel], channel, numSamples, start, increment, state);
+}
+
+void BiquadEngine::setKernel (Kernel newKernel) noexcept
+{
+    jassert (isKernelAvailable (newKernel));
+    kernel = isKernelAvailable (newKernel) ? newKernel : Kernel::scalar;
+}
+
+void BiquadEngine::process (float* const* channelData, int numChannels, int numSamples,
+                            const BiquadCoefficients& coefficients) noexcept
+{
+    jassert (numChannels <= state.getNumChannels());
+    numChannels = juce::jmin (numChannels, state.getNumChannels());
+
+    const auto& functions = dispatchTable[(size_t) kernel][(size_t) coefficients.getForm()];
+
+    // Whatever doesn't fill a register (mono, stereo, odd surround layouts) is vectorised along time instead
+    auto numGrouped = kernel == Kernel::scalar ? 0 : (numChannels & ~3);
+
+    // The block form is derived from the difference equation, so a state-variable section stays channel-parallel
+    auto isStateVariable = coefficients.topology == BiquadCoefficients::Topology::stateVariable;
+
+    if (mode == Mode::timeParallel && numGrouped < numChannels && ! isStateVariable)
+    {
+        if (numGrouped > 0)
+            functions[(size_t) getLayoutIndex (numGrouped)] (channelData, numGrouped, numSamples, coefficients, state);
+
+        if (std::memcmp (&blockCoefficients.source, &coefficients, sizeof (BiquadCoefficients)) != 0)
+            blockCoefficients.design (coefficients);
+
+       #if JUCE_INTEL
+        if (kernel != Kernel::scalar)
+            return processTimeParallelSSE2 (channelData, numGrouped, numChannels - numGrouped, numSamples, blockCoefficients, state);
+       #endif
+
+       #if EQ1_HAS_NEON
+        if (kernel == Kernel::neon)
+            return processTimeParallelNEON (channelData, numGrouped, numChannels - numGrouped, numSamples, blockCoefficients, state);
+       #endif
+
+        return processTimeParallelScalar (channelData, numGrouped, numChannels - numGrouped, numSamples, blockCoefficients, state);
+    }
+
+    functions[(size_t) getLayoutIndex (numChannels)] (channelData, numChannels, numSamples, coefficients, state);
+}
+
+//==============================================================================
+bool BiquadEngine::isKernelAvailable (Kernel k) noexcept
+{
+    switch (k)
+    {
+        case Kernel::scalar:    return true;
+       #if JUCE_INTEL
+        case Kernel::sse2:      return juce::SystemStats::hasSSE2();
+        case Kernel::avx2:      return juce::SystemStats::hasAVX2();
+       #endif
+       #if EQ1_HAS_NEON
+        case Kernel::neon:      return juce::SystemStats::hasNeon();
+       #endif
+        default:                break;
+    }
+
+    return false;
+}
+
+BiquadEngine::Kernel BiquadEngine::getBestAvailableKernel() noexcept
+{
+    for (auto k : { Kernel::avx2, Kernel::neon, Kernel::sse2 })
+        if (isKernelAvailable (k))
+            return k;
+
+    return Kernel::scalar;
+}
+
+const char* BiquadEngine::getKernelName (Kernel k) noexcept
+{
+    switch (k)
+    {
+        case Kernel::scalar:    return "scalar";
+        case Kernel::sse2:      return "sse2";
+        case Kernel::avx2:      return "avx2";
+        case Kernel::neon:      return "neon";
+        default:                break;
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,248 @@
+/*
+  ==============================================================================
+
+    BiquadSIMD.h
+
+    Intrinsics headers, per-function target attributes and the vector form of
+    one step of the difference equation for each BiquadCoefficients::Form, and
+    of the state-variable filter, shared by the DSP kernels. Only include this
+    from .cpp files: kernels that use a wider instruction set than the build
+    baseline are compiled with a target attribute and only called after a
+    runtime CPU check.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+
+ #if JUCE_GCC || JUCE_CLANG
+  #define EQ1_TARGET_SSE2 __attribute__ ((target ("sse2")))
+  #define EQ1_TARGET_AVX2 __attribute__ ((target ("avx2")))
+ #else
+  #define EQ1_TARGET_SSE2
+  #define EQ1_TARGET_AVX2
+ #endif
+#endif
+
+#if JUCE_ARM && (defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define EQ1_HAS_NEON 1
+#else
+ #define EQ1_HAS_NEON 0
+#endif
+
+namespace BiquadSIMD
+{
+    /** Coefficients of four different sections, one per lane. */
+    struct LaneCoefficients
+    {
+        alignas (16) float a0[4], a1[4], a2[4], b1[4], b2[4], c0[4], d0[4];
+    };
+
+   #if JUCE_INTEL
+    /*
+        Each step sums the terms in the same order as BiquadEquation, so every lane
+        produces exactly the scalar result.
+    */
+    struct SSE2Coefficients
+    {
+        // Uninitialised, for arrays filled in later
+        SSE2Coefficients() noexcept = default;
+
+        EQ1_TARGET_SSE2 explicit SSE2Coefficients (const BiquadCoefficients& c) noexcept
+            : a0 (_mm_set1_ps (c.a0)), a1 (_mm_set1_ps (c.a1)), a2 (_mm_set1_ps (c.a2)),
+              b1 (_mm_set1_ps (c.b1)), b2 (_mm_set1_ps (c.b2)),
+              c0 (_mm_set1_ps (c.c0)), d0 (_mm_set1_ps (c.d0)) {}
+
+        EQ1_TARGET_SSE2 explicit SSE2Coefficients (const LaneCoefficients& c) noexcept
+            : a0 (_mm_load_ps (c.a0)), a1 (_mm_load_ps (c.a1)), a2 (_mm_load_ps (c.a2)),
+              b1 (_mm_load_ps (c.b1)), b2 (_mm_load_ps (c.b2)),
+              c0 (_mm_load_ps (c.c0)), d0 (_mm_load_ps (c.d0)) {}
+
+        __m128 a0, a1, a2, b1, b2, c0, d0;
+    };
+
+    template <BiquadCoefficients::Form form = BiquadCoefficients::Form::general>
+    EQ1_TARGET_SSE2 inline __m128 stepSSE2 (__m128 x, const SSE2Coefficients& c,
+                                            __m128& x1, __m128& x2, __m128& z1, __m128& z2) noexcept
+    {
+        using Form = BiquadCoefficients::Form;
+        __m128 z;
+
+        if constexpr (form == Form::general || form == Form::shelf)
+        {
+            auto feedback = _mm_sub_ps (_mm_sub_ps (_mm_add_ps (_mm_mul_ps (c.a1, x1), _mm_mul_ps (c.a2, x2)),
+                                                    _mm_mul_ps (c.b1, z1)),
+                                        _mm_mul_ps (c.b2, z2));
+            z = _mm_add_ps (_mm_mul_ps (c.a0, x), feedback);
+        }
+        else
+        {
+            __m128 forward;
+
+            if constexpr (form == Form::peak)
+                forward = _mm_sub_ps (x, x2);
+            else if constexpr (form == Form::highPass)
+                forward = _mm_sub_ps (_mm_add_ps (x, x2), _mm_add_ps (x1, x1));
+            else
+                forward = _mm_add_ps (_mm_add_ps (x, x2), _mm_add_ps (x1, x1));
+
+            z = _mm_sub_ps (_mm_mul_ps (c.a0, forward), _mm_add_ps (_mm_mul_ps (c.b1, z1), _mm_mul_ps (c.b2, z2)));
+        }
+
+        x2 = x1;
+        x1 = x;
+        z2 = z1;
+        z1 = z;
+
+        if constexpr (form == Form::general)
+            return _mm_add_ps (_mm_mul_ps (z, c.c0), _mm_mul_ps (x, c.d0));
+        else if constexpr (form == Form::peak)
+            return _mm_add_ps (x, _mm_mul_ps (z, c.c0));
+        else
+            return z;
+    }
+
+    /* a1 .. a3 are computed in float first, as the scalar kernel does. */
+    struct SSE2StateVariableCoefficients
+    {
+        SSE2StateVariableCoefficients() noexcept = default;
+
+        EQ1_TARGET_SSE2 explicit SSE2StateVariableCoefficients (const BiquadCoefficients& c) noexcept
+            : outputX (_mm_set1_ps (c.stateVariable.outputX)), outputV1 (_mm_set1_ps (c.stateVariable.outputV1)),
+              outputV2 (_mm_set1_ps (c.stateVariable.outputV2))
+        {
+            float s1, s2, s3;
+            StateVariableEquation::getCoefficients (c.stateVariable.g, c.stateVariable.k, s1, s2, s3);
+
+            a1 = _mm_set1_ps (s1);
+            a2 = _mm_set1_ps (s2);
+            a3 = _mm_set1_ps (s3);
+        }
+
+        __m128 a1, a2, a3, outputX, outputV1, outputV2;
+    };
+
+    /* The state-variable step, with ic1eq and ic2eq in x1 and x2; z1 and z2 are left alone. */
+    template <BiquadCoefficients::Form form>
+    EQ1_TARGET_SSE2 inline __m128 stepSSE2 (__m128 x, const SSE2StateVariableCoefficients& c,
+                                            __m128& ic1, __m128& ic2, __m128&, __m128&) noexcept
+    {
+        static_assert (form == BiquadCoefficients::Form::stateVariable);
+
+        auto v3 = _mm_sub_ps (x, ic2);
+        auto v1 = _mm_add_ps (_mm_mul_ps (c.a1, ic1), _mm_mul_ps (c.a2, v3));
+        auto v2 = _mm_add_ps (_mm_add_ps (ic2, _mm_mul_ps (c.a2, ic1)), _mm_mul_ps (c.a3, v3));
+
+        ic1 = _mm_sub_ps (_mm_add_ps (v1, v1), ic1);
+        ic2 = _mm_sub_ps (_mm_add_ps (v2, v2), ic2);
+
+        return _mm_add_ps (_mm_add_ps (_mm_mul_ps (c.outputX, x), _mm_mul_ps (c.outputV1, v1)),
+                           _mm_mul_ps (c.outputV2, v2));
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    struct NEONCoefficients
+    {
+        NEONCoefficients() noexcept = default;
+
+        explicit NEONCoefficients (const BiquadCoefficients& c) noexcept
+            : a0 (vdupq_n_f32 (c.a0)), a1 (vdupq_n_f32 (c.a1)), a2 (vdupq_n_f32 (c.a2)),
+              b1 (vdupq_n_f32 (c.b1)), b2 (vdupq_n_f32 (c.b2)),
+              c0 (vdupq_n_f32 (c.c0)), d0 (vdupq_n_f32 (c.d0)) {}
+
+        explicit NEONCoefficients (const LaneCoefficients& c) noexcept
+            : a0 (vld1q_f32 (c.a0)), a1 (vld1q_f32 (c.a1)), a2 (vld1q_f32 (c.a2)),
+              b1 (vld1q_f32 (c.b1)), b2 (vld1q_f32 (c.b2)),
+              c0 (vld1q_f32 (c.c0)), d0 (vld1q_f32 (c.d0)) {}
+
+        float32x4_t a0, a1, a2, b1, b2, c0, d0;
+    };
+
+    template <BiquadCoefficients::Form form = BiquadCoefficients::Form::general>
+    inline float32x4_t stepNEON (float32x4_t x, const NEONCoefficients& c,
+                                 float32x4_t& x1, float32x4_t& x2, float32x4_t& z1, float32x4_t& z2) noexcept
+    {
+        using Form = BiquadCoefficients::Form;
+        float32x4_t z;
+
+        if constexpr (form == Form::general || form == Form::shelf)
+        {
+            auto feedback = vsubq_f32 (vsubq_f32 (vaddq_f32 (vmulq_f32 (c.a1, x1), vmulq_f32 (c.a2, x2)),
+                                                  vmulq_f32 (c.b1, z1)),
+                                       vmulq_f32 (c.b2, z2));
+            z = vaddq_f32 (vmulq_f32 (c.a0, x), feedback);
+        }
+        else
+        {
+            float32x4_t forward;
+
+            if constexpr (form == Form::peak)
+                forward = vsubq_f32 (x, x2);
+            else if constexpr (form == Form::highPass)
+                forward = vsubq_f32 (vaddq_f32 (x, x2), vaddq_f32 (x1, x1));
+            else
+                forward = vaddq_f32 (vaddq_f32 (x, x2), vaddq_f32 (x1, x1));
+
+            z = vsubq_f32 (vmulq_f32 (c.a0, forward), vaddq_f32 (vmulq_f32 (c.b1, z1), vmulq_f32 (c.b2, z2)));
+        }
+
+        x2 = x1;
+        x1 = x;
+        z2 = z1;
+        z1 = z;
+
+        if constexpr (form == Form::general)
+            return vaddq_f32 (vmulq_f32 (z, c.c0), vmulq_f32 (x, c.d0));
+        else if constexpr (form == Form::peak)
+            return vaddq_f32 (x, vmulq_f32 (z, c.c0));
+        else
+            return z;
+    }
+
+    struct NEONStateVariableCoefficients
+    {
+        NEONStateVariableCoefficients() noexcept = default;
+
+        explicit NEONStateVariableCoefficients (const BiquadCoefficients& c) noexcept
+            : outputX (vdupq_n_f32 (c.stateVariable.outputX)), outputV1 (vdupq_n_f32 (c.stateVariable.outputV1)),
+              outputV2 (vdupq_n_f32 (c.stateVariable.outputV2))
+        {
+            float s1, s2, s3;
+            StateVariableEquation::getCoefficients (c.stateVariable.g, c.stateVariable.k, s1, s2, s3);
+
+            a1 = vdupq_n_f32 (s1);
+            a2 = vdupq_n_f32 (s2);
+            a3 = vdupq_n_f32 (s3);
+        }
+
+        float32x4_t a1, a2, a3, outputX, outputV1, outputV2;
+    };
+
+    template <BiquadCoefficients::Form form>
+    inline float32x4_t stepNEON (float32x4_t x, const NEONStateVariableCoefficients& c,
+                                 float32x4_t& ic1, float32x4_t& ic2, float32x4_t&, float32x4_t&) noexcept
+    {
+        static_assert (form == BiquadCoefficients::Form::stateVariable);
+
+        auto v3 = vsubq_f32 (x, ic2);
+        auto v1 = vaddq_f32 (vmulq_f32 (c.a1, ic1), vmulq_f32 (c.a2, v3));
+        auto v2 = vaddq_f32 (vaddq_f32 (ic2, vmulq_f32 (c.a2, ic1)), vmulq_f32 (c.a3, v3));
+
+        ic1 = vsubq_f32 (vaddq_f32 (v1, v1), ic1);
+        ic2 = vsubq_f32 (vaddq_f32 (v2, v2), ic2);
+
+        return vaddq_f32 (vaddq_f32 (vmulq_f32 (c.outputX, x), vmulq_f32 (c.outputV1, v1)),
+                          vmulq_f32 (c.outputV2, v2));
+    }
+   #endif
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    CascadeDesigner.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "CascadeDesigner.h"
+
+//==============================================================================
+void CascadeDesigner::prepare (double sampleRate)
+{
+    table = FilterDesign::FrequencyTable::getFor (sampleRate);
+
+    // Zero sections marks every band as not designed yet
+    std::fill (std::begin (numSections), std::end (numSections), 0);
+}
+
+void CascadeDesigner::setNoiseTarget (double newNoiseTarget) noexcept
+{
+    noiseTarget = newNoiseTarget;
+    std::fill (std::begin (numSections), std::end (numSections), 0);
+}
+
+void CascadeDesigner::design (const Bands& bands, CascadeCoefficients& coefficients) noexcept
+{
+    jassert (table != nullptr);
+
+    coefficients.clear();
+
+    for (int band = 0; band < FilterDesign::maxBands; band++)
+    {
+        const auto& settings = bands[(size_t) band];
+
+        // Only redesign the bands that actually changed
+        if (settings != designedBands[(size_t) band] || numSections[band] == 0)
+        {
+            designedBands[(size_t) band] = settings;
+            numSections[band] = FilterDesign::designBand (settings, *table, sections[band], noiseTarget);
+        }
+
+        // Disabled bands add no sections, so they cost nothing in processBlock; dynamic ones are run by DynamicEQ
+        if (! settings.enabled || settings.isDynamic())
+            continue;
+
+        for (int i = 0; i < numSections[band]; i++)
+            coefficients.add (band * FilterDesign::maxSectionsPerBand + i, sections[band][i]);
+    }
+}
+
+//==============================================================================
+bool CascadeDesigner::haveSameTopology (const Bands& a, const Bands& b) noexcept
+{
+    for (size_t band = 0; band < a.size(); band++)
+    {
+        if (a[band].enabled != b[band].enabled || a[band].isDynamic() != b[band].isDynamic())
+            return false;
+
+        // The type and slope of a disabled band don't matter
+        if (a[band].enabled && (a[band].type != b[band].type || a[band].slope != b[band].slope))
+            return false;
+    }
+
+    return true;
+}
+
+void CascadeDesigner::interpolate (const Bands& start, const Bands& end, float proportion, Bands& result) noexcept
+{
+    for (size_t band = 0; band < start.size(); band++)
+    {
+        const auto& from = start[band];
+        const auto& to = end[band];
+        auto& settings = result[band];
+
+        settings = to;
+
+        if (from.frequency != to.frequency)
+            settings.frequency = juce::roundToInt (from.frequency * std::pow ((float) to.frequency / (float) from.frequency, proportion));
+
+        if (from.q != to.q)
+            settings.q = from.q * std::pow (to.q / from.q, proportion);
+
+        settings.gain = from.gain + proportion * (to.gain - from.gain);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    CascadeDesigner.h
+
+    Turns the settings of every band into the list of sections the cascade
+    runs, redesigning only the bands whose settings changed since the last
+    call. Once prepared it never allocates or locks, so the processor keeps
+    one for the message thread and one for the audio thread.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQCascade.h"
+
+class CascadeDesigner
+{
+public:
+    using Bands = std::array<FilterDesign::BandSettings, FilterDesign::maxBands>;
+
+    CascadeDesigner() = default;
+
+    /** Picks up the shared frequency table for the rate and forgets the previous designs. Not real-time safe. */
+    void prepare (double sampleRate);
+
+    double getSampleRate() const noexcept                   { return table != nullptr ? table->getSampleRate() : 0.0; }
+
+    /**
+        The noise target that decides which sections run as state-variable
+        filters (see FilterDesign::designBand()). Forgets the previous designs.
+    */
+    void setNoiseTarget (double newNoiseTarget) noexcept;
+    double getNoiseTarget() const noexcept                  { return noiseTarget; }
+
+    /** Rebuilds the sections of the enabled static bands, using slot band * maxSectionsPerBand + section. */
+    void design (const Bands& bands, CascadeCoefficients& coefficients) noexcept;
+
+    /** True if both sets of bands produce the same list of sections, i.e. only frequency, gain or Q differ. */
+    static bool haveSameTopology (const Bands& a, const Bands& b) noexcept;
+
+    /**
+        The settings a fraction of the way from start to end. Frequency and Q move
+        geometrically and gain linearly, so a sweep moves at an even speed in octaves
+        and dB. Only meaningful when both have the same topology.
+    */
+    static void interpolate (const Bands& start, const Bands& end, float proportion, Bands& result) noexcept;
+
+private:
+    std::shared_ptr<const FilterDesign::FrequencyTable> table;
+    double noiseTarget = FilterDesign::defaultNoiseTarget;
+
+    Bands designedBands;
+    BiquadCoefficients sections[FilterDesign::maxBands][FilterDesign::maxSectionsPerBand];
+    int numSections[FilterDesign::maxBands] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CascadeDesigner)
+};
@@ -0,0 +1,365 @@
+/*
+  ==============================================================================
+
+    DynamicEQ.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "DynamicEQ.h"
+#include "FastMath.h"
+
+namespace
+{
+    // dB to log2 units of amplitude: dB / 20 * log2 (10)
+    constexpr float log2PerDecibel = 0.16609640474f;
+
+    double getSmoothingCoefficient (float milliseconds, double sampleRate) noexcept
+    {
+        return 1.0 - std::exp (-1.0 / juce::jmax (1.0, (double) milliseconds * 0.001 * sampleRate));
+    }
+
+    double getG (const FilterDesign::BandSettings& settings, double sampleRate) noexcept
+    {
+        auto frequency = juce::jmin ((double) settings.frequency, 0.49 * sampleRate);
+        return (double) FastMath::tan ((float) (juce::MathConstants<double>::pi * frequency / sampleRate));
+    }
+}
+
+//==============================================================================
+void DynamicEQ::prepare (int maxNumChannels, double newSampleRate)
+{
+    maxChannels = juce::jmax (1, maxNumChannels);
+    sampleRate = newSampleRate;
+    state.calloc ((size_t) (FilterDesign::maxBands * maxChannels * 2));
+
+    numActiveBands = 0;
+    wasActive.fill (false);
+}
+
+void DynamicEQ::reset() noexcept
+{
+    if (state != nullptr)
+        std::fill (state.get(), state + FilterDesign::maxBands * maxChannels * 2, 0.0);
+
+    for (auto& band : bands)
+        band.detector1 = band.detector2 = band.envelope = band.mix = 0.0;
+}
+
+void DynamicEQ::setBands (const CascadeDesigner::Bands& settings) noexcept
+{
+    numActiveBands = 0;
+
+    for (int index = 0; index < FilterDesign::maxBands; index++)
+    {
+        const auto& s = settings[(size_t) index];
+        auto& band = bands[(size_t) index];
+        auto isActive = s.isDynamic();
+
+        // A band coming into dynamic mode starts from rest
+        if (isActive && ! wasActive[(size_t) index] && state != nullptr)
+        {
+            std::fill (getState (index, 0), getState (index, 0) + maxChannels * 2, 0.0);
+            band.detector1 = band.detector2 = band.envelope = band.mix = 0.0;
+        }
+
+        wasActive[(size_t) index] = isActive;
+
+        if (! isActive)
+            continue;
+
+        auto g = getG (s, sampleRate);
+
+        band.k = 1.0 / (double) s.q;
+        band.a1 = 1.0 / (1.0 + g * (g + band.k));
+        band.a2 = g * band.a1;
+        band.a3 = g * band.a2;
+
+        // The band pass for a peak, the low pass for a low shelf and the high pass, x - k v1 - v2, for a high shelf
+        band.outputX = s.type == FilterDesign::BandType::highShelf ? 1.0 : 0.0;
+        band.outputV1 = s.type == FilterDesign::BandType::peak ? band.k : (s.type == FilterDesign::BandType::highShelf ? -band.k : 0.0);
+        band.outputV2 = s.type == FilterDesign::BandType::lowShelf ? 1.0 : (s.type == FilterDesign::BandType::highShelf ? -1.0 : 0.0);
+
+        band.threshold = FastMath::pow10 (s.dynamics.threshold / 20.0f);
+        band.thresholdLog2 = s.dynamics.threshold * log2PerDecibel;
+        band.slope = 1.0f - 1.0f / juce::jmax (1.0f, s.dynamics.ratio);
+        band.range = s.gain * log2PerDecibel;
+        band.release = getSmoothingCoefficient (s.dynamics.release, sampleRate);
+
+        // An attack slower than the release is held to the release time
+        band.attack = juce::jmax (band.release, getSmoothingCoefficient (s.dynamics.attack, sampleRate));
+
+        activeBands[(size_t) numActiveBands++] = index;
+    }
+}
+
+bool DynamicEQ::hasDecayedBelow (float threshold, int numChannels) const noexcept
+{
+    for (int i = 0; i < numActiveBands; i++)
+    {
+        auto* s = state + (size_t) (activeBands[(size_t) i] * maxChannels * 2);
+
+        for (int n = 0; n < juce::jmin (numChannels, maxChannels) * 2; n++)
+            if (std::abs (s[n]) >= (double) threshold)
+                return false;
+    }
+
+    return true;
+}
+
+double DynamicEQ::getPoleRadius (const FilterDesign::BandSettings& settings, double sampleRate) noexcept
+{
+    // The bilinear transform of s^2 + k s + 1, as z^2 + b1 z + b2
+    auto g = getG (settings, sampleRate);
+    auto k = 1.0 / (double) settings.q;
+    auto denominator = 1.0 + g * k + g * g;
+    auto b1 = 2.0 * (g * g - 1.0) / denominator;
+    auto b2 = (1.0 - g * k + g * g) / denominator;
+    auto discriminant = b1 * b1 - 4.0 * b2;
+
+    if (discriminant < 0.0)
+        return std::sqrt (b2);
+
+    auto root = std::sqrt (discriminant);
+    return juce::jmax (std::abs (-b1 + root), std::abs (-b1 - root)) * 0.5;
+}
+
+//==============================================================================
+void DynamicEQ::process (float* const* channelData, int numChannels,
+                         const float* const* detectorData, int numDetectorChannels, int numSamples) noexcept
+{
+    processChunks (channelData, numChannels, detectorData, numDetectorChannels, numSamples);
+}
+
+void DynamicEQ::process (double* const* channelData, int numChannels,
+                         const double* const* detectorData, int numDetectorChannels, int numSamples) noexcept
+{
+    processChunks (channelData, numChannels, detectorData, numDetectorChannels, numSamples);
+}
+
+template <typename SampleType>
+void DynamicEQ::processChunks (SampleType* const* channelData, int numChannels,
+                               const SampleType* const* detectorData, int numDetectorChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= maxChannels);
+    numChannels = juce::jmin (numChannels, maxChannels);
+
+    if (numActiveBands == 0 || state == nullptr)
+        return;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        auto length = juce::jmin (chunkSize, numSamples - start);
+
+        // The detector is averaged first, before the channels are filtered in place
+        std::fill (detector, detector + length, 0.0);
+
+        for (int channel = 0; channel < numDetectorChannels; channel++)
+            for (int n = 0; n < length; n++)
+                detector[n] += (double) detectorData[channel][start + n];
+
+        auto scale = numDetectorChannels > 0 ? 1.0 / numDetectorChannels : 0.0;
+
+        for (int n = 0; n < length; n++)
+            detector[n] *= scale;
+
+        followEnvelopes (length);
+
+        for (int i = 0; i < numActiveBands; i++)
+        {
+            auto index = activeBands[(size_t) i];
+            const auto& band = bands[(size_t) index];
+
+            // Up to four channels at a time, so their filters' latencies overlap
+            for (int channel = 0; channel < numChannels;)
+            {
+                auto remaining = numChannels - channel;
+
+                if (remaining >= 4)
+                {
+                    filterChannels<4> (band, index, mix[i], channel, channelData, start, length);
+                    channel += 4;
+                }
+                else if (remaining >= 2)
+                {
+                    filterChannels<2> (band, index, mix[i], channel, channelData, start, length);
+                    channel += 2;
+                }
+                else
+                {
+                    filterChannels<1> (band, index, mix[i], channel, channelData, start, length);
+                    channel += 1;
+                }
+            }
+        }
+    }
+}
+
+template <int numLanes>
+void DynamicEQ::runDetectors (int firstBand, int length) noexcept
+{
+    double a1[numLanes], a2[numLanes], a3[numLanes], outputX[numLanes], outputV1[numLanes], outputV2[numLanes];
+    double attack[numLanes], release[numLanes], ic1[numLanes], ic2[numLanes], envelope[numLanes];
+
+    // Local copies, so the compiler can keep them in registers across the stores to mix
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        const auto& band = bands[(size_t) activeBands[(size_t) (firstBand + lane)]];
+        a1[lane] = band.a1;
+        a2[lane] = band.a2;
+        a3[lane] = band.a3;
+        outputX[lane] = band.outputX;
+        outputV1[lane] = band.outputV1;
+        outputV2[lane] = band.outputV2;
+        attack[lane] = band.attack;
+        release[lane] = band.release;
+        ic1[lane] = band.detector1;
+        ic2[lane] = band.detector2;
+        envelope[lane] = band.envelope;
+    }
+
+    // The detector's filters and envelopes are the only part that has to go sample by sample
+    for (int n = 0; n < length; n++)
+    {
+        auto x = detector[n];
+
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            auto v3 = x - ic2[lane];
+            auto v1 = a1[lane] * ic1[lane] + a2[lane] * v3;
+            auto v2 = ic2[lane] + a2[lane] * ic1[lane] + a3[lane] * v3;
+            ic1[lane] = 2.0 * v1 - ic1[lane];
+            ic2[lane] = 2.0 * v2 - ic2[lane];
+
+            /*
+                With the attack at least as fast as the release, the attacked value is the
+                larger one when the level is rising and the released one when it's falling,
+                so a max picks between them without a branch and with a short dependency chain.
+            */
+            auto level = std::abs (outputX[lane] * x + outputV1[lane] * v1 + outputV2[lane] * v2);
+            auto attacked = (1.0 - attack[lane]) * envelope[lane] + attack[lane] * level;
+            auto released = (1.0 - release[lane]) * envelope[lane] + release[lane] * level;
+            envelope[lane] = juce::jmax (attacked, released);
+            mix[firstBand + lane][n] = envelope[lane];
+        }
+    }
+
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        auto& band = bands[(size_t) activeBands[(size_t) (firstBand + lane)]];
+        band.detector1 = ic1[lane];
+        band.detector2 = ic2[lane];
+        band.envelope = envelope[lane];
+    }
+}
+
+void DynamicEQ::followEnvelopes (int length) noexcept
+{
+    // Up to four bands at a time: each is independent of the others, so their latencies overlap
+    for (int i = 0; i < numActiveBands;)
+    {
+        auto remaining = numActiveBands - i;
+
+        if (remaining >= 4)
+        {
+            runDetectors<4> (i, length);
+            i += 4;
+        }
+        else if (remaining >= 2)
+        {
+            runDetectors<2> (i, length);
+            i += 2;
+        }
+        else
+        {
+            runDetectors<1> (i, length);
+            i += 1;
+        }
+    }
+
+    /*
+        Then the gain, as how much of the band's output is added. The log and
+        exponential are only worked out every gainInterval samples, and the amount
+        is interpolated in between, so the filter still moves every sample.
+    */
+    for (int i = 0; i < numActiveBands; i++)
+    {
+        auto& band = bands[(size_t) activeBands[(size_t) i]];
+        auto* bandMix = mix[i];
+        auto current = band.mix;
+
+        for (int start = 0; start < length; start += gainInterval)
+        {
+            auto end = juce::jmin (start + gainInterval, length);
+            auto target = getMix (band, bandMix[end - 1]);
+            auto step = (target - current) / (double) (end - start);
+
+            for (int n = start; n < end; n++)
+            {
+                current += step;
+                bandMix[n] = current;
+            }
+
+            current = target;
+        }
+
+        band.mix = current;
+    }
+}
+
+double DynamicEQ::getMix (const Band& band, double envelope) noexcept
+{
+    // Below the threshold the band is flat
+    if (envelope <= (double) band.threshold)
+        return 0.0;
+
+    auto over = FastMath::log2 ((float) envelope) - band.thresholdLog2;
+    auto amount = juce::jmin (over * band.slope, std::abs (band.range));
+
+    return (double) FastMath::exp2 (band.range < 0.0f ? -amount : amount) - 1.0;
+}
+
+template <int numLanes, typename SampleType>
+void DynamicEQ::filterChannels (const Band& band, int index, const double* bandMix, int firstChannel,
+                                SampleType* const* channelData, int start, int length) noexcept
+{
+    auto a1 = band.a1, a2 = band.a2, a3 = band.a3;
+    auto outputX = band.outputX, outputV1 = band.outputV1, outputV2 = band.outputV2;
+
+    double ic1[numLanes], ic2[numLanes];
+    SampleType* data[numLanes];
+
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        auto* s = getState (index, firstChannel + lane);
+        ic1[lane] = s[0];
+        ic2[lane] = s[1];
+        data[lane] = channelData[firstChannel + lane] + start;
+    }
+
+    for (int n = 0; n < length; n++)
+    {
+        auto m = bandMix[n];
+
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            auto x = (double) data[lane][n];
+            auto v3 = x - ic2[lane];
+            auto v1 = a1 * ic1[lane] + a2 * v3;
+            auto v2 = ic2[lane] + a2 * ic1[lane] + a3 * v3;
+            ic1[lane] = 2.0 * v1 - ic1[lane];
+            ic2[lane] = 2.0 * v2 - ic2[lane];
+
+            data[lane][n] = (SampleType) (x + m * (outputX * x + outputV1 * v1 + outputV2 * v2));
+        }
+    }
+
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        auto* s = getState (index, firstChannel + lane);
+        s[0] = ic1[lane];
+        s[1] = ic2[lane];
+    }
+}
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    DynamicEQ.h
+
+    The bands in dynamic mode, whose gain follows the level of the band in a
+    detector signal, sample by sample. The biquads can't do that cheaply:
+    every new gain is a new design, with its pow, tan and divisions.
+
+    Each band is a TPT state-variable filter (Zavalishin; Simper). The
+    frequency and Q set the filter, and the gain only sets how much of its
+    band pass, low pass or high pass output is added to the input:
+
+        peak        y = x + (g - 1) * k * bandPass
+        low shelf   y = x + (g - 1) * lowPass
+        high shelf  y = x + (g - 1) * highPass
+
+    so moving the gain every sample costs one multiply-add and nothing is
+    redesigned. Unlike the static peaking band, a cut is narrower than a
+    boost of the same size.
+
+    Below the threshold the band is flat. Above it, the gain moves towards the
+    band's Gain setting by (1 - 1 / ratio) dB for every dB over, so a negative
+    Gain cuts like a compressor (de-essing, taming a resonance) and a positive
+    one boosts like an expander. The level is the band's own output of the
+    same filter run over the detector, with a peak envelope. The gain is
+    worked out every 4 samples and interpolated in between, which keeps the
+    logs and exponentials from costing more than the filters.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CascadeDesigner.h"
+
+class DynamicEQ
+{
+public:
+    DynamicEQ() = default;
+
+    /** Allocates the filter state for up to maxNumChannels. Not real-time safe. */
+    void prepare (int maxNumChannels, double sampleRate);
+
+    /** Clears the filters and envelopes. */
+    void reset() noexcept;
+
+    /** Picks up the bands in dynamic mode and ignores the rest. Doesn't allocate. */
+    void setBands (const CascadeDesigner::Bands& bands) noexcept;
+
+    /** True if any band is in dynamic mode. */
+    bool isActive() const noexcept                          { return numActiveBands > 0; }
+
+    /** True if every dynamic band's state is below the threshold, so silence in gives silence out. */
+    bool hasDecayedBelow (float threshold, int numChannels) const noexcept;
+
+    /**
+        Filters the channels in place. The detector's channels are averaged and
+        measured a chunk ahead of the filtering, so the detector can be the
+        channels themselves.
+    */
+    void process (float* const* channelData, int numChannels,
+                  const float* const* detectorData, int numDetectorChannels, int numSamples) noexcept;
+    void process (double* const* channelData, int numChannels,
+                  const double* const* detectorData, int numDetectorChannels, int numSamples) noexcept;
+
+    /** The largest magnitude of the band filter's poles, as FilterDesign::getPoleRadius. */
+    static double getPoleRadius (const FilterDesign::BandSettings& settings, double sampleRate) noexcept;
+
+private:
+    struct Band
+    {
+        // The filter, from g = tan (pi f / fs) and k = 1 / Q, and which of its outputs the gain applies to
+        double k = 0, a1 = 0, a2 = 0, a3 = 0;
+        double outputX = 0, outputV1 = 0, outputV2 = 0;
+
+        // The gain computer, in log2 units of amplitude rather than dB
+        float threshold = 0, thresholdLog2 = 0, slope = 0, range = 0;
+        double attack = 0, release = 0;
+
+        // The detector's own filter and envelope, and the last amount of the band's output added
+        double detector1 = 0, detector2 = 0, envelope = 0, mix = 0;
+    };
+
+    template <typename SampleType>
+    void processChunks (SampleType* const* channelData, int numChannels,
+                        const SampleType* const* detectorData, int numDetectorChannels, int numSamples) noexcept;
+
+    /** Runs the detector through every band and leaves the gain of each sample in mix. */
+    void followEnvelopes (int length) noexcept;
+
+    template <int numLanes>
+    void runDetectors (int firstBand, int length) noexcept;
+    static double getMix (const Band& band, double envelope) noexcept;
+
+    template <int numLanes, typename SampleType>
+    void filterChannels (const Band& band, int index, const double* bandMix, int firstChannel,
+                         SampleType* const* channelData, int start, int length) noexcept;
+
+    double* getState (int band, int channel) noexcept       { return state + (size_t) ((band * maxChannels + channel) * 2); }
+
+    std::array<Band, FilterDesign::maxBands> bands;
+    std::array<int, FilterDesign::maxBands> activeBands {};
+    std::array<bool, FilterDesign::maxBands> wasActive {};
+    int numActiveBands = 0;
+
+    // ic1eq and ic2eq of every band and channel
+    juce::HeapBlock<double> state;
+    int maxChannels = 0;
+    double sampleRate = 44100;
+
+    static constexpr int chunkSize = 64;
+    static constexpr int gainInterval = 4;
+    double detector[chunkSize];
+    double mix[FilterDesign::maxBands][chunkSize];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicEQ)
+};
@@ -0,0 +1,1089 @@
+/*
+  ==============================================================================
+
+    EQCascade.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "EQCascade.h"
+#include "BiquadSIMD.h"
+
+namespace
+{
+    using namespace BiquadSIMD;
+
+    constexpr int numLanes = 4;
+
+    /*
+        Delays of up to four sections, gathered from their slots for one channel.
+        Unused lanes are left as pass-throughs (d0 = 1, everything else 0).
+    */
+    struct LaneState
+    {
+        alignas (16) float x1[numLanes] = {}, x2[numLanes] = {}, z1[numLanes] = {}, z2[numLanes] = {};
+    };
+
+    /* Lane k is filtering sample t - k on step t. */
+    inline bool isLaneActive (int lane, int step, int numSamples) noexcept
+    {
+        return juce::isPositiveAndBelow (step - lane, numSamples);
+    }
+
+    void processBandParallelScalar (float* data, int numSamples, const LaneCoefficients& c, LaneState& s) noexcept
+    {
+        // Without SIMD the pipeline has nothing to gain, so the sections simply run one after the other
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            float x1 = s.x1[lane], x2 = s.x2[lane], z1 = s.z1[lane], z2 = s.z2[lane];
+
+            for (int n = 0; n < numSamples; n++)
+            {
+                float x = data[n];
+                float z = (c.a0[lane] * x) + (c.a1[lane] * x1 + c.a2[lane] * x2 - c.b1[lane] * z1 - c.b2[lane] * z2);
+
+                x2 = x1;
+                x1 = x;
+                z2 = z1;
+                z1 = z;
+
+                data[n] = z * c.c0[lane] + x * c.d0[lane];
+            }
+
+            s.x1[lane] = x1;
+            s.x2[lane] = x2;
+            s.z1[lane] = z1;
+            s.z2[lane] = z2;
+        }
+    }
+
+   #if JUCE_INTEL
+    EQ1_TARGET_SSE2 void processBandParallelSSE2 (float* data, int numSamples, const LaneCoefficients& coefficients, LaneState& s) noexcept
+    {
+        const SSE2Coefficients c (coefficients);
+
+        auto x1 = _mm_load_ps (s.x1), x2 = _mm_load_ps (s.x2);
+        auto z1 = _mm_load_ps (s.z1), z2 = _mm_load_ps (s.z2);
+        auto previous = _mm_setzero_ps();
+
+        auto numSteps = numSamples + numLanes - 1;
+
+        for (int step = 0; step < numSteps; step++)
+        {
+            // Lane 0 takes the next input, every other lane takes its neighbour's last output
+            auto x = step < numSamples ? data[step] : 0.0f;
+            auto shifted = _mm_castsi128_ps (_mm_slli_si128 (_mm_castps_si128 (previous), 4));
+            auto in = _mm_move_ss (shifted, _mm_set_ss (x));
+
+            // Only the first and last few steps have lanes outside the block, whose state must not move
+            if (step < numLanes - 1 || step >= numSamples)
+            {
+                auto ox1 = x1, ox2 = x2, oz1 = z1, oz2 = z2;
+                previous = stepSSE2 (in, c, x1, x2, z1, z2);
+
+                auto active = _mm_castsi128_ps (_mm_setr_epi32 (isLaneActive (0, step, numSamples) ? -1 : 0,
+                                                                isLaneActive (1, step, numSamples) ? -1 : 0,
+                                                                isLaneActive (2, step, numSamples) ? -1 : 0,
+                                                                isLaneActive (3, step, numSamples) ? -1 : 0));
+
+                x1 = _mm_or_ps (_mm_and_ps (active, x1), _mm_andnot_ps (active, ox1));
+                x2 = _mm_or_ps (_mm_and_ps (active, x2), _mm_andnot_ps (active, ox2));
+                z1 = _mm_or_ps (_mm_and_ps (active, z1), _mm_andnot_ps (active, oz1));
+                z2 = _mm_or_ps (_mm_and_ps (active, z2), _mm_andnot_ps (active, oz2));
+            }
+            else
+            {
+                previous = stepSSE2 (in, c, x1, x2, z1, z2);
+            }
+
+            if (step >= numLanes - 1)
+                data[step - (numLanes - 1)] = _mm_cvtss_f32 (_mm_shuffle_ps (previous, previous, _MM_SHUFFLE (3, 3, 3, 3)));
+        }
+
+        _mm_store_ps (s.x1, x1);
+        _mm_store_ps (s.x2, x2);
+        _mm_store_ps (s.z1, z1);
+        _mm_store_ps (s.z2, z2);
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    void processBandParallelNEON (float* data, int numSamples, const LaneCoefficients& coefficients, LaneState& s) noexcept
+    {
+        const NEONCoefficients c (coefficients);
+
+        auto x1 = vld1q_f32 (s.x1), x2 = vld1q_f32 (s.x2);
+        auto z1 = vld1q_f32 (s.z1), z2 = vld1q_f32 (s.z2);
+        auto previous = vdupq_n_f32 (0.0f);
+
+        auto numSteps = numSamples + numLanes - 1;
+
+        for (int step = 0; step < numSteps; step++)
+        {
+            auto x = step < numSamples ? data[step] : 0.0f;
+            auto in = vextq_f32 (vdupq_n_f32 (x), previous, 3);
+
+            if (step < numLanes - 1 || step >= numSamples)
+            {
+                auto ox1 = x1, ox2 = x2, oz1 = z1, oz2 = z2;
+                previous = stepNEON (in, c, x1, x2, z1, z2);
+
+                const uint32_t laneMask[numLanes] = { isLaneActive (0, step, numSamples) ? ~0u : 0u,
+                                                      isLaneActive (1, step, numSamples) ? ~0u : 0u,
+                                                      isLaneActive (2, step, numSamples) ? ~0u : 0u,
+                                                      isLaneActive (3, step, numSamples) ? ~0u : 0u };
+                auto active = vld1q_u32 (laneMask);
+
+                x1 = vbslq_f32 (active, x1, ox1);
+                x2 = vbslq_f32 (active, x2, ox2);
+                z1 = vbslq_f32 (active, z1, oz1);
+                z2 = vbslq_f32 (active, z2, oz2);
+            }
+            else
+            {
+                previous = stepNEON (in, c, x1, x2, z1, z2);
+            }
+
+            if (step >= numLanes - 1)
+                data[step - (numLanes - 1)] = vgetq_lane_f32 (previous, 3);
+        }
+
+        vst1q_f32 (s.x1, x1);
+        vst1q_f32 (s.x2, x2);
+        vst1q_f32 (s.z1, z1);
+        vst1q_f32 (s.z2, z2);
+    }
+   #endif
+
+    //==============================================================================
+    /*
+        Interleaved kernels. Groups of four neighbouring channels sit next to each
+        other in every frame, so they're read, converted, run through every section
+        and written back one frame at a time, channel-parallel. The channels left
+        over are each run band-parallel, as process() runs channels that don't fill
+        a register, except that the pipeline spans every section: group g of four
+        sections takes its input from group g - 1's last lane on the previous step,
+        so sample n leaves the last section numSections steps after it went in.
+        Either way a sample is read and written once, and converted in registers.
+    */
+    using InterleavedAudio::Format;
+
+    struct InterleavedFrames
+    {
+        char* data;
+        int frameBytes;
+        int numFrames;
+
+        char* getFrame (int frame) const noexcept      { return data + (size_t) frame * (size_t) frameBytes; }
+    };
+
+    constexpr int maxLaneGroups = CascadeCoefficients::maxSections / numLanes;
+
+    /* The sections in groups of four, one per lane, with unused lanes as pass-throughs. */
+    void getLaneGroups (const CascadeCoefficients& sections, LaneCoefficients* groups) noexcept
+    {
+        for (int i = 0; i < (sections.numSections + numLanes - 1) / numLanes * numLanes; i++)
+        {
+            BiquadCoefficients section;
+            section.d0 = 1.0f;
+
+            if (i < sections.numSections)
+                section = sections.sections[i];
+
+            auto& group = groups[i / numLanes];
+            auto lane = i % numLanes;
+
+            group.a0[lane] = section.a0;
+            group.a1[lane] = section.a1;
+            group.a2[lane] = section.a2;
+            group.b1[lane] = section.b1;
+            group.b2[lane] = section.b2;
+            group.c0[lane] = section.c0;
+            group.d0[lane] = section.d0;
+        }
+    }
+
+    inline bool isStateVariable (const BiquadCoefficients& section) noexcept
+    {
+        return section.topology == BiquadCoefficients::Topology::stateVariable;
+    }
+
+    template <Format format, typename StateType>
+    void processInterleavedScalar (const InterleavedFrames& frames, int channel, const CascadeCoefficients& sections,
+                                   StateType (*state)[4]) noexcept
+    {
+        using Equation = BiquadEquation<BiquadCoefficients::Form::general>;
+
+        // a1 .. a3 of the state-variable sections, worked out once as BiquadKernel does for a block
+        StateType stateVariable[CascadeCoefficients::maxSections][3];
+
+        for (int i = 0; i < sections.numSections; i++)
+            if (isStateVariable (sections.sections[i]))
+                StateVariableEquation::getCoefficients ((StateType) sections.sections[i].stateVariable.g,
+                                                        (StateType) sections.sections[i].stateVariable.k,
+                                                        stateVariable[i][0], stateVariable[i][1], stateVariable[i][2]);
+
+        for (int n = 0; n < frames.numFrames; n++)
+        {
+            auto* frame = frames.getFrame (n);
+            auto x = (StateType) InterleavedAudio::read<format> (frame, channel);
+
+            for (int i = 0; i < sections.numSections; i++)
+            {
+                const auto& c = sections.sections[i];
+                auto* s = state[i];
+
+                if (isStateVariable (c))
+                {
+                    x = StateVariableEquation::step (x, s[0], s[1], stateVariable[i][0], stateVariable[i][1], stateVariable[i][2],
+                                                     (StateType) c.stateVariable.outputX, (StateType) c.stateVariable.outputV1,
+                                                     (StateType) c.stateVariable.outputV2);
+                    continue;
+                }
+
+                auto z = Equation::getZ (x, s[0], s[1], s[2], s[3], (StateType) c.a0, (StateType) c.a1, (StateType) c.a2,
+                                         (StateType) c.b1, (StateType) c.b2);
+                auto y = Equation::getOutput (z, x, (StateType) c.c0, (StateType) c.d0);
+
+                s[1] = s[0];
+                s[0] = x;
+                s[3] = s[2];
+                s[2] = z;
+                x = y;
+            }
+
+            InterleavedAudio::write<format> (frame, channel, (float) x);
+        }
+    }
+
+   #if JUCE_INTEL
+    template <Format format>
+    EQ1_TARGET_SSE2 inline __m128 loadFrameSSE2 (const char* frame) noexcept
+    {
+        constexpr auto scale = 1.0f / InterleavedAudio::fullScale<format>;
+
+        if constexpr (format == Format::float32)
+        {
+            return _mm_loadu_ps (reinterpret_cast<const float*> (frame));
+        }
+        else if constexpr (format == Format::int16)
+        {
+            // Each sample into the top half of a 32-bit lane, then shifted down with its sign
+            auto samples = _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (frame));
+            auto widened = _mm_srai_epi32 (_mm_unpacklo_epi16 (samples, samples), 16);
+            return _mm_mul_ps (_mm_cvtepi32_ps (widened), _mm_set1_ps (scale));
+        }
+        else
+        {
+            // Three-byte samples don't line up with the lanes, so they're gathered as integers
+            auto samples = _mm_setr_epi32 (InterleavedAudio::readInt24 (frame), InterleavedAudio::readInt24 (frame + 3),
+                                           InterleavedAudio::readInt24 (frame + 6), InterleavedAudio::readInt24 (frame + 9));
+            return _mm_mul_ps (_mm_cvtepi32_ps (samples), _mm_set1_ps (scale));
+        }
+    }
+
+    template <Format format>
+    EQ1_TARGET_SSE2 inline void storeFrameSSE2 (char* frame, __m128 y) noexcept
+    {
+        if constexpr (format == Format::float32)
+        {
+            _mm_storeu_ps (reinterpret_cast<float*> (frame), y);
+        }
+        else
+        {
+            // Clipped before converting, which rounds to nearest as lrint does
+            constexpr auto fullScale = InterleavedAudio::fullScale<format>;
+            auto scaled = _mm_min_ps (_mm_max_ps (_mm_mul_ps (y, _mm_set1_ps (fullScale)), _mm_set1_ps (-fullScale)),
+                                      _mm_set1_ps (fullScale - 1.0f));
+            auto integers = _mm_cvtps_epi32 (scaled);
+
+            if constexpr (format == Format::int16)
+            {
+                _mm_storel_epi64 (reinterpret_cast<__m128i*> (frame), _mm_packs_epi32 (integers, integers));
+            }
+            else
+            {
+                alignas (16) juce::int32 samples[numLanes];
+                _mm_store_si128 (reinterpret_cast<__m128i*> (samples), integers);
+
+                for (int lane = 0; lane < numLanes; lane++)
+                    InterleavedAudio::writeInt24 (frame + 3 * lane, samples[lane]);
+            }
+        }
+    }
+
+    /* Lane 0 of y into one channel of a frame, rounded and clipped the same way. */
+    template <Format format>
+    EQ1_TARGET_SSE2 inline void storeSampleSSE2 (char* frame, int channel, __m128 y) noexcept
+    {
+        if constexpr (format == Format::float32)
+        {
+            _mm_store_ss (reinterpret_cast<float*> (frame) + channel, y);
+        }
+        else
+        {
+            constexpr auto fullScale = InterleavedAudio::fullScale<format>;
+            auto scaled = _mm_min_ss (_mm_max_ss (_mm_mul_ss (y, _mm_set_ss (fullScale)), _mm_set_ss (-fullScale)),
+                                      _mm_set_ss (fullScale - 1.0f));
+            auto integer = _mm_cvtss_si32 (scaled);
+
+            if constexpr (format == Format::int16)
+            {
+                auto sample = (juce::int16) integer;
+                std::memcpy (frame + 2 * channel, &sample, sizeof (sample));
+            }
+            else
+            {
+                InterleavedAudio::writeInt24 (frame + 3 * channel, integer);
+            }
+        }
+    }
+
+    template <Format format>
+    EQ1_TARGET_SSE2 void processInterleavedChannelsSSE2 (const InterleavedFrames& frames, int firstChannel,
+                                                         const CascadeCoefficients& sections, BiquadState* const* states) noexcept
+    {
+        SSE2Coefficients c[CascadeCoefficients::maxSections];
+        SSE2StateVariableCoefficients v[CascadeCoefficients::maxSections];
+        bool useStateVariable[CascadeCoefficients::maxSections];
+        __m128 x1[CascadeCoefficients::maxSections], x2[CascadeCoefficients::maxSections];
+        __m128 z1[CascadeCoefficients::maxSections], z2[CascadeCoefficients::maxSections];
+
+        // The delay lines are aligned and padded, so a group's delays load straight into the lanes
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            useStateVariable[i] = isStateVariable (sections.sections[i]);
+
+            if (useStateVariable[i])
+                v[i] = SSE2StateVariableCoefficients (sections.sections[i]);
+            else
+                c[i] = SSE2Coefficients (sections.sections[i]);
+
+            x1[i] = _mm_load_ps (states[i]->getDelayLine (BiquadState::a1Delay) + firstChannel);
+            x2[i] = _mm_load_ps (states[i]->getDelayLine (BiquadState::a2Delay) + firstChannel);
+            z1[i] = _mm_load_ps (states[i]->getDelayLine (BiquadState::b1Delay) + firstChannel);
+            z2[i] = _mm_load_ps (states[i]->getDelayLine (BiquadState::b2Delay) + firstChannel);
+        }
+
+        auto* data = frames.data + firstChannel * InterleavedAudio::getBytesPerSample (format);
+
+        for (int n = 0; n < frames.numFrames; n++)
+        {
+            auto* frame = data + (size_t) n * (size_t) frames.frameBytes;
+            auto x = loadFrameSSE2<format> (frame);
+
+            for (int i = 0; i < sections.numSections; i++)
+                x = useStateVariable[i] ? stepSSE2<BiquadCoefficients::Form::stateVariable> (x, v[i], x1[i], x2[i], z1[i], z2[i])
+                                        : stepSSE2 (x, c[i], x1[i], x2[i], z1[i], z2[i]);
+
+            storeFrameSSE2<format> (frame, x);
+        }
+
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            _mm_store_ps (states[i]->getDelayLine (BiquadState::a1Delay) + firstChannel, x1[i]);
+            _mm_store_ps (states[i]->getDelayLine (BiquadState::a2Delay) + firstChannel, x2[i]);
+            _mm_store_ps (states[i]->getDelayLine (BiquadState::b1Delay) + firstChannel, z1[i]);
+            _mm_store_ps (states[i]->getDelayLine (BiquadState::b2Delay) + firstChannel, z2[i]);
+        }
+    }
+
+    template <Format format>
+    EQ1_TARGET_SSE2 void processInterleavedChannelBandParallelSSE2 (const InterleavedFrames& frames, int channel,
+                                                                    const LaneCoefficients* groups, int numGroups,
+                                                                    LaneState* states) noexcept
+    {
+        SSE2Coefficients c[maxLaneGroups];
+        __m128 x1[maxLaneGroups], x2[maxLaneGroups], z1[maxLaneGroups], z2[maxLaneGroups], previous[maxLaneGroups];
+
+        for (int g = 0; g < numGroups; g++)
+        {
+            c[g] = SSE2Coefficients (groups[g]);
+            x1[g] = _mm_load_ps (states[g].x1);
+            x2[g] = _mm_load_ps (states[g].x2);
+            z1[g] = _mm_load_ps (states[g].z1);
+            z2[g] = _mm_load_ps (states[g].z2);
+            previous[g] = _mm_setzero_ps();
+        }
+
+        auto depth = numGroups * numLanes;
+        auto numFrames = frames.numFrames;
+        auto numSteps = numFrames + depth - 1;
+
+        for (int step = 0; step < numSteps; step++)
+        {
+            auto carry = _mm_set_ss (step < numFrames ? InterleavedAudio::read<format> (frames.getFrame (step), channel) : 0.0f);
+            auto isFillingOrDraining = step < depth - 1 || step >= numFrames;
+
+            for (int g = 0; g < numGroups; g++)
+            {
+                // Lane 0 takes the previous group's last output from the step before, every other lane its neighbour's
+                auto nextCarry = _mm_shuffle_ps (previous[g], previous[g], _MM_SHUFFLE (3, 3, 3, 3));
+                auto shifted = _mm_castsi128_ps (_mm_slli_si128 (_mm_castps_si128 (previous[g]), 4));
+                auto in = _mm_move_ss (shifted, carry);
+
+                if (isFillingOrDraining)
+                {
+                    auto ox1 = x1[g], ox2 = x2[g], oz1 = z1[g], oz2 = z2[g];
+                    previous[g] = stepSSE2 (in, c[g], x1[g], x2[g], z1[g], z2[g]);
+
+                    auto first = g * numLanes;
+                    auto active = _mm_castsi128_ps (_mm_setr_epi32 (isLaneActive (first, step, numFrames) ? -1 : 0,
+                                                                    isLaneActive (first + 1, step, numFrames) ? -1 : 0,
+                                                                    isLaneActive (first + 2, step, numFrames) ? -1 : 0,
+                                                                    isLaneActive (first + 3, step, numFrames) ? -1 : 0));
+
+                    x1[g] = _mm_or_ps (_mm_and_ps (active, x1[g]), _mm_andnot_ps (active, ox1));
+                    x2[g] = _mm_or_ps (_mm_and_ps (active, x2[g]), _mm_andnot_ps (active, ox2));
+                    z1[g] = _mm_or_ps (_mm_and_ps (active, z1[g]), _mm_andnot_ps (active, oz1));
+                    z2[g] = _mm_or_ps (_mm_and_ps (active, z2[g]), _mm_andnot_ps (active, oz2));
+                }
+                else
+                {
+                    previous[g] = stepSSE2 (in, c[g], x1[g], x2[g], z1[g], z2[g]);
+                }
+
+                carry = nextCarry;
+            }
+
+            if (step >= depth - 1)
+            {
+                auto& last = previous[numGroups - 1];
+                storeSampleSSE2<format> (frames.getFrame (step - (depth - 1)), channel, _mm_shuffle_ps (last, last, _MM_SHUFFLE (3, 3, 3, 3)));
+            }
+        }
+
+        for (int g = 0; g < numGroups; g++)
+        {
+            _mm_store_ps (states[g].x1, x1[g]);
+            _mm_store_ps (states[g].x2, x2[g]);
+            _mm_store_ps (states[g].z1, z1[g]);
+            _mm_store_ps (states[g].z2, z2[g]);
+        }
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    template <Format format>
+    inline float32x4_t loadFrameNEON (const char* frame) noexcept
+    {
+        if constexpr (format == Format::float32)
+        {
+            return vld1q_f32 (reinterpret_cast<const float*> (frame));
+        }
+        else if constexpr (format == Format::int16)
+        {
+            juce::int16 samples[numLanes];
+            std::memcpy (samples, frame, sizeof (samples));
+            return vmulq_n_f32 (vcvtq_f32_s32 (vmovl_s16 (vld1_s16 (samples))), 1.0f / InterleavedAudio::fullScale<format>);
+        }
+        else
+        {
+            const juce::int32 samples[numLanes] = { InterleavedAudio::readInt24 (frame), InterleavedAudio::readInt24 (frame + 3),
+                                                    InterleavedAudio::readInt24 (frame + 6), InterleavedAudio::readInt24 (frame + 9) };
+            return vmulq_n_f32 (vcvtq_f32_s32 (vld1q_s32 (samples)), 1.0f / InterleavedAudio::fullScale<format>);
+        }
+    }
+
+    template <Format format>
+    inline void storeFrameNEON (char* frame, float32x4_t y) noexcept
+    {
+        if constexpr (format == Format::float32)
+        {
+            vst1q_f32 (reinterpret_cast<float*> (frame), y);
+        }
+        else
+        {
+            // NEON's conversions to integer truncate, so the integers are rounded by lrint, as the reference does
+            alignas (16) float samples[numLanes];
+            vst1q_f32 (samples, y);
+
+            for (int lane = 0; lane < numLanes; lane++)
+                InterleavedAudio::write<format> (frame, lane, samples[lane]);
+        }
+    }
+
+    template <Format format>
+    void processInterleavedChannelsNEON (const InterleavedFrames& frames, int firstChannel,
+                                         const CascadeCoefficients& sections, BiquadState* const* states) noexcept
+    {
+        NEONCoefficients c[CascadeCoefficients::maxSections];
+        NEONStateVariableCoefficients v[CascadeCoefficients::maxSections];
+        bool useStateVariable[CascadeCoefficients::maxSections];
+        float32x4_t x1[CascadeCoefficients::maxSections], x2[CascadeCoefficients::maxSections];
+        float32x4_t z1[CascadeCoefficients::maxSections], z2[CascadeCoefficients::maxSections];
+
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            useStateVariable[i] = isStateVariable (sections.sections[i]);
+
+            if (useStateVariable[i])
+                v[i] = NEONStateVariableCoefficients (sections.sections[i]);
+            else
+                c[i] = NEONCoefficients (sections.sections[i]);
+
+            x1[i] = vld1q_f32 (states[i]->getDelayLine (BiquadState::a1Delay) + firstChannel);
+            x2[i] = vld1q_f32 (states[i]->getDelayLine (BiquadState::a2Delay) + firstChannel);
+            z1[i] = vld1q_f32 (states[i]->getDelayLine (BiquadState::b1Delay) + firstChannel);
+            z2[i] = vld1q_f32 (states[i]->getDelayLine (BiquadState::b2Delay) + firstChannel);
+        }
+
+        auto* data = frames.data + firstChannel * InterleavedAudio::getBytesPerSample (format);
+
+        for (int n = 0; n < frames.numFrames; n++)
+        {
+            auto* frame = data + (size_t) n * (size_t) frames.frameBytes;
+            auto x = loadFrameNEON<format> (frame);
+
+            for (int i = 0; i < sections.numSections; i++)
+                x = useStateVariable[i] ? stepNEON<BiquadCoefficients::Form::stateVariable> (x, v[i], x1[i], x2[i], z1[i], z2[i])
+                                        : stepNEON (x, c[i], x1[i], x2[i], z1[i], z2[i]);
+
+            storeFrameNEON<format> (frame, x);
+        }
+
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            vst1q_f32 (states[i]->getDelayLine (BiquadState::a1Delay) + firstChannel, x1[i]);
+            vst1q_f32 (states[i]->getDelayLine (BiquadState::a2Delay) + firstChannel, x2[i]);
+            vst1q_f32 (states[i]->getDelayLine (BiquadState::b1Delay) + firstChannel, z1[i]);
+            vst1q_f32 (states[i]->getDelayLine (BiquadState::b2Delay) + firstChannel, z2[i]);
+        }
+    }
+
+    template <Format format>
+    void processInterleavedChannelBandParallelNEON (const InterleavedFrames& frames, int channel,
+                                                    const LaneCoefficients* groups, int numGroups,
+                                                    LaneState* states) noexcept
+    {
+        NEONCoefficients c[maxLaneGroups];
+        float32x4_t x1[maxLaneGroups], x2[maxLaneGroups], z1[maxLaneGroups], z2[maxLaneGroups], previous[maxLaneGroups];
+
+        for (int g = 0; g < numGroups; g++)
+        {
+            c[g] = NEONCoefficients (groups[g]);
+            x1[g] = vld1q_f32 (states[g].x1);
+            x2[g] = vld1q_f32 (states[g].x2);
+            z1[g] = vld1q_f32 (states[g].z1);
+            z2[g] = vld1q_f32 (states[g].z2);
+            previous[g] = vdupq_n_f32 (0.0f);
+        }
+
+        auto depth = numGroups * numLanes;
+        auto numFrames = frames.numFrames;
+        auto numSteps = numFrames + depth - 1;
+
+        for (int step = 0; step < numSteps; step++)
+        {
+            auto carry = step < numFrames ? InterleavedAudio::read<format> (frames.getFrame (step), channel) : 0.0f;
+            auto isFillingOrDraining = step < depth - 1 || step >= numFrames;
+
+            for (int g = 0; g < numGroups; g++)
+            {
+                auto nextCarry = vgetq_lane_f32 (previous[g], 3);
+                auto in = vextq_f32 (vdupq_n_f32 (carry), previous[g], 3);
+
+                if (isFillingOrDraining)
+                {
+                    auto ox1 = x1[g], ox2 = x2[g], oz1 = z1[g], oz2 = z2[g];
+                    previous[g] = stepNEON (in, c[g], x1[g], x2[g], z1[g], z2[g]);
+
+                    auto first = g * numLanes;
+                    const uint32_t laneMask[numLanes] = { isLaneActive (first, step, numFrames) ? ~0u : 0u,
+                                                          isLaneActive (first + 1, step, numFrames) ? ~0u : 0u,
+                                                          isLaneActive (first + 2, step, numFrames) ? ~0u : 0u,
+                                                          isLaneActive (first + 3, step, numFrames) ? ~0u : 0u };
+                    auto active = vld1q_u32 (laneMask);
+
+                    x1[g] = vbslq_f32 (active, x1[g], ox1);
+                    x2[g] = vbslq_f32 (active, x2[g], ox2);
+                    z1[g] = vbslq_f32 (active, z1[g], oz1);
+                    z2[g] = vbslq_f32 (active, z2[g], oz2);
+                }
+                else
+                {
+                    previous[g] = stepNEON (in, c[g], x1[g], x2[g], z1[g], z2[g]);
+                }
+
+                carry = nextCarry;
+            }
+
+            if (step >= depth - 1)
+                InterleavedAudio::write<format> (frames.getFrame (step - (depth - 1)), channel,
+                                                 vgetq_lane_f32 (previous[numGroups - 1], 3));
+        }
+
+        for (int g = 0; g < numGroups; g++)
+        {
+            vst1q_f32 (states[g].x1, x1[g]);
+            vst1q_f32 (states[g].x2, x2[g]);
+            vst1q_f32 (states[g].z1, z1[g]);
+            vst1q_f32 (states[g].z2, z2[g]);
+        }
+    }
+   #endif
+}
+
+//==============================================================================
+EQCascade::EQCascade()
+    : kernel (BiquadEngine::getBestAvailableKernel())
+{
+}
+
+void EQCascade::prepare (int maxNumChannels)
+{
+    for (auto& slot : slots)
+        slot.prepare (maxNumChannels);
+
+    maxChannels = maxNumChannels;
+    doubleState.calloc ((size_t) (CascadeCoefficients::maxSections * maxChannels * 4));
+    activeSlots = 0;
+}
+
+void EQCascade::reset() noexcept
+{
+    for (auto& slot : slots)
+        slot.reset();
+
+    if (doubleState != nullptr)
+        std::fill (doubleState.get(), doubleState + CascadeCoefficients::maxSections * maxChannels * 4, 0.0);
+}
+
+void EQCascade::setUseDoubleState (bool shouldUseDoubleState) noexcept
+{
+    useDoubleState = shouldUseDoubleState;
+}
+
+void EQCascade::setMode (BiquadEngine::Mode newMode) noexcept
+{
+    for (auto& slot : slots)
+        slot.setMode (newMode);
+
+    mode = newMode;
+}
+
+void EQCascade::setKernel (BiquadEngine::Kernel newKernel) noexcept
+{
+    for (auto& slot : slots)
+        slot.setKernel (newKernel);
+
+    kernel = slots[0].getKernel();
+}
+
+void EQCascade::process (float* const* channelData, int numChannels, int numSamples,
+                         const CascadeCoefficients& coefficients) noexcept
+{
+    if (useDoubleState)
+    {
+        processWithDoubleState (channelData, numChannels, numSamples, coefficients);
+        return;
+    }
+
+    auto& sections = withoutIdentities (coefficients, numChannels, false);
+    updateActiveSlots (sections);
+
+    // Time-parallel mode gives every section the time axis of its own, so the sections aren't grouped
+    if (numChannels >= numLanes || sections.numSections < 2 || kernel == BiquadEngine::Kernel::scalar
+        || mode == BiquadEngine::Mode::timeParallel)
+    {
+        for (int i = 0; i < sections.numSections; i++)
+            slots[sections.slots[i]].process (channelData, numChannels, numSamples, sections.sections[i]);
+
+        return;
+    }
+
+    // Runs of up to four direct-form sections share the lanes; a state-variable section runs on its own
+    for (int first = 0; first < sections.numSections;)
+    {
+        int count = 0;
+
+        while (count < numLanes && first + count < sections.numSections && ! isStateVariable (sections.sections[first + count]))
+            count++;
+
+        if (count == 0)
+        {
+            slots[sections.slots[first]].process (channelData, numChannels, numSamples, sections.sections[first]);
+            first++;
+            continue;
+        }
+
+        for (int channel = 0; channel < numChannels; channel++)
+            processBandParallel (channelData[channel], channel, sections, first, count, numSamples);
+
+        first += count;
+    }
+}
+
+void EQCascade::processRamp (float* const* channelData, int numChannels, int numSamples,
+                             const CascadeCoefficients& start, const CascadeCoefficients& increments) noexcept
+{
+    if (useDoubleState)
+    {
+        processRampWithDoubleState (channelData, numChannels, numSamples, start, increments);
+        return;
+    }
+
+    jassert (start.numSections == increments.numSections);
+    updateActiveSlots (start);
+
+    for (int i = 0; i < start.numSections; i++)
+        slots[start.slots[i]].processRamp (channelData, numChannels, numSamples, start.sections[i], increments.sections[i]);
+}
+
+void EQCascade::process (double* const* channelData, int numChannels, int numSamples,
+                         const CascadeCoefficients& coefficients) noexcept
+{
+    processWithDoubleState (channelData, numChannels, numSamples, coefficients);
+}
+
+void EQCascade::processInterleaved (void* data, InterleavedAudio::Format format, int numChannels, int numFrames,
+                                    const CascadeCoefficients& coefficients) noexcept
+{
+    jassert (numChannels <= maxChannels);
+
+    auto& sections = withoutIdentities (coefficients, numChannels, useDoubleState);
+    updateActiveSlots (sections);
+
+    auto* frames = static_cast<char*> (data);
+
+    switch (format)
+    {
+        case InterleavedAudio::Format::int16:   processInterleavedFormat<InterleavedAudio::Format::int16> (frames, numChannels, numFrames, sections); break;
+        case InterleavedAudio::Format::int24:   processInterleavedFormat<InterleavedAudio::Format::int24> (frames, numChannels, numFrames, sections); break;
+        case InterleavedAudio::Format::float32:
+        default:                                processInterleavedFormat<InterleavedAudio::Format::float32> (frames, numChannels, numFrames, sections); break;
+    }
+}
+
+template <InterleavedAudio::Format format>
+void EQCascade::processInterleavedFormat (char* data, int numChannels, int numFrames, const CascadeCoefficients& sections) noexcept
+{
+    const InterleavedFrames frames { data, numChannels * InterleavedAudio::getBytesPerSample (format), numFrames };
+
+    // One channel at a time, with its delays gathered into one array, in double or float
+    auto processScalarChannel = [&] (int channel)
+    {
+        if (useDoubleState)
+        {
+            double state[CascadeCoefficients::maxSections][4];
+
+            for (int i = 0; i < sections.numSections; i++)
+                std::copy (getDoubleState (sections.slots[i], channel), getDoubleState (sections.slots[i], channel) + 4, state[i]);
+
+            processInterleavedScalar<format> (frames, channel, sections, state);
+
+            for (int i = 0; i < sections.numSections; i++)
+                std::copy (state[i], state[i] + 4, getDoubleState (sections.slots[i], channel));
+        }
+        else
+        {
+            float state[CascadeCoefficients::maxSections][4];
+
+            for (int i = 0; i < sections.numSections; i++)
+                for (int line = 0; line < BiquadState::numDelayLines; line++)
+                    state[i][line] = slots[sections.slots[i]].getState().getDelayLine ((BiquadState::DelayLine) line)[channel];
+
+            processInterleavedScalar<format> (frames, channel, sections, state);
+
+            for (int i = 0; i < sections.numSections; i++)
+                for (int line = 0; line < BiquadState::numDelayLines; line++)
+                    slots[sections.slots[i]].getState().getDelayLine ((BiquadState::DelayLine) line)[channel] = state[i][line];
+        }
+    };
+
+    if (useDoubleState || kernel == BiquadEngine::Kernel::scalar)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+            processScalarChannel (channel);
+
+        return;
+    }
+
+   #if JUCE_INTEL || EQ1_HAS_NEON
+    BiquadState* states[CascadeCoefficients::maxSections];
+
+    for (int i = 0; i < sections.numSections; i++)
+        states[i] = &slots[sections.slots[i]].getState();
+
+    int channel = 0;
+
+    for (; channel + numLanes <= numChannels; channel += numLanes)
+    {
+       #if JUCE_INTEL
+        processInterleavedChannelsSSE2<format> (frames, channel, sections, states);
+       #else
+        processInterleavedChannelsNEON<format> (frames, channel, sections, states);
+       #endif
+    }
+
+    if (channel == numChannels || sections.numSections == 0)
+        return;
+
+    // The band-parallel pipeline only runs the difference equation
+    if (std::any_of (sections.sections, sections.sections + sections.numSections, isStateVariable))
+    {
+        for (; channel < numChannels; channel++)
+            processScalarChannel (channel);
+
+        return;
+    }
+
+    LaneCoefficients groups[maxLaneGroups];
+    LaneState laneStates[maxLaneGroups];
+    auto numGroups = (sections.numSections + numLanes - 1) / numLanes;
+    getLaneGroups (sections, groups);
+
+    for (; channel < numChannels; channel++)
+    {
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            auto& lanes = laneStates[i / numLanes];
+            lanes.x1[i % numLanes] = states[i]->getDelayLine (BiquadState::a1Delay)[channel];
+            lanes.x2[i % numLanes] = states[i]->getDelayLine (BiquadState::a2Delay)[channel];
+            lanes.z1[i % numLanes] = states[i]->getDelayLine (BiquadState::b1Delay)[channel];
+            lanes.z2[i % numLanes] = states[i]->getDelayLine (BiquadState::b2Delay)[channel];
+        }
+
+       #if JUCE_INTEL
+        processInterleavedChannelBandParallelSSE2<format> (frames, channel, groups, numGroups, laneStates);
+       #else
+        processInterleavedChannelBandParallelNEON<format> (frames, channel, groups, numGroups, laneStates);
+       #endif
+
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            const auto& lanes = laneStates[i / numLanes];
+            states[i]->getDelayLine (BiquadState::a1Delay)[channel] = lanes.x1[i % numLanes];
+            states[i]->getDelayLine (BiquadState::a2Delay)[channel] = lanes.x2[i % numLanes];
+            states[i]->getDelayLine (BiquadState::b1Delay)[channel] = lanes.z1[i % numLanes];
+            states[i]->getDelayLine (BiquadState::b2Delay)[channel] = lanes.z2[i % numLanes];
+        }
+    }
+   #endif
+}
+
+void EQCascade::processRamp (double* const* channelData, int numChannels, int numSamples,
+                             const CascadeCoefficients& start, const CascadeCoefficients& increments) noexcept
+{
+    processRampWithDoubleState (channelData, numChannels, numSamples, start, increments);
+}
+
+template <typename SampleType>
+void EQCascade::processWithDoubleState (SampleType* const* channelData, int numChannels, int numSamples,
+                                        const CascadeCoefficients& coefficients) noexcept
+{
+    jassert (numChannels <= maxChannels);
+
+    auto& sections = withoutIdentities (coefficients, numChannels, true);
+    updateActiveSlots (sections);
+
+    // Each channel goes through every section while its block is still in the cache
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        for (int i = 0; i < sections.numSections; i++)
+        {
+            auto* d = getDoubleState (sections.slots[i], channel);
+            BiquadKernel<SampleType, double>::process (channelData[channel], numSamples, sections.sections[i],
+                                                       d[0], d[1], d[2], d[3]);
+        }
+    }
+}
+
+template <typename SampleType>
+void EQCascade::processRampWithDoubleState (SampleType* const* channelData, int numChannels, int numSamples,
+                                            const CascadeCoefficients& start, const CascadeCoefficients& increments) noexcept
+{
+    jassert (start.numSections == increments.numSections && numChannels <= maxChannels);
+    updateActiveSlots (start);
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        for (int i = 0; i < start.numSections; i++)
+        {
+            auto* d = getDoubleState (start.slots[i], channel);
+            BiquadKernel<SampleType, double>::processRamp (channelData[channel], numSamples, start.sections[i],
+                                                           increments.sections[i], d[0], d[1], d[2], d[3]);
+        }
+    }
+}
+
+const CascadeCoefficients& EQCascade::withoutIdentities (const CascadeCoefficients& coefficients, int numChannels,
+                                                         bool isUsingDoubleState) noexcept
+{
+    auto canSkip = [&] (int i)
+    {
+        const auto& section = coefficients.sections[i];
+
+        // A state-variable section's delays hold the integrators, not x and z, so it never counts as settled
+        return section.isIdentity()
+            || (section.hasMatchingPolesAndZeros() && ! isStateVariable (section)
+                && hasSettledToIdentity (coefficients.slots[i], numChannels, isUsingDoubleState));
+    };
+
+    int first = 0;
+
+    while (first < coefficients.numSections && ! canSkip (first))
+        first++;
+
+    if (first == coefficients.numSections)
+        return coefficients;
+
+    nonIdentitySections.clear();
+
+    for (int i = 0; i < coefficients.numSections; i++)
+        if (i < first || (i > first && ! canSkip (i)))
+            nonIdentitySections.add (coefficients.slots[i], coefficients.sections[i]);
+
+    return nonIdentitySections;
+}
+
+bool EQCascade::hasSettledToIdentity (int slot, int numChannels, bool isUsingDoubleState) const noexcept
+{
+    /*
+        With the numerator equal to the denominator, z[n] - x[n] decays at the rate of
+        the poles, and rounding keeps it from reaching exactly zero. Once it is below
+        about -120 dBFS, dropping it is inaudible; a slot coming back starts from
+        silence, where z = x holds exactly.
+    */
+    constexpr float settledThreshold = 1.0e-6f;
+
+    if (isUsingDoubleState)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            auto* d = getDoubleState (slot, channel);
+
+            if (std::abs (d[0] - d[2]) > settledThreshold || std::abs (d[1] - d[3]) > settledThreshold)
+                return false;
+        }
+
+        return true;
+    }
+
+    auto& state = slots[slot].getState();
+    auto* x1 = state.getDelayLine (BiquadState::a1Delay);
+    auto* x2 = state.getDelayLine (BiquadState::a2Delay);
+    auto* z1 = state.getDelayLine (BiquadState::b1Delay);
+    auto* z2 = state.getDelayLine (BiquadState::b2Delay);
+
+    for (int channel = 0; channel < numChannels; channel++)
+        if (std::abs (x1[channel] - z1[channel]) > settledThreshold || std::abs (x2[channel] - z2[channel]) > settledThreshold)
+            return false;
+
+    return true;
+}
+
+bool EQCascade::hasDecayedBelow (float threshold, int numChannels) const noexcept
+{
+    for (int slot = 0; slot < CascadeCoefficients::maxSections; slot++)
+    {
+        if ((activeSlots & ((juce::uint64) 1 << slot)) == 0)
+            continue;
+
+        auto& state = slots[slot].getState();
+
+        for (int line = 0; line < BiquadState::numDelayLines; line++)
+        {
+            auto* delays = state.getDelayLine ((BiquadState::DelayLine) line);
+
+            for (int channel = 0; channel < numChannels; channel++)
+                if (std::abs (delays[channel]) >= threshold)
+                    return false;
+        }
+
+        if (doubleState != nullptr)
+        {
+            auto* d = getDoubleState (slot, 0);
+
+            for (int i = 0; i < numChannels * 4; i++)
+                if (std::abs (d[i]) >= threshold)
+                    return false;
+        }
+    }
+
+    return true;
+}
+
+void EQCascade::updateActiveSlots (const CascadeCoefficients& coefficients) noexcept
+{
+    // A band that has just been switched on, or to the other topology, starts from silence rather than whatever it last held
+    juce::uint64 nowActive = 0, nowStateVariable = 0;
+
+    for (int i = 0; i < coefficients.numSections; i++)
+    {
+        auto bit = (juce::uint64) 1 << coefficients.slots[i];
+        auto stateVariableBit = isStateVariable (coefficients.sections[i]) ? bit : 0;
+
+        if ((activeSlots & bit) == 0 || (stateVariableSlots & bit) != stateVariableBit)
+        {
+            slots[coefficients.slots[i]].reset();
+
+            if (doubleState != nullptr)
+                std::fill (getDoubleState (coefficients.slots[i], 0), getDoubleState (coefficients.slots[i] + 1, 0), 0.0);
+        }
+
+        nowActive |= bit;
+        nowStateVariable |= stateVariableBit;
+    }
+
+    activeSlots = nowActive;
+    stateVariableSlots = nowStateVariable;
+}
+
+void EQCascade::processBandParallel (float* data, int channel, const CascadeCoefficients& coefficients,
+                                     int firstSection, int numSections, int numSamples) noexcept
+{
+    LaneCoefficients c;
+    LaneState s;
+
+    jassert (numSections <= numLanes && firstSection + numSections <= coefficients.numSections);
+    auto numActive = numSections;
+
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        BiquadCoefficients section;
+        section.d0 = 1.0f;
+
+        if (lane < numActive)
+        {
+            section = coefficients.sections[firstSection + lane];
+
+            auto& state = slots[coefficients.slots[firstSection + lane]].getState();
+            s.x1[lane] = state.getDelayLine (BiquadState::a1Delay)[channel];
+            s.x2[lane] = state.getDelayLine (BiquadState::a2Delay)[channel];
+            s.z1[lane] = state.getDelayLine (BiquadState::b1Delay)[channel];
+            s.z2[lane] = state.getDelayLine (BiquadState::b2Delay)[channel];
+        }
+
+        c.a0[lane] = section.a0;
+        c.a1[lane] = section.a1;
+        c.a2[lane] = section.a2;
+        c.b1[lane] = section.b1;
+        c.b2[lane] = section.b2;
+        c.c0[lane] = section.c0;
+        c.d0[lane] = section.d0;
+    }
+
+    switch (kernel)
+    {
+       #if JUCE_INTEL
+        case BiquadEngine::Kernel::sse2:
+        case BiquadEngine::Kernel::avx2:    processBandParallelSSE2 (data, numSamples, c, s); break;
+       #endif
+       #if EQ1_HAS_NEON
+        case BiquadEngine::Kernel::neon:    processBandParallelNEON (data, numSamples, c, s); break;
+       #endif
+        default:                            processBandParallelScalar (data, numSamples, c, s); break;
+    }
+
+    for (int lane = 0; lane < numActive; lane++)
+    {
+        auto& state = slots[coefficients.slots[firstSection + lane]].getState();
+        state.getDelayLine (BiquadState::a1Delay)[channel] = s.x1[lane];
+        state.getDelayLine (BiquadState::a2Delay)[channel] = s.x2[lane];
+        state.getDelayLine (BiquadState::b1Delay)[channel] = s.z1[lane];
+        state.getDelayLine (BiquadState::b2Delay)[channel] = s.z2[lane];
+    }
+}
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    EQCascade.h
+
+    Cascade of second-order sections for the multi-band EQ. The coefficients of
+    all active sections are stored contiguously; each section also names the
+    state slot it filters with, so a band keeps its delays while other bands are
+    switched on and off.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+#include "FilterDesign.h"
+#include "InterleavedAudio.h"
+
+//==============================================================================
+/**
+    The sections that processBlock runs, in order. Disabled bands don't add any
+    sections, so they cost nothing.
+*/
+struct CascadeCoefficients
+{
+    static constexpr int maxSections = FilterDesign::maxBands * FilterDesign::maxSectionsPerBand;
+
+    void clear() noexcept                                   { numSections = 0; }
+
+    void add (int slot, const BiquadCoefficients& section) noexcept
+    {
+        jassert (numSections < maxSections && juce::isPositiveAndBelow (slot, maxSections));
+        sections[numSections] = section;
+        slots[numSections] = (juce::uint8) slot;
+        numSections++;
+    }
+
+    BiquadCoefficients sections[maxSections];
+    juce::uint8 slots[maxSections] = {};
+    int numSections = 0;
+};
+
+//==============================================================================
+/**
+    Runs a CascadeCoefficients over a block of channels.
+
+    With four or more channels every section is run across the channels with the
+    channel-parallel kernels. With fewer channels there is nothing to fill the
+    registers with across channels, so groups of four sections are run band-
+    parallel instead: each lane holds one section, and lane k filters sample n - k
+    while lane k - 1 filters sample n - k + 1, so a section's output is picked up
+    by the next one on the following step. The lanes hold sections of different
+    forms, so they all run the general form of the equation; the result is
+    bit-identical to running the sections in turn through its scalar instance.
+    Sections in the state-variable topology split the groups and run channel-
+    parallel on their own.
+
+    That grouping is only done in channelParallel mode. In timeParallel mode each
+    section is run in turn across the time axis, by its BiquadEngine, with any
+    number of channels.
+*/
+class EQCascade
+{
+public:
+    EQCascade();
+
+    /** Allocates state for every slot, in float and in double. Call from prepareToPlay. */
+    void prepare (int maxNumChannels);
+
+    void reset() noexcept;
+
+    void setMode (BiquadEngine::Mode newMode) noexcept;
+    void setKernel (BiquadEngine::Kernel newKernel) noexcept;
+
+    /**
+        Keeps the delays of float audio in double, and runs the scalar double
+        kernel instead of the SIMD ones. Double audio always does. Only takes
+        effect from the next reset, as the float and double delays are separate.
+    */
+    void setUseDoubleState (bool shouldUseDoubleState) noexcept;
+    bool isUsingDoubleState() const noexcept                { return useDoubleState; }
+
+    /**
+        Sections that pass their input straight through (a peak or shelf at 0 dB)
+        are skipped, and their delays cleared so they start from silence when
+        they come back.
+    */
+    void process (float* const* channelData, int numChannels, int numSamples,
+                  const CascadeCoefficients& coefficients) noexcept;
+    void process (double* const* channelData, int numChannels, int numSamples,
+                  const CascadeCoefficients& coefficients) noexcept;
+
+    /** Runs every section with coefficients moving from start by increment each sample. */
+    void processRamp (float* const* channelData, int numChannels, int numSamples,
+                      const CascadeCoefficients& start, const CascadeCoefficients& increments) noexcept;
+    void processRamp (double* const* channelData, int numChannels, int numSamples,
+                      const CascadeCoefficients& start, const CascadeCoefficients& increments) noexcept;
+
+    /**
+        Filters interleaved frames in place, in any InterleavedAudio format, with
+        the same delays as process(). Each frame is converted to float in
+        registers, run through every section and converted back before the next
+        one is read, so the data is read and written once and nothing is copied.
+        Groups of 4 channels share a SIMD register, and the channels left over
+        run band-parallel through every section at once, or one section after
+        another when any of them is a state-variable filter. The sections all
+        run the general form of the equation, so with 4 or more channels the
+        output can differ from process() by rounding.
+    */
+    void processInterleaved (void* data, InterleavedAudio::Format format, int numChannels, int numFrames,
+                             const CascadeCoefficients& coefficients) noexcept;
+
+    /** True if every delay of the sections last run is below threshold on the first numChannels channels. */
+    bool hasDecayedBelow (float threshold, int numChannels) const noexcept;
+
+private:
+    /** The sections that need running, or coefficients itself when none can be skipped. */
+    const CascadeCoefficients& withoutIdentities (const CascadeCoefficients& coefficients, int numChannels,
+                                                  bool isUsingDoubleState) noexcept;
+    bool hasSettledToIdentity (int slot, int numChannels, bool isUsingDoubleState) const noexcept;
+
+    void updateActiveSlots (const CascadeCoefficients& coefficients) noexcept;
+
+    template <typename SampleType>
+    void processWithDoubleState (SampleType* const* channelData, int numChannels, int numSamples,
+                                 const CascadeCoefficients& coefficients) noexcept;
+
+    template <typename SampleType>
+    void processRampWithDoubleState (SampleType* const* channelData, int numChannels, int numSamples,
+                                     const CascadeCoefficients& start, const CascadeCoefficients& increments) noexcept;
+
+    /** x[n-1], x[n-2], z[n-1], z[n-2] of one channel of one slot. */
+    double* getDoubleState (int slot, int channel) noexcept               { return doubleState + (slot * maxChannels + channel) * 4; }
+    const double* getDoubleState (int slot, int channel) const noexcept   { return doubleState + (slot * maxChannels + channel) * 4; }
+
+    /** Up to four direct-form sections, from firstSection on, one per lane. */
+    void processBandParallel (float* data, int channel, const CascadeCoefficients& coefficients,
+                              int firstSection, int numSections, int numSamples) noexcept;
+
+    template <InterleavedAudio::Format format>
+    void processInterleavedFormat (char* data, int numChannels, int numFrames,
+                                   const CascadeCoefficients& sections) noexcept;
+
+    BiquadEngine slots[CascadeCoefficients::maxSections];
+    BiquadEngine::Kernel kernel;
+    BiquadEngine::Mode mode = BiquadEngine::Mode::channelParallel;
+    juce::uint64 activeSlots = 0;
+    juce::uint64 stateVariableSlots = 0;
+
+    CascadeCoefficients nonIdentitySections;
+
+    juce::HeapBlock<double> doubleState;
+    int maxChannels = 0;
+    bool useDoubleState = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQCascade)
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Polynomial approximations of the transcendental functions used by the
+    filter designs. They are branch-free apart from the final selects, so a
+    loop that designs several bands can be vectorised by the compiler.
+
+    Measured against the double precision library functions:
+
+        pow10 (x)   x in [-4, 4]          relative error < 1.1e-7
+        log2 (x)    normal floats         error < 1e-7, absolute below 1
+                                          and relative above
+        tan (x)     |x| < 64, |cos x|     relative error < 1.9e-7
+                    above 1e-3
+
+    All are within a few float ulps, which is below the rounding the
+    coefficients get when they are stored as float.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace FastMath
+{
+    /** 2^x, for |x| < 126. The split into whole and fractional parts is done in double precision. */
+    inline float exp2 (double x) noexcept
+    {
+        // floor (x + 0.5) by truncating a positive number, as std::floor is a library call without SSE4.1
+        auto rounded = (double) ((juce::int32) (x + 128.5) - 128);
+        auto f = (float) (x - rounded);    // [-0.5, 0.5]
+
+        // Minimax polynomial for 2^f - 1 (Cephes exp2f)
+        auto p = ((((( 1.535336188319500e-4f  * f
+                     + 1.339887440266574e-3f) * f
+                     + 9.618437357674640e-3f) * f
+                     + 5.550332471162809e-2f) * f
+                     + 2.402264791363012e-1f) * f
+                     + 6.931472028550421e-1f) * f;
+
+        // Put the integer part straight into the exponent
+        auto bits = (juce::int32) ((juce::int32) rounded + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+
+        return (1.0f + p) * scale;
+    }
+
+    /** log2 (x) for positive, normal x, e.g. a level turned into dB / 6.02. */
+    inline float log2 (float x) noexcept
+    {
+        juce::int32 bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+
+        // Split off the exponent, leaving the mantissa in [sqrt (1/2), sqrt (2))
+        auto exponent = ((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x007fffff) | 0x3f800000;
+
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+
+        auto isHigh = m > 1.41421356f;
+        m = isHigh ? m * 0.5f : m;
+        exponent += isHigh ? 1 : 0;
+
+        auto f = m - 1.0f;
+        auto z = f * f;
+
+        // Minimax polynomial for log (1 + f) (Cephes logf)
+        auto p = (((((((( 7.0376836292e-2f  * f
+                        - 1.1514610310e-1f) * f
+                        + 1.1676998740e-1f) * f
+                        - 1.2420140846e-1f) * f
+                        + 1.4249322787e-1f) * f
+                        - 1.6668057665e-1f) * f
+                        + 2.0000714765e-1f) * f
+                        - 2.4999993993e-1f) * f
+                        + 3.3333331174e-1f) * f * z;
+
+        return (f - 0.5f * z + p) * 1.442695041f + (float) exponent;
+    }
+
+    /** 10^x, e.g. a gain in dB / 20. */
+    inline float pow10 (float x) noexcept
+    {
+        return exp2 ((double) x * 3.321928094887362);
+    }
+
+    /** tan (x). The argument is reduced to [-pi/4, pi/4] in double precision first. */
+    inline float tan (float x) noexcept
+    {
+        // Rounded by truncating a positive number, as in exp2; |x| < 64 keeps it above zero
+        auto quadrant = (juce::int32) ((double) x * (2.0 / juce::MathConstants<double>::pi) + 64.5) - 64;
+        auto y = (float) ((double) x - (double) quadrant * juce::MathConstants<double>::halfPi);
+        auto z = y * y;
+
+        // Minimax polynomial for tan on [-pi/4, pi/4] (Cephes tanf)
+        auto t = ((((( 9.38540185543e-3f  * z
+                     + 3.11992232697e-3f) * z
+                     + 2.44301354525e-2f) * z
+                     + 5.34112807005e-2f) * z
+                     + 1.33387994085e-1f) * z
+                     + 3.33331568548e-1f) * z * y + y;
+
+        // tan (y + pi/2) = -1 / tan (y)
+        return (quadrant & 1) != 0 ? -1.0f / t : t;
+    }
+}
@@ -0,0 +1,312 @@
+/*
+  ==============================================================================
+
+    FilterDesign.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "FilterDesign.h"
+#include "FastMath.h"
+
+namespace FilterDesign
+{
+    juce::StringArray getBandTypeNames()
+    {
+        return { "Peak", "Low Shelf", "High Shelf", "High Pass", "Low Pass" };
+    }
+
+    juce::StringArray getSlopeNames()
+    {
+        return { "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct" };
+    }
+
+    //==============================================================================
+    FrequencyTable::FrequencyTable (double rate)
+        : sampleRate (rate)
+    {
+        entries.resize ((size_t) maxFrequency + 1);
+
+        for (int frequency = 0; frequency <= maxFrequency; frequency++)
+        {
+            auto w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+            entries[(size_t) frequency] = { std::cos (w0), std::sin (w0) };
+        }
+    }
+
+    std::shared_ptr<const FrequencyTable> FrequencyTable::getFor (double sampleRate)
+    {
+        static juce::CriticalSection lock;
+        static std::vector<std::weak_ptr<const FrequencyTable>> tables;
+
+        const juce::ScopedLock sl (lock);
+
+        for (auto& weak : tables)
+            if (auto table = weak.lock())
+                if (table->sampleRate == sampleRate)
+                    return table;
+
+        tables.erase (std::remove_if (tables.begin(), tables.end(), [] (const auto& weak) { return weak.expired(); }),
+                      tables.end());
+
+        auto table = std::make_shared<const FrequencyTable> (sampleRate);
+        tables.push_back (table);
+        return table;
+    }
+
+    double FrequencyTable::getCos (int frequency) const noexcept
+    {
+        if (juce::isPositiveAndNotGreaterThan (frequency, maxFrequency))
+            return entries[(size_t) frequency].cos;
+
+        return std::cos (juce::MathConstants<double>::twoPi * frequency / sampleRate);
+    }
+
+    double FrequencyTable::getSin (int frequency) const noexcept
+    {
+        if (juce::isPositiveAndNotGreaterThan (frequency, maxFrequency))
+            return entries[(size_t) frequency].sin;
+
+        return std::sin (juce::MathConstants<double>::twoPi * frequency / sampleRate);
+    }
+
+    //==============================================================================
+    /*
+        The response a design intends, (n0 + n1 z^-1 + n2 z^-2) / (1 + d1 z^-1 + d2 z^-2)
+        in double, before its coefficients are rounded to float for the direct form.
+    */
+    struct TransferFunction
+    {
+        double n0 = 1.0, n1 = 0.0, n2 = 0.0, d1 = 0.0, d2 = 0.0;
+    };
+
+    static BiquadCoefficients designPeak (int frequencyValue, float gainValue, float qValue, const FrequencyTable& table,
+                                          TransferFunction& exact)
+    {
+        BiquadCoefficients c;
+        
+        float theta = 2 * M_PI * frequencyValue / table.getSampleRate();
+        float mu = FastMath::pow10(gainValue / 20.0f);
+        float xi = 4 / (1 + mu);
+        float t = FastMath::tan(theta / (2 * qValue));
+        float beta = 0.5 * ((1 - xi * t) / (1 + xi * t));
+        float gamma = (0.5 + beta) * table.getCos(frequencyValue);
+        
+        c.a0 = 0.5 - beta;
+        c.a1 = 0.0;
+        c.a2 = -1 * (0.5 - beta);
+        c.b1 = -2 * gamma;
+        c.b2 = 2 * beta;
+        c.c0 = mu - 1.0;
+        c.d0 = 1.0;
+
+        // The same design from the same gain and bandwidth terms, without rounding beta and gamma
+        auto exactBeta = 0.5 * ((1.0 - (double) xi * t) / (1.0 + (double) xi * t));
+        auto wet = ((double) mu - 1.0) * (0.5 - exactBeta);
+
+        exact.d1 = -2.0 * (0.5 + exactBeta) * table.getCos (frequencyValue);
+        exact.d2 = 2.0 * exactBeta;
+        exact.n0 = 1.0 + wet;
+        exact.n1 = exact.d1;
+        exact.n2 = exact.d2 - wet;
+        
+        return c;
+    }
+
+    /*
+        The remaining types use the standard b/a form, normalised by a0 and mapped onto
+        the processor's difference equation with the wet path only (c0 = 1, d0 = 0).
+    */
+    static BiquadCoefficients fromDirectForm (double b0, double b1, double b2, double a0, double a1, double a2,
+                                              TransferFunction& exact)
+    {
+        BiquadCoefficients c;
+
+        exact = { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+
+        c.a0 = (float) (b0 / a0);
+        c.a1 = (float) (b1 / a0);
+        c.a2 = (float) (b2 / a0);
+        c.b1 = (float) (a1 / a0);
+        c.b2 = (float) (a2 / a0);
+        c.c0 = 1.0f;
+        c.d0 = 0.0f;
+
+        return c;
+    }
+
+    static BiquadCoefficients designShelf (bool isLowShelf, int frequencyValue, float gainValue, float qValue,
+                                           const FrequencyTable& table, TransferFunction& exact)
+    {
+        auto A = (double) FastMath::pow10 (gainValue / 40.0f);
+        auto cosw = table.getCos (frequencyValue);
+        auto twoSqrtAAlpha = 2.0 * std::sqrt (A) * table.getSin (frequencyValue) / (2.0 * qValue);
+
+        if (isLowShelf)
+            return fromDirectForm (A * ((A + 1) - (A - 1) * cosw + twoSqrtAAlpha),
+                                   2 * A * ((A - 1) - (A + 1) * cosw),
+                                   A * ((A + 1) - (A - 1) * cosw - twoSqrtAAlpha),
+                                   (A + 1) + (A - 1) * cosw + twoSqrtAAlpha,
+                                   -2 * ((A - 1) + (A + 1) * cosw),
+                                   (A + 1) + (A - 1) * cosw - twoSqrtAAlpha, exact);
+
+        return fromDirectForm (A * ((A + 1) + (A - 1) * cosw + twoSqrtAAlpha),
+                               -2 * A * ((A - 1) + (A + 1) * cosw),
+                               A * ((A + 1) + (A - 1) * cosw - twoSqrtAAlpha),
+                               (A + 1) - (A - 1) * cosw + twoSqrtAAlpha,
+                               2 * ((A - 1) - (A + 1) * cosw),
+                               (A + 1) - (A - 1) * cosw - twoSqrtAAlpha, exact);
+    }
+
+    static BiquadCoefficients designPass (bool isHighPass, int frequencyValue, double qValue, const FrequencyTable& table,
+                                          TransferFunction& exact)
+    {
+        auto cosw = table.getCos (frequencyValue);
+        auto alpha = table.getSin (frequencyValue) / (2.0 * qValue);
+
+        if (isHighPass)
+            return fromDirectForm ((1 + cosw) / 2, -(1 + cosw), (1 + cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha, exact);
+
+        return fromDirectForm ((1 - cosw) / 2, 1 - cosw, (1 - cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha, exact);
+    }
+
+    //==============================================================================
+    /*
+        Matches the bilinear state-variable filter to a stable response: its
+        denominator fixes g and k, and the numerator then fixes the mix of x, v1
+        and v2 (see BiquadCoefficients::getTransferFunction). Leaves the section
+        in the direct form if the poles aren't a pair the filter can take.
+    */
+    static void moveToStateVariable (BiquadCoefficients& section, const TransferFunction& h) noexcept
+    {
+        auto atDC = 1.0 + h.d1 + h.d2;
+        auto atNyquist = 1.0 - h.d1 + h.d2;
+
+        if (atDC <= 0.0 || atNyquist <= 0.0 || h.d2 >= 1.0)
+            return;
+
+        auto g = std::sqrt (atDC / atNyquist);
+        auto k = 2.0 * (1.0 - h.d2) / (atNyquist * g);
+        auto scale = 4.0 / atNyquist;
+
+        auto outputX = scale * (h.n0 - h.n1 + h.n2) / 4.0;
+        auto outputV2 = (scale * h.n1 - 2.0 * outputX * (g * g - 1.0)) / (2.0 * g * g);
+        auto outputV1 = (scale * (h.n0 - h.n2) - 2.0 * outputX * g * k) / (2.0 * g);
+
+        section.topology = BiquadCoefficients::Topology::stateVariable;
+        section.stateVariable = { (float) g, (float) k, (float) outputX, (float) outputV1, (float) outputV2 };
+    }
+
+    double estimateDirectFormNoise (const BiquadCoefficients& section) noexcept
+    {
+        auto b1 = (double) section.b1, b2 = (double) section.b2;
+
+        // Noise gain of 1 / (1 + b1 z^-1 + b2 z^-2): the sum of the squared impulse response
+        auto noiseGain = (1.0 + b2) / ((1.0 - b2) * ((1.0 + b2) * (1.0 + b2) - b1 * b1));
+
+        if (! (noiseGain > 0.0) || ! std::isfinite (noiseGain))
+            return std::numeric_limits<double>::infinity();
+
+        auto zAtDC = std::abs (((double) section.a0 + section.a1 + section.a2) / (1.0 + b1 + b2));
+        auto zAtNyquist = std::abs (((double) section.a0 - section.a1 + section.a2) / (1.0 - b1 + b2));
+        auto level = juce::jmax (1.0, zAtDC, zAtNyquist);
+
+        // Rounding z[n] to float adds noise of the order of 2^-24 of its level every step
+        constexpr double floatEpsilon = 1.0 / 16777216.0;
+
+        return floatEpsilon * std::sqrt (noiseGain) * std::abs ((double) section.c0) * level;
+    }
+
+    //==============================================================================
+    // An order 2N Butterworth response is N sections with Q = 1 / (2 sin ((2k + 1) pi / 4N))
+    struct ButterworthQs
+    {
+        ButterworthQs()
+        {
+            for (int numSections = 1; numSections <= maxSectionsPerBand; numSections++)
+                for (int k = 0; k < numSections; k++)
+                    q[numSections - 1][k] = 1.0 / (2.0 * std::sin ((2 * k + 1) * juce::MathConstants<double>::pi / (4 * numSections)));
+        }
+
+        double q[maxSectionsPerBand][maxSectionsPerBand] = {};
+    };
+
+    int designBand (const BandSettings& settings, const FrequencyTable& table, BiquadCoefficients* sections,
+                    double noiseTarget)
+    {
+        static const ButterworthQs butterworth;
+
+        TransferFunction exact[maxSectionsPerBand];
+        int numSections = 1;
+
+        switch (settings.type)
+        {
+            case BandType::lowShelf:
+            case BandType::highShelf:
+                sections[0] = designShelf (settings.type == BandType::lowShelf, settings.frequency, settings.gain, settings.q,
+                                           table, exact[0]);
+                break;
+
+            case BandType::highPass:
+            case BandType::lowPass:
+                numSections = (int) settings.slope + 1;
+
+                for (int k = 0; k < numSections; k++)
+                    sections[k] = designPass (settings.type == BandType::highPass, settings.frequency,
+                                              butterworth.q[numSections - 1][k], table, exact[k]);
+                break;
+
+            case BandType::peak:
+            default:
+            {
+                auto q = juce::jmax (settings.q, (float) getLowestPeakQ (settings.frequency, table.getSampleRate()));
+                sections[0] = designPeak (settings.frequency, settings.gain, q, table, exact[0]);
+                break;
+            }
+        }
+
+        // Sections at 0 dB are skipped by the cascade in the direct form, so they stay there
+        for (int k = 0; k < numSections; k++)
+        {
+            auto& section = sections[k];
+
+            if (! section.isIdentity() && ! section.hasMatchingPolesAndZeros()
+                 && estimateDirectFormNoise (section) > noiseTarget)
+                moveToStateVariable (section, exact[k]);
+        }
+
+        return numSections;
+    }
+
+    int designBand (const BandSettings& settings, double sampleRate, BiquadCoefficients* sections, double noiseTarget)
+    {
+        return designBand (settings, *FrequencyTable::getFor (sampleRate), sections, noiseTarget);
+    }
+
+    double getMinimumStableQ (double frequency, double sampleRate) noexcept
+    {
+        // w0 / Q < pi, with w0 = 2 pi f / fs
+        return 2.0 * frequency / sampleRate;
+    }
+
+    double getLowestPeakQ (double frequency, double sampleRate) noexcept
+    {
+        return 1.01 * getMinimumStableQ (frequency, sampleRate);
+    }
+
+    double getPoleRadius (const BiquadCoefficients& section) noexcept
+    {
+        // Roots of p^2 + b1 p + b2
+        auto b1 = (double) section.b1;
+        auto b2 = (double) section.b2;
+        auto discriminant = b1 * b1 - 4.0 * b2;
+
+        if (discriminant < 0.0)
+            return std::sqrt (b2);
+
+        auto root = std::sqrt (discriminant);
+        return juce::jmax (std::abs (-b1 + root), std::abs (-b1 - root)) * 0.5;
+    }
+}
@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    FilterDesign.h
+
+    Band settings and the second-order-section designs for each band type.
+    The peaking band is the original single-band design from
+    updateCoefficients(); the other types are built from the same
+    BiquadCoefficients form so they can share the cascade.
+
+    The frequency dependent terms come from a table shared by every instance
+    at the same sample rate, and gain and Q go through the approximations in
+    FastMath.h, so a redesign costs no library transcendental calls.
+
+    Each section is designed in the direct form, and moved to the state-
+    variable topology when an estimate of the direct form's float rounding
+    noise misses the noise target: in practice the bands below a few hundred
+    Hz at high rates or high Q. Everything else stays in the cheaper direct
+    form.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+
+namespace FilterDesign
+{
+    constexpr int maxBands = 16;
+
+    /** The frequency parameters are whole numbers of Hz up to this. */
+    constexpr int maxFrequency = 20000;
+
+    /** A 48 dB/oct Butterworth filter needs four second-order sections. */
+    constexpr int maxSectionsPerBand = 4;
+
+    enum class BandType
+    {
+        peak = 0,
+        lowShelf,
+        highShelf,
+        highPass,
+        lowPass
+    };
+
+    /** Slopes for the high and low pass types, in steps of 12 dB/oct. */
+    enum class Slope
+    {
+        db12 = 0,
+        db24,
+        db36,
+        db48
+    };
+
+    /**
+        A band in dynamic mode leaves the cascade and is run by DynamicEQ, with
+        its gain following the level of the band instead of staying put.
+    */
+    struct DynamicSettings
+    {
+        bool enabled = false;
+        float threshold = -24.0f;   // dB
+        float ratio = 4.0f;
+        float attack = 5.0f;        // ms
+        float release = 100.0f;     // ms
+
+        bool operator== (const DynamicSettings& other) const noexcept
+        {
+            return enabled == other.enabled && threshold == other.threshold && ratio == other.ratio
+                && attack == other.attack && release == other.release;
+        }
+
+        bool operator!= (const DynamicSettings& other) const noexcept  { return ! operator== (other); }
+    };
+
+    struct BandSettings
+    {
+        bool enabled = false;
+        BandType type = BandType::peak;
+        int frequency = 1000;
+        float gain = 0.0f;
+        float q = 1.0f;
+        Slope slope = Slope::db12;
+        DynamicSettings dynamics;
+
+        /** Only the types with a gain can be dynamic; the high and low pass ignore the setting. */
+        bool isDynamic() const noexcept
+        {
+            return enabled && dynamics.enabled
+                && (type == BandType::peak || type == BandType::lowShelf || type == BandType::highShelf);
+        }
+
+        bool operator== (const BandSettings& other) const noexcept
+        {
+            return enabled == other.enabled && type == other.type && frequency == other.frequency
+                && gain == other.gain && q == other.q && slope == other.slope && dynamics == other.dynamics;
+        }
+
+        bool operator!= (const BandSettings& other) const noexcept     { return ! operator== (other); }
+    };
+
+    /**
+        cos and sin of w0 = 2 pi f / fs for every whole-Hz frequency the parameters
+        can take, at one sample rate. A table is built the first time an instance
+        asks for its sample rate and is then shared, read-only, by every instance
+        in the process until the last one lets go of it.
+    */
+    class FrequencyTable
+    {
+    public:
+        explicit FrequencyTable (double sampleRate);
+
+        /** Finds or builds the table for a sample rate. This allocates, so call it from prepareToPlay. */
+        static std::shared_ptr<const FrequencyTable> getFor (double sampleRate);
+
+        double getSampleRate() const noexcept                   { return sampleRate; }
+
+        /** Frequencies outside the table fall back to std::cos and std::sin. */
+        double getCos (int frequency) const noexcept;
+        double getSin (int frequency) const noexcept;
+
+    private:
+        struct Entry
+        {
+            double cos, sin;
+        };
+
+        double sampleRate;
+        std::vector<Entry> entries;
+
+        JUCE_DECLARE_NON_COPYABLE (FrequencyTable)
+    };
+
+    /**
+        The rounding noise a section may add to full-scale input before it is
+        run as a state-variable filter, as an RMS level relative to full scale.
+        1e-5 is -100 dB, under the noise floor of 16-bit audio and well above
+        the float state-variable filter's own noise.
+    */
+    constexpr double defaultNoiseTarget = 1.0e-5;
+
+    /** Names shown by the host for the band type and slope choices. */
+    juce::StringArray getBandTypeNames();
+    juce::StringArray getSlopeNames();
+
+    /**
+        Designs the sections for one band and returns how many were written
+        (between 1 and maxSectionsPerBand). The Q setting is ignored by the
+        high and low pass types, which are always Butterworth.
+
+        A section whose estimated direct-form noise is above noiseTarget gets
+        the state-variable topology. 0 moves every section that can be, and
+        infinity keeps them all in the direct form.
+    */
+    int designBand (const BandSettings& settings, const FrequencyTable& table, BiquadCoefficients* sections,
+                    double noiseTarget = defaultNoiseTarget);
+
+    /** Same as above, looking the table up first. */
+    int designBand (const BandSettings& settings, double sampleRate, BiquadCoefficients* sections,
+                    double noiseTarget = defaultNoiseTarget);
+
+    /**
+        A cheap estimate of the RMS rounding noise the float direct form adds to
+        full-scale input: the rounding of z[n] amplified by the noise gain of the
+        poles, scaled to the output and by the larger of the section's gain at
+        DC and at Nyquist, which sets how large z[n] gets. Against measurements
+        over 20 Hz-20 kHz at 44.1-192 kHz it is within about 10 dB for shelves and
+        passes, and errs high for peaks.
+    */
+    double estimateDirectFormNoise (const BiquadCoefficients& section) noexcept;
+
+    /**
+        The largest magnitude of the section's poles. The impulse response decays
+        by this factor every sample, so it sets how long the section rings.
+    */
+    double getPoleRadius (const BiquadCoefficients& section) noexcept;
+
+    /**
+        The Q a peak at this frequency has to stay above to be stable. The design
+        takes tan (w0 / 2Q), which passes through infinity as w0 / Q reaches pi,
+        and from there the poles are outside the unit circle: Q 0.3 would be
+        unstable above about 6.6 kHz at 44.1 kHz.
+    */
+    double getMinimumStableQ (double frequency, double sampleRate) noexcept;
+
+    /**
+        The lowest Q a peak is designed with at this frequency, 1% over
+        getMinimumStableQ, where the tangent is about 64. designBand raises
+        lower settings to it, so every Q the parameters allow gives a stable
+        section; at 20 kHz and 44.1 kHz its poles are still within 0.9998.
+    */
+    double getLowestPeakQ (double frequency, double sampleRate) noexcept;
+}
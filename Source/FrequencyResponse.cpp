@@ -0,0 +1,273 @@
+/*
+  ==============================================================================
+
+    FrequencyResponse.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "FrequencyResponse.h"
+#include "BiquadSIMD.h"
+
+namespace
+{
+    using SectionTerms = FrequencyResponse::SectionTerms;
+
+    /*
+        response *= (n0 + n1 u + n2 u^2) / (d0 + d1 u + d2 u^2) for every section,
+        as a multiply by the numerator and then by the conjugate of the denominator
+        over its squared magnitude.
+    */
+    void evaluateScalar (const SectionTerms* terms, int numSections, const float* uReal, const float* uImag,
+                         const float* u2Real, const float* u2Imag, float* real, float* imag, int numPoints) noexcept
+    {
+        for (int point = 0; point < numPoints; point++)
+        {
+            auto hr = 1.0f, hi = 0.0f;
+
+            for (int s = 0; s < numSections; s++)
+            {
+                const auto& t = terms[s];
+                auto nr = t.n0 + t.n1 * uReal[point] + t.n2 * u2Real[point];
+                auto ni = t.n1 * uImag[point] + t.n2 * u2Imag[point];
+                auto dr = t.d0 + t.d1 * uReal[point] + t.d2 * u2Real[point];
+                auto di = t.d1 * uImag[point] + t.d2 * u2Imag[point];
+
+                auto pr = hr * nr - hi * ni;
+                auto pi = hr * ni + hi * nr;
+                auto scale = 1.0f / (dr * dr + di * di);
+
+                hr = (pr * dr + pi * di) * scale;
+                hi = (pi * dr - pr * di) * scale;
+            }
+
+            real[point] = hr;
+            imag[point] = hi;
+        }
+    }
+
+   #if JUCE_INTEL
+    EQ1_TARGET_SSE2 void evaluateSSE2 (const SectionTerms* terms, int numSections, const float* uReal, const float* uImag,
+                                       const float* u2Real, const float* u2Imag, float* real, float* imag, int numPoints) noexcept
+    {
+        int point = 0;
+
+        for (; point + 4 <= numPoints; point += 4)
+        {
+            auto ur = _mm_load_ps (uReal + point), ui = _mm_load_ps (uImag + point);
+            auto u2r = _mm_load_ps (u2Real + point), u2i = _mm_load_ps (u2Imag + point);
+            auto hr = _mm_set1_ps (1.0f), hi = _mm_setzero_ps();
+
+            for (int s = 0; s < numSections; s++)
+            {
+                const auto& t = terms[s];
+                auto n1 = _mm_set1_ps (t.n1), n2 = _mm_set1_ps (t.n2);
+                auto d1 = _mm_set1_ps (t.d1), d2 = _mm_set1_ps (t.d2);
+
+                auto nr = _mm_add_ps (_mm_add_ps (_mm_set1_ps (t.n0), _mm_mul_ps (n1, ur)), _mm_mul_ps (n2, u2r));
+                auto ni = _mm_add_ps (_mm_mul_ps (n1, ui), _mm_mul_ps (n2, u2i));
+                auto dr = _mm_add_ps (_mm_add_ps (_mm_set1_ps (t.d0), _mm_mul_ps (d1, ur)), _mm_mul_ps (d2, u2r));
+                auto di = _mm_add_ps (_mm_mul_ps (d1, ui), _mm_mul_ps (d2, u2i));
+
+                auto pr = _mm_sub_ps (_mm_mul_ps (hr, nr), _mm_mul_ps (hi, ni));
+                auto pi = _mm_add_ps (_mm_mul_ps (hr, ni), _mm_mul_ps (hi, nr));
+                auto scale = _mm_div_ps (_mm_set1_ps (1.0f), _mm_add_ps (_mm_mul_ps (dr, dr), _mm_mul_ps (di, di)));
+
+                hr = _mm_mul_ps (_mm_add_ps (_mm_mul_ps (pr, dr), _mm_mul_ps (pi, di)), scale);
+                hi = _mm_mul_ps (_mm_sub_ps (_mm_mul_ps (pi, dr), _mm_mul_ps (pr, di)), scale);
+            }
+
+            _mm_store_ps (real + point, hr);
+            _mm_store_ps (imag + point, hi);
+        }
+
+        evaluateScalar (terms, numSections, uReal + point, uImag + point, u2Real + point, u2Imag + point,
+                        real + point, imag + point, numPoints - point);
+    }
+
+    EQ1_TARGET_AVX2 void evaluateAVX2 (const SectionTerms* terms, int numSections, const float* uReal, const float* uImag,
+                                       const float* u2Real, const float* u2Imag, float* real, float* imag, int numPoints) noexcept
+    {
+        int point = 0;
+
+        for (; point + 8 <= numPoints; point += 8)
+        {
+            auto ur = _mm256_load_ps (uReal + point), ui = _mm256_load_ps (uImag + point);
+            auto u2r = _mm256_load_ps (u2Real + point), u2i = _mm256_load_ps (u2Imag + point);
+            auto hr = _mm256_set1_ps (1.0f), hi = _mm256_setzero_ps();
+
+            for (int s = 0; s < numSections; s++)
+            {
+                const auto& t = terms[s];
+                auto n1 = _mm256_set1_ps (t.n1), n2 = _mm256_set1_ps (t.n2);
+                auto d1 = _mm256_set1_ps (t.d1), d2 = _mm256_set1_ps (t.d2);
+
+                auto nr = _mm256_add_ps (_mm256_add_ps (_mm256_set1_ps (t.n0), _mm256_mul_ps (n1, ur)), _mm256_mul_ps (n2, u2r));
+                auto ni = _mm256_add_ps (_mm256_mul_ps (n1, ui), _mm256_mul_ps (n2, u2i));
+                auto dr = _mm256_add_ps (_mm256_add_ps (_mm256_set1_ps (t.d0), _mm256_mul_ps (d1, ur)), _mm256_mul_ps (d2, u2r));
+                auto di = _mm256_add_ps (_mm256_mul_ps (d1, ui), _mm256_mul_ps (d2, u2i));
+
+                auto pr = _mm256_sub_ps (_mm256_mul_ps (hr, nr), _mm256_mul_ps (hi, ni));
+                auto pi = _mm256_add_ps (_mm256_mul_ps (hr, ni), _mm256_mul_ps (hi, nr));
+                auto scale = _mm256_div_ps (_mm256_set1_ps (1.0f), _mm256_add_ps (_mm256_mul_ps (dr, dr), _mm256_mul_ps (di, di)));
+
+                hr = _mm256_mul_ps (_mm256_add_ps (_mm256_mul_ps (pr, dr), _mm256_mul_ps (pi, di)), scale);
+                hi = _mm256_mul_ps (_mm256_sub_ps (_mm256_mul_ps (pi, dr), _mm256_mul_ps (pr, di)), scale);
+            }
+
+            _mm256_store_ps (real + point, hr);
+            _mm256_store_ps (imag + point, hi);
+        }
+
+        // The compiler doesn't clear the upper halves for a function with a target attribute, and the SSE code after this would stall on them
+        _mm256_zeroupper();
+
+        evaluateSSE2 (terms, numSections, uReal + point, uImag + point, u2Real + point, u2Imag + point,
+                      real + point, imag + point, numPoints - point);
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    void evaluateNEON (const SectionTerms* terms, int numSections, const float* uReal, const float* uImag,
+                       const float* u2Real, const float* u2Imag, float* real, float* imag, int numPoints) noexcept
+    {
+        int point = 0;
+
+        for (; point + 4 <= numPoints; point += 4)
+        {
+            auto ur = vld1q_f32 (uReal + point), ui = vld1q_f32 (uImag + point);
+            auto u2r = vld1q_f32 (u2Real + point), u2i = vld1q_f32 (u2Imag + point);
+            auto hr = vdupq_n_f32 (1.0f), hi = vdupq_n_f32 (0.0f);
+
+            for (int s = 0; s < numSections; s++)
+            {
+                const auto& t = terms[s];
+
+                auto nr = vmlaq_n_f32 (vmlaq_n_f32 (vdupq_n_f32 (t.n0), ur, t.n1), u2r, t.n2);
+                auto ni = vmlaq_n_f32 (vmulq_n_f32 (ui, t.n1), u2i, t.n2);
+                auto dr = vmlaq_n_f32 (vmlaq_n_f32 (vdupq_n_f32 (t.d0), ur, t.d1), u2r, t.d2);
+                auto di = vmlaq_n_f32 (vmulq_n_f32 (ui, t.d1), u2i, t.d2);
+
+                auto pr = vmlsq_f32 (vmulq_f32 (hr, nr), hi, ni);
+                auto pi = vmlaq_f32 (vmulq_f32 (hr, ni), hi, nr);
+
+                // Reciprocal estimate and two Newton steps, as ARMv7 has no vector divide
+                auto squared = vmlaq_f32 (vmulq_f32 (dr, dr), di, di);
+                auto scale = vrecpeq_f32 (squared);
+                scale = vmulq_f32 (scale, vrecpsq_f32 (squared, scale));
+                scale = vmulq_f32 (scale, vrecpsq_f32 (squared, scale));
+
+                hr = vmulq_f32 (vmlaq_f32 (vmulq_f32 (pr, dr), pi, di), scale);
+                hi = vmulq_f32 (vmlsq_f32 (vmulq_f32 (pi, dr), pr, di), scale);
+            }
+
+            vst1q_f32 (real + point, hr);
+            vst1q_f32 (imag + point, hi);
+        }
+
+        evaluateScalar (terms, numSections, uReal + point, uImag + point, u2Real + point, u2Imag + point,
+                        real + point, imag + point, numPoints - point);
+    }
+   #endif
+
+    /** p0 + p1 z^-1 + p2 z^-2 with z^-1 = 1 + u, as q0 + q1 u + q2 u^2. */
+    void toPowersOfU (double p0, double p1, double p2, float& q0, float& q1, float& q2) noexcept
+    {
+        q0 = (float) (p0 + p1 + p2);
+        q1 = (float) (p1 + 2.0 * p2);
+        q2 = (float) p2;
+    }
+}
+
+//==============================================================================
+FrequencyResponse::FrequencyResponse()
+    : simdKernel (BiquadEngine::getBestAvailableKernel())
+{
+}
+
+double FrequencyResponse::getPointFrequency (int point) noexcept
+{
+    return 20.0 * std::pow (1000.0, point / (double) (numPoints - 1));
+}
+
+void FrequencyResponse::prepare (double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    numValidPoints = 0;
+
+    while (numValidPoints < numPoints && getPointFrequency (numValidPoints) < sampleRate / 2.0)
+        numValidPoints++;
+
+    for (int point = 0; point < numPoints; point++)
+    {
+        auto w = juce::MathConstants<double>::twoPi * juce::jmin (getPointFrequency (point), sampleRate / 2.0) / sampleRate;
+
+        // e^-jw - 1, with the real part as -2 sin^2 (w / 2) so it keeps its precision near DC
+        auto halfSine = std::sin (w / 2.0);
+        auto real = -2.0 * halfSine * halfSine;
+        auto imag = -std::sin (w);
+
+        uReal[point] = (float) real;
+        uImag[point] = (float) imag;
+        uSquaredReal[point] = (float) (real * real - imag * imag);
+        uSquaredImag[point] = (float) (2.0 * real * imag);
+    }
+}
+
+void FrequencyResponse::evaluate (const CascadeCoefficients& coefficients, float* magnitudeDecibels, float* phaseRadians) noexcept
+{
+    jassert (sampleRate > 0.0);
+
+    // The product underflows far down the slopes of steep high and low passes
+    juce::ScopedNoDenormals noDenormals;
+
+    int numSections = 0;
+
+    for (int i = 0; i < coefficients.numSections; i++)
+    {
+        const auto& c = coefficients.sections[i];
+
+        if (c.isIdentity() || c.hasMatchingPolesAndZeros())
+            continue;
+
+        // The response of the topology the section runs in, as N(z) / D(z)
+        double n0, n1, n2, d1, d2;
+        c.getTransferFunction (n0, n1, n2, d1, d2);
+
+        auto& t = terms[numSections++];
+        toPowersOfU (n0, n1, n2, t.n0, t.n1, t.n2);
+        toPowersOfU (1.0, d1, d2, t.d0, t.d1, t.d2);
+    }
+
+    switch (simdKernel)
+    {
+       #if JUCE_INTEL
+        case BiquadEngine::Kernel::avx2:
+            evaluateAVX2 (terms, numSections, uReal, uImag, uSquaredReal, uSquaredImag, responseReal, responseImag, numValidPoints);
+            break;
+        case BiquadEngine::Kernel::sse2:
+            evaluateSSE2 (terms, numSections, uReal, uImag, uSquaredReal, uSquaredImag, responseReal, responseImag, numValidPoints);
+            break;
+       #endif
+       #if EQ1_HAS_NEON
+        case BiquadEngine::Kernel::neon:
+            evaluateNEON (terms, numSections, uReal, uImag, uSquaredReal, uSquaredImag, responseReal, responseImag, numValidPoints);
+            break;
+       #endif
+        default:
+            evaluateScalar (terms, numSections, uReal, uImag, uSquaredReal, uSquaredImag, responseReal, responseImag, numValidPoints);
+            break;
+    }
+
+    for (int point = 0; point < numValidPoints; point++)
+    {
+        auto real = responseReal[point];
+        auto imag = responseImag[point];
+
+        // Floored at -300 dB, for the zeros of a high-pass at DC
+        magnitudeDecibels[point] = 10.0f * std::log10 (juce::jmax (real * real + imag * imag, 1.0e-30f));
+        phaseRadians[point] = std::atan2 (imag, real);
+    }
+}
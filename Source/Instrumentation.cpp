@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    Instrumentation.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "Instrumentation.h"
+
+#if EQ1_INSTRUMENTATION
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace Instrumentation
+{
+   #if JUCE_ARM && (defined (__aarch64__) || defined (_M_ARM64))
+    #define EQ1_ARM64_REGISTERS (JUCE_GCC || JUCE_CLANG)
+   #else
+    #define EQ1_ARM64_REGISTERS 0
+   #endif
+
+    juce::uint64 readTicks() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #elif EQ1_ARM64_REGISTERS
+        juce::uint64 ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    double getTicksPerSecond()
+    {
+        static const double ticksPerSecond = []
+        {
+           #if JUCE_INTEL
+            // The time stamp counter runs at a fixed rate on anything recent, but nothing reports it, so it's timed
+            auto startTime = juce::Time::getHighResolutionTicks();
+            auto startTicks = readTicks();
+
+            while (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTime) < 0.02)
+                {}
+
+            auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTime);
+            return (double) (readTicks() - startTicks) / seconds;
+           #elif EQ1_ARM64_REGISTERS
+            juce::uint64 frequency;
+            asm volatile ("mrs %0, cntfrq_el0" : "=r" (frequency));
+            return (double) frequency;
+           #else
+            return (double) juce::Time::getHighResolutionTicksPerSecond();
+           #endif
+        }();
+
+        return ticksPerSecond;
+    }
+
+    /*
+        With flush-to-zero on, a denormal result still raises the underflow flag,
+        and a denormal operand the denormal flag, before it's flushed.
+    */
+    void clearDenormalFlags() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_setcsr (_mm_getcsr() & ~0x3fu);
+       #elif EQ1_ARM64_REGISTERS
+        juce::uint64 status;
+        asm volatile ("mrs %0, fpsr" : "=r" (status));
+        asm volatile ("msr fpsr, %0" : : "r" (status & ~(juce::uint64) 0x9f));
+       #endif
+    }
+
+    bool haveDenormalFlagsBeenRaised() noexcept
+    {
+       #if JUCE_INTEL
+        // Underflow and denormal operand
+        return (_mm_getcsr() & 0x12u) != 0;
+       #elif EQ1_ARM64_REGISTERS
+        // Input denormal and underflow
+        juce::uint64 status;
+        asm volatile ("mrs %0, fpsr" : "=r" (status));
+        return (status & 0x88) != 0;
+       #else
+        return false;
+       #endif
+    }
+
+    //==============================================================================
+    int Histogram::getBucket (juce::uint64 ticks) noexcept
+    {
+        if (ticks < (juce::uint64) bucketsPerOctave)
+            return (int) ticks;
+
+        // The position of the top bit, then the two bits below it
+       #if JUCE_MSVC
+        unsigned long topBit;
+        _BitScanReverse64 (&topBit, ticks);
+       #else
+        auto topBit = 63 - __builtin_clzll (ticks);
+       #endif
+
+        return bucketsPerOctave * ((int) topBit - 1) + (int) ((ticks >> (topBit - 2)) & 3);
+    }
+
+    juce::uint64 Histogram::getBucketEnd (int bucket) noexcept
+    {
+        if (bucket < bucketsPerOctave)
+            return (juce::uint64) bucket + 1;
+
+        auto topBit = bucket / bucketsPerOctave + 1;
+        return (juce::uint64) (bucketsPerOctave + bucket % bucketsPerOctave + 1) << (topBit - 2);
+    }
+
+    void Histogram::add (juce::uint64 ticks) noexcept
+    {
+        buckets[getBucket (ticks)].add();
+        count.add();
+        total.add (ticks);
+
+        if (ticks > longest.load (std::memory_order_relaxed))
+            longest.store (ticks, std::memory_order_relaxed);
+    }
+
+    juce::uint64 Histogram::getPercentile (double proportion) const noexcept
+    {
+        // The writer may be part way through an add, so the buckets are summed rather than trusting the count
+        juce::uint64 counts[numBuckets];
+        juce::uint64 sum = 0;
+
+        for (int i = 0; i < numBuckets; i++)
+            sum += (counts[i] = buckets[i].get());
+
+        if (sum == 0)
+            return 0;
+
+        auto target = (juce::uint64) std::ceil (proportion * (double) sum);
+        juce::uint64 seen = 0;
+
+        for (int i = 0; i < numBuckets; i++)
+        {
+            seen += counts[i];
+
+            if (seen >= target)
+                return juce::jmin (getBucketEnd (i), getMax());
+        }
+
+        return getMax();
+    }
+
+    //==============================================================================
+    juce::String ProcessorStats::getReport() const
+    {
+        auto microseconds = 1.0e6 / getTicksPerSecond();
+        juce::String report;
+
+        for (auto [name, histogram] : { std::make_pair ("processBlock", &processBlock),
+                                        std::make_pair ("updateCoefficients", &updateCoefficients) })
+        {
+            auto count = histogram->getCount();
+            auto mean = count > 0 ? (double) histogram->getTotal() / (double) count : 0.0;
+
+            report << juce::String (name).paddedRight (' ', 20) << juce::String ((juce::int64) count).paddedLeft (' ', 9) << " calls"
+                   << "  mean " << juce::String (mean * microseconds, 1)
+                   << "  p50 " << juce::String ((double) histogram->getPercentile (0.5) * microseconds, 1)
+                   << "  p99 " << juce::String ((double) histogram->getPercentile (0.99) * microseconds, 1)
+                   << "  max " << juce::String ((double) histogram->getMax() * microseconds, 1) << " us" << juce::newLine;
+        }
+
+        for (auto [name, counter] : { std::make_pair ("audio thread designs", &audioThreadDesigns),
+                                      std::make_pair ("skipped blocks", &skippedBlocks),
+                                      std::make_pair ("bypassed blocks", &bypassedBlocks),
+                                      std::make_pair ("denormal blocks", &denormalBlocks) })
+        {
+            report << juce::String (name).paddedRight (' ', 20) << juce::String ((juce::int64) counter->get()).paddedLeft (' ', 9) << juce::newLine;
+        }
+
+        return report;
+    }
+}
+
+#endif
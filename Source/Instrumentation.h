@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    Instrumentation.h
+
+    What each instance costs, measured from the inside: the time every
+    processBlock and updateCoefficients() call takes, read off the CPU's
+    cycle counter, and counts of the coefficient redesigns, of the blocks
+    skipped as silent or bypassed, and of the blocks that produced
+    denormals. Everything is recorded into per-instance histograms and
+    counters with plain atomic loads and stores, so the audio thread never
+    locks, allocates or waits on a reader; the editor's overlay and the
+    offline renderer read them whenever they like.
+
+    Debug builds have it; release builds compile all of it away. Define
+    EQ1_INSTRUMENTATION=1 to keep it in a release build, as the offline
+    renderer does, or 0 to drop it from a debug one.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef EQ1_INSTRUMENTATION
+ #define EQ1_INSTRUMENTATION JUCE_DEBUG
+#endif
+
+/** Wraps a statement that only exists in instrumented builds. */
+#if EQ1_INSTRUMENTATION
+ #define EQ1_INSTRUMENT(statement)  statement
+#else
+ #define EQ1_INSTRUMENT(statement)
+#endif
+
+#if EQ1_INSTRUMENTATION
+
+namespace Instrumentation
+{
+    /** The CPU's time stamp counter, or the nearest thing the platform has. A few tens of cycles. */
+    juce::uint64 readTicks() noexcept;
+
+    /** How fast readTicks() counts. The first call measures it, which takes 20 ms, so don't make it on the audio thread. */
+    double getTicksPerSecond();
+
+    /** Clears the floating point unit's sticky underflow and denormal flags on the calling thread. */
+    void clearDenormalFlags() noexcept;
+
+    /** True if anything since clearDenormalFlags() produced or read a denormal, even one flushed to zero. */
+    bool haveDenormalFlagsBeenRaised() noexcept;
+
+    //==============================================================================
+    /**
+        A count that one thread adds to and any thread reads. The add is a load
+        and a store rather than a locked read-modify-write, so a second writer
+        racing it can lose counts but never tear one.
+    */
+    class Counter
+    {
+    public:
+        void add (juce::uint64 amount = 1) noexcept
+        {
+            value.store (value.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        juce::uint64 get() const noexcept                   { return value.load (std::memory_order_relaxed); }
+
+    private:
+        std::atomic<juce::uint64> value { 0 };
+    };
+
+    //==============================================================================
+    /** Durations in ticks, in four buckets per doubling, with one writer. */
+    class Histogram
+    {
+    public:
+        static constexpr int bucketsPerOctave = 4;
+        static constexpr int numBuckets = 63 * bucketsPerOctave;
+
+        void add (juce::uint64 ticks) noexcept;
+
+        juce::uint64 getCount() const noexcept              { return count.get(); }
+        juce::uint64 getTotal() const noexcept              { return total.get(); }
+        juce::uint64 getMax() const noexcept                { return longest.load (std::memory_order_relaxed); }
+
+        /** The top of the bucket that the given proportion of the durations is at or under, e.g. 0.99 for p99. */
+        juce::uint64 getPercentile (double proportion) const noexcept;
+
+    private:
+        static int getBucket (juce::uint64 ticks) noexcept;
+        static juce::uint64 getBucketEnd (int bucket) noexcept;
+
+        Counter buckets[numBuckets];
+        Counter count, total;
+        std::atomic<juce::uint64> longest { 0 };
+    };
+
+    //==============================================================================
+    /** Adds the time between its construction and destruction to a histogram. */
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer (Histogram& histogramToAddTo) noexcept
+            : histogram (histogramToAddTo), start (readTicks()) {}
+
+        ~ScopedTimer() noexcept                             { histogram.add (readTicks() - start); }
+
+    private:
+        Histogram& histogram;
+        juce::uint64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+    //==============================================================================
+    /** Everything recorded for one processor. */
+    struct ProcessorStats
+    {
+        Histogram processBlock;             // audio thread
+        Histogram updateCoefficients;       // message thread
+
+        Counter audioThreadDesigns;         // automation sub-blocks, offline changes and the like
+        Counter skippedBlocks;              // silent input through a filter that had rung out
+        Counter bypassedBlocks;
+        Counter denormalBlocks;
+
+        /** A few lines of text, with the durations in microseconds. */
+        juce::String getReport() const;
+    };
+
+    /**
+        Times a processBlock and notes whether it raised the denormal flags. Make it
+        after the block's ScopedNoDenormals, so it's checked before that restores
+        the flags it found.
+    */
+    class ScopedBlockTimer
+    {
+    public:
+        explicit ScopedBlockTimer (ProcessorStats& statsToAddTo) noexcept
+            : stats (statsToAddTo), timer (stats.processBlock)
+        {
+            clearDenormalFlags();
+        }
+
+        ~ScopedBlockTimer() noexcept
+        {
+            if (haveDenormalFlagsBeenRaised())
+                stats.denormalBlocks.add();
+        }
+
+    private:
+        ProcessorStats& stats;
+        ScopedTimer timer;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlockTimer)
+    };
+}
+
+#endif
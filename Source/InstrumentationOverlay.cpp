@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    InstrumentationOverlay.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "InstrumentationOverlay.h"
+
+#if EQ1_INSTRUMENTATION
+
+InstrumentationOverlay::InstrumentationOverlay (const Instrumentation::ProcessorStats& statsToShow)
+    : stats (statsToShow)
+{
+    // It sits over the response display, whose node must still get the mouse
+    setInterceptsMouseClicks (false, false);
+    startTimerHz (4);
+}
+
+void InstrumentationOverlay::timerCallback()
+{
+    auto newLines = juce::StringArray::fromLines (stats.getReport().trimEnd());
+
+    if (newLines != lines)
+    {
+        lines = newLines;
+        repaint();
+    }
+}
+
+void InstrumentationOverlay::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black.withAlpha (0.6f));
+
+    g.setColour (juce::Colours::lightgreen);
+    g.setFont (juce::Font (juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+
+    auto area = getLocalBounds().reduced (4);
+
+    for (int i = 0; i < lines.size(); i++)
+        g.drawSingleLineText (lines[i], area.getX(), area.getY() + 11 * (i + 1));
+}
+
+#endif
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    InstrumentationOverlay.h
+
+    The processor's instrumentation as a few lines of text in a corner of the
+    editor, refreshed four times a second. Only instrumented builds have it.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Instrumentation.h"
+
+#if EQ1_INSTRUMENTATION
+
+class InstrumentationOverlay  : public juce::Component,
+                                private juce::Timer
+{
+public:
+    explicit InstrumentationOverlay (const Instrumentation::ProcessorStats& statsToShow);
+
+    void paint (juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    const Instrumentation::ProcessorStats& stats;
+    juce::StringArray lines;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InstrumentationOverlay)
+};
+
+#endif
@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    InterleavedAudio.h
+
+    Interleaved buffers in the formats an embedded or offline host works in:
+    32-bit float, 16-bit integer, or 24-bit integer packed into three bytes,
+    all little-endian, with each frame holding one sample of every channel.
+
+    The scalar conversions here are the reference. The kernels that filter
+    interleaved data convert inside their loops and round the same way, so a
+    block gives the same samples whether it's filtered in place or goes
+    through float buffers. Integers are scaled by 2^-15 or 2^-23 on the way
+    in, and rounded to nearest and clipped to their range on the way out.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace InterleavedAudio
+{
+    enum class Format
+    {
+        float32 = 0,
+        int16,
+        int24
+    };
+
+    constexpr int getBytesPerSample (Format format) noexcept
+    {
+        return format == Format::float32 ? 4 : (format == Format::int16 ? 2 : 3);
+    }
+
+    template <Format format> constexpr float fullScale = format == Format::int16 ? 32768.0f : 8388608.0f;
+
+    //==============================================================================
+    inline juce::int32 readInt24 (const char* bytes) noexcept
+    {
+        // Into the top three bytes, so the shift back down extends the sign
+        auto value = (juce::uint32) (juce::uint8) bytes[0] << 8
+                   | (juce::uint32) (juce::uint8) bytes[1] << 16
+                   | (juce::uint32) (juce::uint8) bytes[2] << 24;
+
+        return (juce::int32) value >> 8;
+    }
+
+    inline void writeInt24 (char* bytes, juce::int32 value) noexcept
+    {
+        bytes[0] = (char) (value & 0xff);
+        bytes[1] = (char) ((value >> 8) & 0xff);
+        bytes[2] = (char) ((value >> 16) & 0xff);
+    }
+
+    /** Sample channel of the frame starting at frame. */
+    template <Format format>
+    inline float read (const char* frame, int channel) noexcept
+    {
+        if constexpr (format == Format::float32)
+        {
+            float value;
+            std::memcpy (&value, frame + 4 * channel, sizeof (value));
+            return value;
+        }
+        else if constexpr (format == Format::int16)
+        {
+            juce::int16 value;
+            std::memcpy (&value, frame + 2 * channel, sizeof (value));
+            return (float) value * (1.0f / fullScale<format>);
+        }
+        else
+        {
+            return (float) readInt24 (frame + 3 * channel) * (1.0f / fullScale<format>);
+        }
+    }
+
+    template <Format format>
+    inline void write (char* frame, int channel, float value) noexcept
+    {
+        if constexpr (format == Format::float32)
+        {
+            std::memcpy (frame + 4 * channel, &value, sizeof (value));
+        }
+        else
+        {
+            auto scaled = juce::jlimit (-fullScale<format>, fullScale<format> - 1.0f, value * fullScale<format>);
+            auto integer = (juce::int32) std::lrint (scaled);
+
+            if constexpr (format == Format::int16)
+            {
+                auto sample = (juce::int16) integer;
+                std::memcpy (frame + 2 * channel, &sample, sizeof (sample));
+            }
+            else
+            {
+                writeInt24 (frame + 3 * channel, integer);
+            }
+        }
+    }
+
+    //==============================================================================
+    /** Copies numFrames frames, from frame startFrame on, into separate channels. */
+    inline void deinterleave (const void* data, Format format, int numChannels, int startFrame, int numFrames,
+                              float* const* channels) noexcept
+    {
+        auto frameBytes = numChannels * getBytesPerSample (format);
+        auto* frames = static_cast<const char*> (data) + (size_t) startFrame * (size_t) frameBytes;
+
+        auto copy = [&] (auto readSample)
+        {
+            for (int n = 0; n < numFrames; n++)
+                for (int channel = 0; channel < numChannels; channel++)
+                    channels[channel][n] = readSample (frames + (size_t) n * (size_t) frameBytes, channel);
+        };
+
+        switch (format)
+        {
+            case Format::int16:     copy (read<Format::int16>); break;
+            case Format::int24:     copy (read<Format::int24>); break;
+            case Format::float32:
+            default:                copy (read<Format::float32>); break;
+        }
+    }
+
+    /** Copies numFrames samples of each channel back into frames startFrame on. */
+    inline void interleave (const float* const* channels, void* data, Format format, int numChannels, int startFrame,
+                            int numFrames) noexcept
+    {
+        auto frameBytes = numChannels * getBytesPerSample (format);
+        auto* frames = static_cast<char*> (data) + (size_t) startFrame * (size_t) frameBytes;
+
+        auto copy = [&] (auto writeSample)
+        {
+            for (int n = 0; n < numFrames; n++)
+                for (int channel = 0; channel < numChannels; channel++)
+                    writeSample (frames + (size_t) n * (size_t) frameBytes, channel, channels[channel][n]);
+        };
+
+        switch (format)
+        {
+            case Format::int16:     copy (write<Format::int16>); break;
+            case Format::int24:     copy (write<Format::int24>); break;
+            case Format::float32:
+            default:                copy (write<Format::float32>); break;
+        }
+    }
+}
@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    LinearPhaseDesigner.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseDesigner.h"
+
+//==============================================================================
+void LinearPhaseDesigner::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    // About 6 Hz between bins, e.g. 8192 taps at 48 kHz
+    firLength = juce::jmax (2 * partitionSize, juce::nextPowerOfTwo (juce::roundToInt (sampleRate / 6.0)));
+
+    firFFT = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 ((double) firLength)));
+    partitionFFT = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 ((double) (2 * partitionSize))));
+
+    // The real-only transforms work in place on twice the FFT length
+    firBuffer.assign ((size_t) (2 * firLength), 0.0f);
+    partitionBuffer.assign ((size_t) (4 * partitionSize), 0.0f);
+
+    // Blackman, symmetric about the middle tap
+    window.resize ((size_t) firLength);
+
+    for (int m = 0; m < firLength; m++)
+    {
+        auto phase = juce::MathConstants<double>::twoPi * m / firLength;
+        window[(size_t) m] = (float) (0.42 - 0.5 * std::cos (phase) + 0.08 * std::cos (2.0 * phase));
+    }
+}
+
+void LinearPhaseDesigner::design (const CascadeCoefficients& coefficients, PartitionedKernel& kernel)
+{
+    jassert (firLength > 0);
+
+    if (kernel.partitionSize != partitionSize || kernel.numPartitions != getNumPartitions())
+        kernel.setSize (partitionSize, getNumPartitions());
+
+    kernel.sampleRate = sampleRate;
+
+    // The magnitude of the whole cascade on the FFT grid, with zero phase
+    for (int k = 0; k <= firLength / 2; k++)
+    {
+        auto e1 = std::polar (1.0, -juce::MathConstants<double>::twoPi * k / firLength);
+        auto e2 = e1 * e1;
+        auto magnitude = 1.0;
+
+        for (int i = 0; i < coefficients.numSections; i++)
+        {
+            const auto& c = coefficients.sections[i];
+
+            if (c.isIdentity())
+                continue;
+
+            double n0, n1, n2, d1, d2;
+            c.getTransferFunction (n0, n1, n2, d1, d2);
+
+            magnitude *= std::abs ((n0 + n1 * e1 + n2 * e2) / (1.0 + d1 * e1 + d2 * e2));
+        }
+
+        firBuffer[(size_t) (2 * k)] = (float) magnitude;
+        firBuffer[(size_t) (2 * k + 1)] = 0.0f;
+    }
+
+    firFFT->performRealOnlyInverseTransform (firBuffer.data());
+
+    // Zero phase puts the peak of the impulse at tap 0; move it to the middle and window it
+    std::rotate (firBuffer.begin(), firBuffer.begin() + firLength / 2, firBuffer.begin() + firLength);
+
+    for (int m = 0; m < firLength; m++)
+        firBuffer[(size_t) m] *= window[(size_t) m];
+
+    for (int p = 0; p < kernel.numPartitions; p++)
+    {
+        auto first = firBuffer.begin() + p * partitionSize;
+
+        std::fill (partitionBuffer.begin(), partitionBuffer.end(), 0.0f);
+        std::copy (first, first + partitionSize, partitionBuffer.begin());
+        partitionFFT->performRealOnlyForwardTransform (partitionBuffer.data(), true);
+
+        auto* real = kernel.getReal (p);
+        auto* imag = kernel.getImag (p);
+
+        for (int k = 0; k <= partitionSize; k++)
+        {
+            real[k] = partitionBuffer[(size_t) (2 * k)];
+            imag[k] = partitionBuffer[(size_t) (2 * k + 1)];
+        }
+    }
+}
+
+//==============================================================================
+LinearPhaseDesignThread::LinearPhaseDesignThread (SnapshotSlot<PartitionedKernel>& destination)
+    : juce::Thread ("EQ1 linear phase design"),
+      slot (destination)
+{
+}
+
+LinearPhaseDesignThread::~LinearPhaseDesignThread()
+{
+    stopThread (2000);
+}
+
+void LinearPhaseDesignThread::prepare (double sampleRate)
+{
+    stopThread (2000);
+    designer.prepare (sampleRate);
+    kernel.setSize (LinearPhaseDesigner::partitionSize, designer.getNumPartitions());
+    startThread();
+}
+
+void LinearPhaseDesignThread::requestDesign (const CascadeCoefficients& coefficients)
+{
+    {
+        const juce::ScopedLock sl (requestLock);
+        request = coefficients;
+        ++numRequested;
+    }
+
+    notify();
+}
+
+void LinearPhaseDesignThread::designAndWait (const CascadeCoefficients& coefficients)
+{
+    juce::uint32 ticket;
+
+    {
+        const juce::ScopedLock sl (requestLock);
+        request = coefficients;
+        ticket = ++numRequested;
+    }
+
+    notify();
+
+    while ((juce::int32) (numPublished.load() - ticket) < 0 && isThreadRunning())
+        published.wait (50);
+}
+
+void LinearPhaseDesignThread::run()
+{
+    while (! threadShouldExit())
+    {
+        CascadeCoefficients next;
+        juce::uint32 ticket;
+
+        {
+            const juce::ScopedLock sl (requestLock);
+            ticket = numRequested;
+
+            if (ticket != numPublished.load())
+                next = request;
+        }
+
+        if (ticket == numPublished.load())
+        {
+            wait (-1);
+            continue;
+        }
+
+        designer.design (next, kernel);
+        slot.publish (kernel);
+
+        numPublished.store (ticket);
+        published.signal();
+    }
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    LinearPhaseDesigner.h
+
+    Turns the cascade's coefficients into a linear-phase FIR with the same
+    magnitude response, ready for the PartitionedConvolver. The response of
+    every section is evaluated on the FFT grid, given zero phase, transformed
+    back, centred and windowed, so the filter is symmetric and delays every
+    frequency by half its length.
+
+    The FIR is long enough for about 6 Hz of resolution at any sample rate
+    (8192 taps at 44.1 and 48 kHz). Bands narrower than that, e.g. a high Q
+    at a few tens of Hz, come out wider and shallower than the minimum-phase
+    biquads make them.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQCascade.h"
+#include "PartitionedConvolver.h"
+
+class LinearPhaseDesigner
+{
+public:
+    /** The convolver's partitions, and so its latency on top of the FIR's. */
+    static constexpr int partitionSize = 512;
+
+    LinearPhaseDesigner() = default;
+
+    /** Allocates the FFT and scratch for a sample rate. Not real-time safe. */
+    void prepare (double sampleRate);
+
+    int getFirLength() const noexcept                       { return firLength; }
+    int getNumPartitions() const noexcept                   { return firLength / partitionSize; }
+
+    /** The FIR's own delay, half its length. */
+    int getLatencySamples() const noexcept                  { return firLength / 2; }
+
+    /** Designs the FIR and partitions it into kernel, which is resized if it needs to be. */
+    void design (const CascadeCoefficients& coefficients, PartitionedKernel& kernel);
+
+private:
+    double sampleRate = 0;
+    int firLength = 0;
+
+    std::unique_ptr<juce::dsp::FFT> firFFT, partitionFFT;
+    std::vector<float> firBuffer, partitionBuffer, window;
+
+    JUCE_DECLARE_NON_COPYABLE (LinearPhaseDesigner)
+};
+
+//==============================================================================
+/**
+    Designs on a background thread and publishes to a convolver's kernel slot,
+    so a redesign never holds up the message thread or the audio thread. If
+    requests come faster than designs, only the newest one is designed.
+*/
+class LinearPhaseDesignThread  : private juce::Thread
+{
+public:
+    explicit LinearPhaseDesignThread (SnapshotSlot<PartitionedKernel>& destination);
+    ~LinearPhaseDesignThread() override;
+
+    /** Stops the thread, prepares the designer and starts the thread again. */
+    void prepare (double sampleRate);
+
+    int getLatencySamples() const noexcept                  { return designer.getLatencySamples(); }
+    int getNumPartitions() const noexcept                   { return designer.getNumPartitions(); }
+
+    /** Queues a design and returns straight away. */
+    void requestDesign (const CascadeCoefficients& coefficients);
+
+    /** Queues a design and waits until it has been published, e.g. when rendering offline. */
+    void designAndWait (const CascadeCoefficients& coefficients);
+
+private:
+    void run() override;
+
+    SnapshotSlot<PartitionedKernel>& slot;
+    LinearPhaseDesigner designer;
+    PartitionedKernel kernel;
+
+    juce::CriticalSection requestLock;
+    CascadeCoefficients request;
+    juce::uint32 numRequested = 0;
+    std::atomic<juce::uint32> numPublished { 0 };
+    juce::WaitableEvent published;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinearPhaseDesignThread)
+};
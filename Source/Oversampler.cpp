@@ -0,0 +1,459 @@
+/*
+  ==============================================================================
+
+    Oversampler.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+#include "BiquadSIMD.h"
+
+namespace
+{
+    /*
+        output[j] = sum over t of taps[t] * (work[j + K - 1 - t] + work[j + K + t]).
+        That is the odd phase of a half-band, centred between work[j + K - 1] and
+        work[j + K], with the mirrored inputs added before the multiply. Two sums
+        take turns so the adds don't wait on each other; K is always even.
+    */
+    template <typename SampleType, typename TapType>
+    void foldedDotScalar (const SampleType* work, const TapType* taps, int numTaps,
+                          SampleType* output, int numOutputs) noexcept
+    {
+        for (int j = 0; j < numOutputs; j++)
+        {
+            auto* centre = work + j + numTaps;
+            SampleType sum0 = 0, sum1 = 0;
+
+            for (int t = 0; t < numTaps; t += 2)
+            {
+                sum0 += (SampleType) taps[t] * (centre[-1 - t] + centre[t]);
+                sum1 += (SampleType) taps[t + 1] * (centre[-2 - t] + centre[t + 1]);
+            }
+
+            output[j] = sum0 + sum1;
+        }
+    }
+
+   #if JUCE_INTEL
+    EQ1_TARGET_SSE2 void foldedDotSSE2 (const float* work, const float* taps, int numTaps,
+                                        float* output, int numOutputs) noexcept
+    {
+        int j = 0;
+
+        for (; j + 4 <= numOutputs; j += 4)
+        {
+            auto* centre = work + j + numTaps;
+            auto sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+
+            for (int t = 0; t < numTaps; t += 2)
+            {
+                auto pair0 = _mm_add_ps (_mm_loadu_ps (centre - 1 - t), _mm_loadu_ps (centre + t));
+                auto pair1 = _mm_add_ps (_mm_loadu_ps (centre - 2 - t), _mm_loadu_ps (centre + t + 1));
+                sum0 = _mm_add_ps (sum0, _mm_mul_ps (_mm_set1_ps (taps[t]), pair0));
+                sum1 = _mm_add_ps (sum1, _mm_mul_ps (_mm_set1_ps (taps[t + 1]), pair1));
+            }
+
+            _mm_storeu_ps (output + j, _mm_add_ps (sum0, sum1));
+        }
+
+        foldedDotScalar (work + j, taps, numTaps, output + j, numOutputs - j);
+    }
+
+    EQ1_TARGET_AVX2 void foldedDotAVX2 (const float* work, const float* taps, int numTaps,
+                                        float* output, int numOutputs) noexcept
+    {
+        int j = 0;
+
+        for (; j + 8 <= numOutputs; j += 8)
+        {
+            auto* centre = work + j + numTaps;
+            auto sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+
+            for (int t = 0; t < numTaps; t += 2)
+            {
+                auto pair0 = _mm256_add_ps (_mm256_loadu_ps (centre - 1 - t), _mm256_loadu_ps (centre + t));
+                auto pair1 = _mm256_add_ps (_mm256_loadu_ps (centre - 2 - t), _mm256_loadu_ps (centre + t + 1));
+                sum0 = _mm256_add_ps (sum0, _mm256_mul_ps (_mm256_set1_ps (taps[t]), pair0));
+                sum1 = _mm256_add_ps (sum1, _mm256_mul_ps (_mm256_set1_ps (taps[t + 1]), pair1));
+            }
+
+            _mm256_storeu_ps (output + j, _mm256_add_ps (sum0, sum1));
+        }
+
+        foldedDotSSE2 (work + j, taps, numTaps, output + j, numOutputs - j);
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    void foldedDotNEON (const float* work, const float* taps, int numTaps,
+                        float* output, int numOutputs) noexcept
+    {
+        int j = 0;
+
+        for (; j + 4 <= numOutputs; j += 4)
+        {
+            auto* centre = work + j + numTaps;
+            auto sum0 = vdupq_n_f32 (0.0f), sum1 = vdupq_n_f32 (0.0f);
+
+            for (int t = 0; t < numTaps; t += 2)
+            {
+                auto pair0 = vaddq_f32 (vld1q_f32 (centre - 1 - t), vld1q_f32 (centre + t));
+                auto pair1 = vaddq_f32 (vld1q_f32 (centre - 2 - t), vld1q_f32 (centre + t + 1));
+                sum0 = vmlaq_n_f32 (sum0, pair0, taps[t]);
+                sum1 = vmlaq_n_f32 (sum1, pair1, taps[t + 1]);
+            }
+
+            vst1q_f32 (output + j, vaddq_f32 (sum0, sum1));
+        }
+
+        foldedDotScalar (work + j, taps, numTaps, output + j, numOutputs - j);
+    }
+   #endif
+
+    double besselI0 (double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; term > 1.0e-12 * sum; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    /*
+        The odd-phase taps of a Kaiser-windowed half-band with 4 * numTaps - 1 taps:
+        h[m] = sin (pi m / 2) / (pi m) for odd m, with the centre tap of 0.5 left out.
+        They're scaled so DC passes at exactly unity gain.
+    */
+    void designHalfBand (int numTaps, double beta, double* taps) noexcept
+    {
+        auto halfLength = 2.0 * numTaps;
+        auto sum = 0.0;
+
+        for (int t = 0; t < numTaps; t++)
+        {
+            auto m = (double) (2 * t + 1);
+            auto ratio = m / halfLength;
+            auto window = besselI0 (beta * std::sqrt (1.0 - ratio * ratio)) / besselI0 (beta);
+
+            taps[t] = std::sin (juce::MathConstants<double>::halfPi * m) / (juce::MathConstants<double>::pi * m) * window;
+            sum += taps[t];
+        }
+
+        for (int t = 0; t < numTaps; t++)
+            taps[t] *= 0.25 / sum;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void Oversampler::Buffers<SampleType>::allocate (int numChannels, int blockSize)
+{
+    // Up history and down even history of 2K - 1 samples, down odd history of K, for both stages
+    auto perChannel = (size_t) (5 * firstStageTaps - 2 + 5 * secondStageTaps - 2);
+    storageSize = perChannel * (size_t) numChannels;
+    storage.calloc (storageSize);
+
+    auto* next = storage.get();
+
+    for (int stage = 0; stage < 2; stage++)
+    {
+        auto numTaps = getNumTaps (stage);
+        stages[stage].calloc ((size_t) numChannels);
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            auto& state = stages[stage][channel];
+            state.up = next;                next += 2 * numTaps - 1;
+            state.downEven = next;          next += 2 * numTaps - 1;
+            state.downOdd = next;           next += numTaps;
+        }
+    }
+
+    halfRateDelay.calloc ((size_t) numChannels);
+
+    oversampled.setSize (numChannels, maxFactor * blockSize);
+
+    // Every stage reads at most twice the block, after its history
+    work.calloc ((size_t) (2 * firstStageTaps + 2 * blockSize));
+    oddWork.calloc ((size_t) (firstStageTaps + 2 * blockSize));
+    middle.calloc ((size_t) (2 * blockSize));
+    even.calloc ((size_t) (2 * blockSize));
+}
+
+template <typename SampleType>
+void Oversampler::Buffers<SampleType>::clear() noexcept
+{
+    if (storage == nullptr)
+        return;
+
+    std::fill (storage.get(), storage + storageSize, SampleType());
+    std::fill (halfRateDelay.get(), halfRateDelay + oversampled.getNumChannels(), SampleType());
+}
+
+//==============================================================================
+Oversampler::Oversampler()
+    : simdKernel (BiquadEngine::getBestAvailableKernel())
+{
+    // Both stages reject images and aliases by 100 dB or more
+    designHalfBand (firstStageTaps, 10.0, doubleDownTaps[0]);
+    designHalfBand (secondStageTaps, 11.0, doubleDownTaps[1]);
+
+    for (int stage = 0; stage < 2; stage++)
+    {
+        for (int t = 0; t < getNumTaps (stage); t++)
+        {
+            doubleUpTaps[stage][t] = 2.0 * doubleDownTaps[stage][t];
+            downTaps[stage][t] = (float) doubleDownTaps[stage][t];
+            upTaps[stage][t] = (float) doubleUpTaps[stage][t];
+        }
+    }
+}
+
+void Oversampler::prepare (int maxNumChannels, int newMaxBlockSize)
+{
+    maxChannels = juce::jmax (1, maxNumChannels);
+    maxBlockSize = juce::jmax (1, newMaxBlockSize);
+
+    floatBuffers.allocate (maxChannels, maxBlockSize);
+    doubleBuffers.allocate (maxChannels, maxBlockSize);
+}
+
+void Oversampler::reset() noexcept
+{
+    floatBuffers.clear();
+    doubleBuffers.clear();
+}
+
+void Oversampler::setFactor (int newFactor) noexcept
+{
+    jassert (newFactor == 1 || newFactor == 2 || newFactor == 4);
+
+    factor = newFactor;
+    reset();
+}
+
+int Oversampler::getLatencySamples (int factor) noexcept
+{
+    // Each half-band delays by 2K - 1 samples at its higher rate, on the way up and again on the way
+    // down. The second stage comes to K - 1/2, so half a sample more at 2x makes the total whole.
+    if (factor == 2)    return 2 * firstStageTaps - 1;
+    if (factor == 4)    return 2 * firstStageTaps - 1 + secondStageTaps;
+
+    return 0;
+}
+
+//==============================================================================
+template <typename SampleType>
+void Oversampler::foldedDot (const SampleType* work, int stage, bool isUp, SampleType* output, int numOutputs) const noexcept
+{
+    auto numTaps = getNumTaps (stage);
+
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        auto* taps = isUp ? upTaps[stage] : downTaps[stage];
+
+        switch (simdKernel)
+        {
+           #if JUCE_INTEL
+            case BiquadEngine::Kernel::avx2:    foldedDotAVX2 (work, taps, numTaps, output, numOutputs); break;
+            case BiquadEngine::Kernel::sse2:    foldedDotSSE2 (work, taps, numTaps, output, numOutputs); break;
+           #endif
+           #if EQ1_HAS_NEON
+            case BiquadEngine::Kernel::neon:    foldedDotNEON (work, taps, numTaps, output, numOutputs); break;
+           #endif
+            default:                            foldedDotScalar (work, taps, numTaps, output, numOutputs); break;
+        }
+    }
+    else
+    {
+        foldedDotScalar (work, isUp ? doubleUpTaps[stage] : doubleDownTaps[stage], numTaps, output, numOutputs);
+    }
+}
+
+/*
+    Going up, the input is zero-stuffed and filtered, so the odd outputs only see the
+    centre tap and are the input delayed by K - 1 samples; the even outputs are the
+    folded dot product of the input.
+*/
+template <typename SampleType>
+void Oversampler::upsampleStage (int stage, const SampleType* input, int numSamples, SampleType* output,
+                                 StageState<SampleType>& state, Buffers<SampleType>& buffers) noexcept
+{
+    auto numTaps = getNumTaps (stage);
+    auto historyLength = 2 * numTaps - 1;
+    auto* work = buffers.work.get();
+
+    std::copy (state.up, state.up + historyLength, work);
+    std::copy (input, input + numSamples, work + historyLength);
+
+    foldedDot (work, stage, true, buffers.even.get(), numSamples);
+
+    for (int j = 0; j < numSamples; j++)
+    {
+        output[2 * j] = buffers.even[j];
+        output[2 * j + 1] = work[j + numTaps];
+    }
+
+    std::copy (work + numSamples, work + numSamples + historyLength, state.up);
+}
+
+/*
+    Going down only every other output is needed, so the input is split into its even
+    and odd samples: the odd ones meet the centre tap, the even ones the folded taps.
+*/
+template <typename SampleType>
+void Oversampler::downsampleStage (int stage, const SampleType* input, int numSamples, SampleType* output,
+                                   StageState<SampleType>& state, Buffers<SampleType>& buffers) noexcept
+{
+    auto numTaps = getNumTaps (stage);
+    auto historyLength = 2 * numTaps - 1;
+    auto* work = buffers.work.get();
+    auto* oddWork = buffers.oddWork.get();
+
+    std::copy (state.downEven, state.downEven + historyLength, work);
+    std::copy (state.downOdd, state.downOdd + numTaps, oddWork);
+
+    for (int j = 0; j < numSamples; j++)
+    {
+        work[historyLength + j] = input[2 * j];
+        oddWork[numTaps + j] = input[2 * j + 1];
+    }
+
+    foldedDot (work, stage, false, output, numSamples);
+
+    for (int j = 0; j < numSamples; j++)
+        output[j] += (SampleType) 0.5 * oddWork[j];
+
+    std::copy (work + numSamples, work + numSamples + historyLength, state.downEven);
+    std::copy (oddWork + numSamples, oddWork + numSamples + numTaps, state.downOdd);
+}
+
+//==============================================================================
+template <typename SampleType>
+SampleType* const* Oversampler::upsampleChannels (Buffers<SampleType>& buffers, const SampleType* const* channelData,
+                                                  int numChannels, int startSample, int numSamples) noexcept
+{
+    jassert (numChannels <= maxChannels && numSamples <= maxBlockSize);
+
+    auto* const* oversampled = buffers.oversampled.getArrayOfWritePointers();
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto* input = channelData[channel] + startSample;
+
+        if (factor == 2)
+        {
+            upsampleStage (0, input, numSamples, oversampled[channel], buffers.stages[0][channel], buffers);
+        }
+        else if (factor == 4)
+        {
+            upsampleStage (0, input, numSamples, buffers.middle.get(), buffers.stages[0][channel], buffers);
+            upsampleStage (1, buffers.middle.get(), 2 * numSamples, oversampled[channel], buffers.stages[1][channel], buffers);
+        }
+        else
+        {
+            std::copy (input, input + numSamples, oversampled[channel]);
+        }
+    }
+
+    return oversampled;
+}
+
+template <typename SampleType>
+void Oversampler::downsampleChannels (Buffers<SampleType>& buffers, SampleType* const* channelData,
+                                      int numChannels, int startSample, int numSamples) noexcept
+{
+    jassert (numChannels <= maxChannels && numSamples <= maxBlockSize);
+
+    auto* const* oversampled = buffers.oversampled.getArrayOfWritePointers();
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto* output = channelData[channel] + startSample;
+
+        if (factor == 2)
+        {
+            downsampleStage (0, oversampled[channel], numSamples, output, buffers.stages[0][channel], buffers);
+        }
+        else if (factor == 4)
+        {
+            auto* middle = buffers.middle.get();
+            auto halfRateSamples = 2 * numSamples;
+
+            downsampleStage (1, oversampled[channel], halfRateSamples, middle, buffers.stages[1][channel], buffers);
+
+            // One sample of delay at 2x rounds the latency up to a whole session-rate sample
+            auto last = middle[halfRateSamples - 1];
+            std::copy_backward (middle, middle + halfRateSamples - 1, middle + halfRateSamples);
+            middle[0] = buffers.halfRateDelay[channel];
+            buffers.halfRateDelay[channel] = last;
+
+            downsampleStage (0, middle, numSamples, output, buffers.stages[0][channel], buffers);
+        }
+        else
+        {
+            std::copy (oversampled[channel], oversampled[channel] + numSamples, output);
+        }
+    }
+}
+
+float* const* Oversampler::upsample (const float* const* channelData, int numChannels, int startSample, int numSamples) noexcept
+{
+    return upsampleChannels (floatBuffers, channelData, numChannels, startSample, numSamples);
+}
+
+double* const* Oversampler::upsample (const double* const* channelData, int numChannels, int startSample, int numSamples) noexcept
+{
+    return upsampleChannels (doubleBuffers, channelData, numChannels, startSample, numSamples);
+}
+
+void Oversampler::downsample (float* const* channelData, int numChannels, int startSample, int numSamples) noexcept
+{
+    downsampleChannels (floatBuffers, channelData, numChannels, startSample, numSamples);
+}
+
+void Oversampler::downsample (double* const* channelData, int numChannels, int startSample, int numSamples) noexcept
+{
+    downsampleChannels (doubleBuffers, channelData, numChannels, startSample, numSamples);
+}
+
+//==============================================================================
+template <typename SampleType>
+bool Oversampler::buffersHaveDecayedBelow (const Buffers<SampleType>& buffers, float threshold, int numChannels) const noexcept
+{
+    if (buffers.storage == nullptr)
+        return true;
+
+    // Channels are laid out one after the other within each stage, so the used ones are two runs
+    auto firstStageLength = (size_t) (5 * firstStageTaps - 2) * (size_t) maxChannels;
+    auto runs = { std::make_pair (buffers.storage.get(), (size_t) (5 * firstStageTaps - 2) * (size_t) numChannels),
+                  std::make_pair (buffers.storage + firstStageLength, (size_t) (5 * secondStageTaps - 2) * (size_t) numChannels) };
+
+    for (auto run : runs)
+        for (size_t i = 0; i < run.second; i++)
+            if (std::abs (run.first[i]) > (SampleType) threshold)
+                return false;
+
+    for (int channel = 0; channel < numChannels; channel++)
+        if (std::abs (buffers.halfRateDelay[channel]) > (SampleType) threshold)
+            return false;
+
+    return true;
+}
+
+bool Oversampler::hasDecayedBelow (float threshold, int numChannels) const noexcept
+{
+    numChannels = juce::jmin (numChannels, maxChannels);
+
+    return factor == 1
+        || (buffersHaveDecayedBelow (floatBuffers, threshold, numChannels)
+             && buffersHaveDecayedBelow (doubleBuffers, threshold, numChannels));
+}
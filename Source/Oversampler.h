@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+
+    Runs the biquads at 2 or 4 times the session rate. The bilinear transform
+    squeezes the whole analogue response into 0 to fs / 2, so at 44.1 kHz a
+    band at 12 kHz is already visibly narrower and a high shelf flattens out
+    before Nyquist; at twice the rate the same band sits where the warping is
+    small.
+
+    Each factor of two is a linear-phase half-band FIR in polyphase form.
+    Every other tap of a half-band is zero except the centre one, so one phase
+    of the filter is a plain delay, and the other is a symmetric filter with
+    half the taps, whose mirrored pairs of inputs are added before they are
+    multiplied. Both run at the lower rate, so a factor of two costs one
+    multiply per unique tap per sample on the way up and again on the way down.
+    The filter is vectorised along time: 4 (SSE2 / NEON) or 8 (AVX2) outputs
+    are worked out per instruction.
+
+    The first stage, between the session rate and twice it, has 95 taps and is
+    flat to within 0.001 dB up to 0.87 fs / 2 (19.2 kHz at 44.1 kHz), with
+    images and aliases 100 dB down. The second stage, at 4x, only has to keep
+    the first stage's images out, which leaves it a wide transition band, so
+    31 taps do. The delay is the same at every
+    frequency: 47 samples at 2x and 55 at 4x.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+
+class Oversampler
+{
+public:
+    static constexpr int maxFactor = 4;
+
+    Oversampler();
+
+    /** Allocates the state and the oversampled buffers for 4x. Not real-time safe. */
+    void prepare (int maxNumChannels, int maxBlockSize);
+
+    /** Clears the filters' history. */
+    void reset() noexcept;
+
+    /** Picks 1, 2 or 4 times the rate, and starts again from silence. Doesn't allocate. */
+    void setFactor (int newFactor) noexcept;
+    int getFactor() const noexcept                          { return factor; }
+
+    /** The longest block, at the session rate, that upsample() and downsample() take in one go. */
+    int getMaxBlockSize() const noexcept                    { return maxBlockSize; }
+
+    /** The delay of going up and back down again, in samples at the session rate. */
+    static int getLatencySamples (int factor) noexcept;
+
+    /**
+        Upsamples numSamples samples of each channel, from startSample on, into the
+        oversampled buffers and returns them, factor * numSamples long.
+    */
+    float* const* upsample (const float* const* channelData, int numChannels, int startSample, int numSamples) noexcept;
+    double* const* upsample (const double* const* channelData, int numChannels, int startSample, int numSamples) noexcept;
+
+    /** Downsamples the oversampled buffers back into the channels, after they have been filtered. */
+    void downsample (float* const* channelData, int numChannels, int startSample, int numSamples) noexcept;
+    void downsample (double* const* channelData, int numChannels, int startSample, int numSamples) noexcept;
+
+    /** True if nothing above threshold is left in the filters, so silence in gives silence out. */
+    bool hasDecayedBelow (float threshold, int numChannels) const noexcept;
+
+    /** The unique taps of each stage's odd phase. */
+    static constexpr int firstStageTaps = 24;
+    static constexpr int secondStageTaps = 8;
+
+private:
+    /** History of one stage for one channel: the up filter's input, and both phases of the down filter's input. */
+    template <typename SampleType>
+    struct StageState
+    {
+        SampleType* up = nullptr;
+        SampleType* downEven = nullptr;
+        SampleType* downOdd = nullptr;
+    };
+
+    /** Every channel's state, and scratch and output buffers, in one sample type. */
+    template <typename SampleType>
+    struct Buffers
+    {
+        void allocate (int numChannels, int blockSize);
+        void clear() noexcept;
+
+        juce::HeapBlock<SampleType> storage;
+        size_t storageSize = 0;
+
+        juce::HeapBlock<StageState<SampleType>> stages[2];
+        juce::HeapBlock<SampleType> halfRateDelay;
+
+        juce::AudioBuffer<SampleType> oversampled;
+        juce::HeapBlock<SampleType> work, oddWork, middle, even;
+    };
+
+    template <typename SampleType>
+    SampleType* const* upsampleChannels (Buffers<SampleType>& buffers, const SampleType* const* channelData,
+                                         int numChannels, int startSample, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void downsampleChannels (Buffers<SampleType>& buffers, SampleType* const* channelData,
+                             int numChannels, int startSample, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void upsampleStage (int stage, const SampleType* input, int numSamples, SampleType* output,
+                        StageState<SampleType>& state, Buffers<SampleType>& buffers) noexcept;
+
+    template <typename SampleType>
+    void downsampleStage (int stage, const SampleType* input, int numSamples, SampleType* output,
+                          StageState<SampleType>& state, Buffers<SampleType>& buffers) noexcept;
+
+    template <typename SampleType>
+    void foldedDot (const SampleType* work, int stage, bool isUp, SampleType* output, int numOutputs) const noexcept;
+
+    template <typename SampleType>
+    bool buffersHaveDecayedBelow (const Buffers<SampleType>& buffers, float threshold, int numChannels) const noexcept;
+
+    static int getNumTaps (int stage) noexcept              { return stage == 0 ? firstStageTaps : secondStageTaps; }
+
+    // Odd-phase taps, for going down, and doubled for going up to make up for the zeros in between
+    alignas (32) float downTaps[2][firstStageTaps] = {};
+    alignas (32) float upTaps[2][firstStageTaps] = {};
+    double doubleDownTaps[2][firstStageTaps] = {};
+    double doubleUpTaps[2][firstStageTaps] = {};
+
+    Buffers<float> floatBuffers;
+    Buffers<double> doubleBuffers;
+
+    BiquadEngine::Kernel simdKernel;
+    int factor = 1;
+    int maxChannels = 0;
+    int maxBlockSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+};
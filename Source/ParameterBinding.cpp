@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    ParameterBinding.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ParameterBinding.h"
+
+//==============================================================================
+ParameterBinding::ParameterBinding (juce::RangedAudioParameter& parameterToBind)
+    : parameter (parameterToBind), lastNormalisedValue (parameterToBind.getValue())
+{
+    parameter.addListener (this);
+}
+
+ParameterBinding::~ParameterBinding()
+{
+    if (inGesture)
+        endGesture();
+
+    parameter.removeListener (this);
+}
+
+void ParameterBinding::beginGesture()
+{
+    if (inGesture)
+        return;
+
+    inGesture = true;
+    parameter.beginChangeGesture();
+}
+
+void ParameterBinding::setValue (float newValue)
+{
+    if (inGesture)
+    {
+        heldValue = newValue;
+        hasHeldValue = true;
+        return;
+    }
+
+    parameter.beginChangeGesture();
+    send (newValue);
+    parameter.endChangeGesture();
+}
+
+void ParameterBinding::endGesture()
+{
+    if (! inGesture)
+        return;
+
+    if (hasHeldValue)
+        send (heldValue);
+
+    inGesture = false;
+    parameter.endChangeGesture();
+}
+
+float ParameterBinding::getValue() const noexcept
+{
+    return hasHeldValue ? heldValue : parameter.convertFrom0to1 (parameter.getValue());
+}
+
+void ParameterBinding::update()
+{
+    if (hasHeldValue)
+        send (heldValue);
+
+    // Only once it's been seen, so a change that lands while this runs is picked up next time
+    if (! hasChanged.exchange (false))
+        return;
+
+    // During a gesture the control leads, and the parameter catches up when it ends
+    auto normalisedValue = parameter.getValue();
+
+    if (inGesture || normalisedValue == lastNormalisedValue)
+        return;
+
+    lastNormalisedValue = normalisedValue;
+
+    if (onChange != nullptr)
+        onChange (parameter.convertFrom0to1 (normalisedValue));
+}
+
+void ParameterBinding::send (float newValue)
+{
+    hasHeldValue = false;
+    auto normalisedValue = parameter.convertTo0to1 (newValue);
+
+    if (normalisedValue == lastNormalisedValue)
+        return;
+
+    parameter.setValueNotifyingHost (normalisedValue);
+    lastNormalisedValue = parameter.getValue();
+}
+
+void ParameterBinding::parameterValueChanged (int, float)
+{
+    hasChanged.store (true);
+}
+
+//==============================================================================
+SliderBinding::SliderBinding (juce::RangedAudioParameter& parameterToBind, juce::Slider& sliderToBind)
+    : binding (parameterToBind), slider (sliderToBind)
+{
+    slider.setValue (binding.getValue(), juce::dontSendNotification);
+    slider.addListener (this);
+
+    binding.onChange = [this] (float value) { slider.setValue (value, juce::dontSendNotification); };
+}
+
+SliderBinding::~SliderBinding()
+{
+    slider.removeListener (this);
+}
+
+void SliderBinding::sliderValueChanged (juce::Slider*)
+{
+    binding.setValue ((float) slider.getValue());
+}
+
+void SliderBinding::sliderDragStarted (juce::Slider*)
+{
+    binding.beginGesture();
+}
+
+void SliderBinding::sliderDragEnded (juce::Slider*)
+{
+    binding.endGesture();
+}
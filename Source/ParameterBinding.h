@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    ParameterBinding.h
+
+    Connects one parameter to a control in the editor, in both directions,
+    without flooding the host or the message thread.
+
+    Editor to processor: a drag is bracketed by begin/endChangeGesture, and
+    the values in between are held and sent at most once per update(), so
+    a drag gives the host one undo step and a few dozen notifications a
+    second, however fast the mouse events arrive. A change outside a drag,
+    e.g. typed into the text box, is sent at once as a gesture of its own.
+
+    Processor to editor: the parameter's listener only sets a flag, so host
+    automation costs the audio thread a store per change. update() checks
+    the flag and calls onChange only when the value really is different
+    from the last one it saw or sent.
+
+    The owner calls update() from a timer; its rate is the most the host is
+    told about a held value, and the most the control is moved.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ParameterBinding  : private juce::AudioProcessorParameter::Listener
+{
+public:
+    explicit ParameterBinding (juce::RangedAudioParameter& parameterToBind);
+    ~ParameterBinding() override;
+
+    juce::RangedAudioParameter& getParameter() const noexcept  { return parameter; }
+
+    /** Called from update() with the parameter's new value, in its own units, when something else changed it. */
+    std::function<void (float)> onChange;
+
+    //==============================================================================
+    void beginGesture();
+
+    /** Sets the parameter in its own units: held until the next update() during a gesture, sent at once outside one. */
+    void setValue (float newValue);
+
+    /** Sends a held value, then ends the gesture. */
+    void endGesture();
+
+    bool isInGesture() const noexcept                       { return inGesture; }
+
+    /** The value in its own units, including one that's held and not sent yet. */
+    float getValue() const noexcept;
+
+    //==============================================================================
+    /** Sends a held value and reports a change from elsewhere to onChange. Message thread. */
+    void update();
+
+private:
+    void send (float newValue);
+
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int, bool) override       {}
+
+    juce::RangedAudioParameter& parameter;
+
+    float heldValue = 0.0f;
+    bool hasHeldValue = false;
+    bool inGesture = false;
+
+    // The normalised value last sent or reported, so nothing is sent or reported twice
+    float lastNormalisedValue;
+
+    // Set by the listener on whichever thread changed the parameter
+    std::atomic<bool> hasChanged { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterBinding)
+};
+
+//==============================================================================
+/** A ParameterBinding driven by a slider's drags and changes, which the slider follows back. */
+class SliderBinding  : private juce::Slider::Listener
+{
+public:
+    SliderBinding (juce::RangedAudioParameter& parameterToBind, juce::Slider& sliderToBind);
+    ~SliderBinding() override;
+
+    void update()                                           { binding.update(); }
+
+private:
+    void sliderValueChanged (juce::Slider*) override;
+    void sliderDragStarted (juce::Slider*) override;
+    void sliderDragEnded (juce::Slider*) override;
+
+    ParameterBinding binding;
+    juce::Slider& slider;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SliderBinding)
+};
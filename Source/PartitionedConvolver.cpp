@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolver.h"
+#include "BiquadSIMD.h"
+
+namespace
+{
+    /* sum += x * h, bin by bin, over a whole number of registers. */
+    void multiplyAddScalar (const float* xr, const float* xi, const float* hr, const float* hi,
+                            float* sr, float* si, int numBins) noexcept
+    {
+        for (int k = 0; k < numBins; k++)
+        {
+            sr[k] += xr[k] * hr[k] - xi[k] * hi[k];
+            si[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+    }
+
+   #if JUCE_INTEL
+    EQ1_TARGET_SSE2 void multiplyAddSSE2 (const float* xr, const float* xi, const float* hr, const float* hi,
+                                          float* sr, float* si, int numBins) noexcept
+    {
+        for (int k = 0; k < numBins; k += 4)
+        {
+            auto a = _mm_loadu_ps (xr + k), b = _mm_loadu_ps (xi + k);
+            auto c = _mm_loadu_ps (hr + k), d = _mm_loadu_ps (hi + k);
+
+            _mm_storeu_ps (sr + k, _mm_add_ps (_mm_loadu_ps (sr + k), _mm_sub_ps (_mm_mul_ps (a, c), _mm_mul_ps (b, d))));
+            _mm_storeu_ps (si + k, _mm_add_ps (_mm_loadu_ps (si + k), _mm_add_ps (_mm_mul_ps (a, d), _mm_mul_ps (b, c))));
+        }
+    }
+
+    EQ1_TARGET_AVX2 void multiplyAddAVX2 (const float* xr, const float* xi, const float* hr, const float* hi,
+                                          float* sr, float* si, int numBins) noexcept
+    {
+        for (int k = 0; k < numBins; k += 8)
+        {
+            auto a = _mm256_loadu_ps (xr + k), b = _mm256_loadu_ps (xi + k);
+            auto c = _mm256_loadu_ps (hr + k), d = _mm256_loadu_ps (hi + k);
+
+            _mm256_storeu_ps (sr + k, _mm256_add_ps (_mm256_loadu_ps (sr + k), _mm256_sub_ps (_mm256_mul_ps (a, c), _mm256_mul_ps (b, d))));
+            _mm256_storeu_ps (si + k, _mm256_add_ps (_mm256_loadu_ps (si + k), _mm256_add_ps (_mm256_mul_ps (a, d), _mm256_mul_ps (b, c))));
+        }
+    }
+   #endif
+
+   #if EQ1_HAS_NEON
+    void multiplyAddNEON (const float* xr, const float* xi, const float* hr, const float* hi,
+                          float* sr, float* si, int numBins) noexcept
+    {
+        for (int k = 0; k < numBins; k += 4)
+        {
+            auto a = vld1q_f32 (xr + k), b = vld1q_f32 (xi + k);
+            auto c = vld1q_f32 (hr + k), d = vld1q_f32 (hi + k);
+
+            vst1q_f32 (sr + k, vmlsq_f32 (vmlaq_f32 (vld1q_f32 (sr + k), a, c), b, d));
+            vst1q_f32 (si + k, vmlaq_f32 (vmlaq_f32 (vld1q_f32 (si + k), a, d), b, c));
+        }
+    }
+   #endif
+}
+
+//==============================================================================
+void PartitionedKernel::setSize (int newPartitionSize, int newNumPartitions)
+{
+    partitionSize = newPartitionSize;
+    numPartitions = newNumPartitions;
+    binStride = getBinStride (partitionSize);
+
+    real.assign ((size_t) (numPartitions * binStride), 0.0f);
+    imag.assign ((size_t) (numPartitions * binStride), 0.0f);
+}
+
+//==============================================================================
+PartitionedConvolver::PartitionedConvolver()
+    : simdKernel (BiquadEngine::getBestAvailableKernel())
+{
+}
+
+void PartitionedConvolver::prepare (int maxNumChannels, int newPartitionSize, int maxNumPartitions, double newSampleRate)
+{
+    jassert (juce::isPowerOfTwo (newPartitionSize));
+
+    partitionSize = newPartitionSize;
+    maxPartitions = juce::jmax (1, maxNumPartitions);
+    binStride = PartitionedKernel::getBinStride (partitionSize);
+    maxChannels = juce::jmax (1, maxNumChannels);
+    sampleRate = newSampleRate;
+
+    fft = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 ((double) (2 * partitionSize))));
+
+    inputs.calloc ((size_t) (maxChannels * 2 * partitionSize));
+    outputs.calloc ((size_t) (maxChannels * partitionSize));
+    spectra.calloc ((size_t) (maxChannels * maxPartitions * 2 * binStride));
+
+    // The real-only transforms work in place on twice the FFT length
+    fftBuffer.calloc ((size_t) (4 * partitionSize));
+    sumReal.calloc ((size_t) binStride);
+    sumImag.calloc ((size_t) binStride);
+    fadeBuffer.calloc ((size_t) partitionSize);
+
+    position = 0;
+    head = 0;
+    kernel = nullptr;
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    if (spectra == nullptr)
+        return;
+
+    std::fill (inputs.get(), inputs + maxChannels * 2 * partitionSize, 0.0f);
+    std::fill (outputs.get(), outputs + maxChannels * partitionSize, 0.0f);
+    std::fill (spectra.get(), spectra + maxChannels * maxPartitions * 2 * binStride, 0.0f);
+
+    position = 0;
+    head = 0;
+}
+
+float* PartitionedConvolver::getSpectrumReal (int channel, int index) noexcept
+{
+    return spectra + (size_t) ((channel * maxPartitions + index) * 2 * binStride);
+}
+
+float* PartitionedConvolver::getSpectrumImag (int channel, int index) noexcept
+{
+    return getSpectrumReal (channel, index) + binStride;
+}
+
+//==============================================================================
+void PartitionedConvolver::process (float* const* channelData, int numChannels, int numSamples) noexcept
+{
+    processBlocks (channelData, numChannels, numSamples);
+}
+
+void PartitionedConvolver::process (double* const* channelData, int numChannels, int numSamples) noexcept
+{
+    processBlocks (channelData, numChannels, numSamples);
+}
+
+template <typename SampleType>
+void PartitionedConvolver::processBlocks (SampleType* const* channelData, int numChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= maxChannels);
+    numChannels = juce::jmin (numChannels, maxChannels);
+
+    if (spectra == nullptr)
+        return;
+
+    // Input goes into the newer half of each channel's input, and out comes the output of the last partition
+    for (int done = 0; done < numSamples;)
+    {
+        auto length = juce::jmin (numSamples - done, partitionSize - position);
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            auto* data = channelData[channel] + done;
+            auto* in = getInput (channel) + partitionSize + position;
+            auto* out = getOutput (channel) + position;
+
+            for (int n = 0; n < length; n++)
+            {
+                in[n] = (float) data[n];
+                data[n] = (SampleType) out[n];
+            }
+        }
+
+        position += length;
+        done += length;
+
+        if (position == partitionSize)
+        {
+            processPartition (numChannels);
+            position = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processPartition (int numChannels) noexcept
+{
+    head = (head + 1) % maxPartitions;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto* input = getInput (channel);
+
+        std::copy (input, input + 2 * partitionSize, fftBuffer.get());
+        std::fill (fftBuffer + 2 * partitionSize, fftBuffer + 4 * partitionSize, 0.0f);
+        fft->performRealOnlyForwardTransform (fftBuffer, true);
+
+        auto* real = getSpectrumReal (channel, head);
+        auto* imag = getSpectrumImag (channel, head);
+
+        for (int k = 0; k <= partitionSize; k++)
+        {
+            real[k] = fftBuffer[2 * k];
+            imag[k] = fftBuffer[2 * k + 1];
+        }
+
+        // The newest partition becomes the older half for the next one
+        std::copy (input + partitionSize, input + 2 * partitionSize, input);
+
+        if (kernel != nullptr)
+            convolve (channel, *kernel, getOutput (channel));
+        else
+            std::fill (getOutput (channel), getOutput (channel) + partitionSize, 0.0f);
+    }
+
+    /*
+        Only pull once the current kernel is finished with: pulling hands its buffer
+        back to the producer. A new kernel gets the same input spectra, so the two
+        outputs can be crossfaded over this partition.
+    */
+    if (auto* fresh = kernelSlot.pull())
+    {
+        if (fresh->partitionSize != partitionSize || fresh->numPartitions > maxPartitions || fresh->sampleRate != sampleRate)
+        {
+            kernel = nullptr;
+            return;
+        }
+
+        auto scale = 1.0f / (float) partitionSize;
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            // Coming from silence there is nothing to fade from
+            if (kernel == nullptr)
+            {
+                convolve (channel, *fresh, getOutput (channel));
+                continue;
+            }
+
+            convolve (channel, *fresh, fadeBuffer);
+
+            auto* out = getOutput (channel);
+
+            for (int n = 0; n < partitionSize; n++)
+                out[n] += (float) (n + 1) * scale * (fadeBuffer[n] - out[n]);
+        }
+
+        kernel = fresh;
+    }
+}
+
+void PartitionedConvolver::convolve (int channel, const PartitionedKernel& withKernel, float* output) noexcept
+{
+    std::fill (sumReal.get(), sumReal + binStride, 0.0f);
+    std::fill (sumImag.get(), sumImag + binStride, 0.0f);
+
+    // Partition p of the kernel meets the input from p partitions ago
+    for (int p = 0; p < withKernel.numPartitions; p++)
+    {
+        auto index = (head - p + maxPartitions) % maxPartitions;
+        auto* xr = getSpectrumReal (channel, index);
+        auto* xi = getSpectrumImag (channel, index);
+        auto* hr = withKernel.getReal (p);
+        auto* hi = withKernel.getImag (p);
+
+        switch (simdKernel)
+        {
+           #if JUCE_INTEL
+            case BiquadEngine::Kernel::avx2:    multiplyAddAVX2 (xr, xi, hr, hi, sumReal, sumImag, binStride); break;
+            case BiquadEngine::Kernel::sse2:    multiplyAddSSE2 (xr, xi, hr, hi, sumReal, sumImag, binStride); break;
+           #endif
+           #if EQ1_HAS_NEON
+            case BiquadEngine::Kernel::neon:    multiplyAddNEON (xr, xi, hr, hi, sumReal, sumImag, binStride); break;
+           #endif
+            default:                            multiplyAddScalar (xr, xi, hr, hi, sumReal, sumImag, binStride); break;
+        }
+    }
+
+    for (int k = 0; k <= partitionSize; k++)
+    {
+        fftBuffer[2 * k] = sumReal[k];
+        fftBuffer[2 * k + 1] = sumImag[k];
+    }
+
+    fft->performRealOnlyInverseTransform (fftBuffer);
+
+    // Overlap-save: the first half has wrapped around, the second half is the linear convolution
+    std::copy (fftBuffer + partitionSize, fftBuffer + 2 * partitionSize, output);
+}
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.h
+
+    Uniformly partitioned overlap-save FFT convolution. The impulse response is
+    cut into partitions of the block length, each held as its spectrum, and
+    every block of input is transformed once and kept in a frequency-domain
+    delay line. One block of output is then the sum of the last P input
+    spectra times the P partition spectra, and one inverse transform.
+
+    The work per sample is two FFTs of twice the block length, plus one
+    complex multiply-add per partition per bin. A direct-form FIR of the same
+    length needs one multiply-add per tap per sample, so for a few thousand
+    taps this is well over ten times cheaper, and it grows far more slowly
+    with the length of the filter.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+#include "SnapshotSlot.h"
+
+//==============================================================================
+/**
+    The spectra of every partition of an impulse response, bins 0 to
+    partitionSize of a 2 * partitionSize point FFT, as separate real and
+    imaginary arrays so the bins can be multiplied a register at a time.
+*/
+struct PartitionedKernel
+{
+    /** Sizes the arrays and clears them. Allocates, so call off the audio thread. */
+    void setSize (int newPartitionSize, int newNumPartitions);
+
+    float* getReal (int partition) noexcept                 { return real.data() + (size_t) (partition * binStride); }
+    float* getImag (int partition) noexcept                 { return imag.data() + (size_t) (partition * binStride); }
+    const float* getReal (int partition) const noexcept     { return real.data() + (size_t) (partition * binStride); }
+    const float* getImag (int partition) const noexcept     { return imag.data() + (size_t) (partition * binStride); }
+
+    /** partitionSize + 1 bins, padded to a whole number of the widest registers. */
+    static int getBinStride (int partitionSize) noexcept    { return (partitionSize + 1 + 7) & ~7; }
+
+    int partitionSize = 0;
+    int numPartitions = 0;
+    int binStride = 0;
+    double sampleRate = 0;
+
+    std::vector<float> real, imag;
+};
+
+//==============================================================================
+/**
+    Runs a PartitionedKernel over a block of channels, with a latency of one
+    partition. New kernels are handed over through the kernel slot from any
+    one thread, and are picked up at the start of the next partition; the
+    first partition after a change is crossfaded from the old kernel's output
+    to the new one's, so changing the filter doesn't click.
+*/
+class PartitionedConvolver
+{
+public:
+    PartitionedConvolver();
+
+    /** Allocates the delay lines and FFT buffers. Kernels for another rate or size are ignored. */
+    void prepare (int maxNumChannels, int partitionSize, int maxNumPartitions, double sampleRate);
+
+    /** Clears the input history and the output still to come, keeping the kernel. */
+    void reset() noexcept;
+
+    /** Where the producer publishes new kernels. */
+    SnapshotSlot<PartitionedKernel>& getKernelSlot() noexcept     { return kernelSlot; }
+
+    int getLatencySamples() const noexcept                          { return partitionSize; }
+
+    /** True once a kernel has been picked up. Until then the output is silent. */
+    bool hasKernel() const noexcept                                 { return kernel != nullptr; }
+
+    void process (float* const* channelData, int numChannels, int numSamples) noexcept;
+    void process (double* const* channelData, int numChannels, int numSamples) noexcept;
+
+private:
+    template <typename SampleType>
+    void processBlocks (SampleType* const* channelData, int numChannels, int numSamples) noexcept;
+
+    void processPartition (int numChannels) noexcept;
+    void convolve (int channel, const PartitionedKernel& withKernel, float* output) noexcept;
+
+    float* getInput (int channel) noexcept                  { return inputs + (size_t) (channel * 2 * partitionSize); }
+    float* getOutput (int channel) noexcept                 { return outputs + (size_t) (channel * partitionSize); }
+    float* getSpectrumReal (int channel, int index) noexcept;
+    float* getSpectrumImag (int channel, int index) noexcept;
+
+    SnapshotSlot<PartitionedKernel> kernelSlot;
+    const PartitionedKernel* kernel = nullptr;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    BiquadEngine::Kernel simdKernel;
+
+    int partitionSize = 0;
+    int maxPartitions = 0;
+    int binStride = 0;
+    int maxChannels = 0;
+    double sampleRate = 0;
+
+    // Input of the last two partitions and output of the current one, per channel
+    juce::HeapBlock<float> inputs, outputs;
+    int position = 0;
+
+    // The frequency-domain delay line, newest spectrum at head
+    juce::HeapBlock<float> spectra;
+    int head = 0;
+
+    juce::HeapBlock<float> fftBuffer, sumReal, sumImag, fadeBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PartitionedConvolver)
+};
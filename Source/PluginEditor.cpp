@@ -12,11 +12,14 @@
 
 //==============================================================================
 Project4_TemplateAudioProcessorEditor::Project4_TemplateAudioProcessorEditor (Project4_TemplateAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), spectrumDisplay (p.getSpectrumAnalyzer()), responseDisplay (p)
+  #if EQ1_INSTRUMENTATION
+    , instrumentationOverlay (p.getInstrumentation())
+  #endif
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (1000, 500);
+    setSize (1000, 800);
     
     /*
         The constructor of the AudioProcessorEditor class is used to define the properties of the GUI components that you want to add in
@@ -35,6 +38,16 @@ Project4_TemplateAudioProcessorEditor::Project4_TemplateAudioProcessorEditor (Pr
     addAndMakeVisible(gainLabel);
     addAndMakeVisible(qLabel);
     
+    addAndMakeVisible(programBox);
+    addAndMakeVisible(storeButton);
+    
+    addAndMakeVisible(spectrumDisplay);
+    addAndMakeVisible(responseDisplay);
+    
+   #if EQ1_INSTRUMENTATION
+    addAndMakeVisible(instrumentationOverlay);
+   #endif
+    
     /*
         Step 2: Use the functions defined for each GUI component class to stylise your components in the way you want it to be
     */
@@ -123,34 +136,77 @@ Project4_TemplateAudioProcessorEditor::Project4_TemplateAudioProcessorEditor (Pr
     qSlider.setRange(qParameter->range.start, qParameter->range.end, qParameter->range.interval);
     
     /*
-        Step 6: Set the default Value of the slider and knob
+        Step 6 : Bind each slider to its parameter. The binding starts the slider at the parameter's value,
+        wraps each drag in a gesture, sends what the slider holds at most bindingUpdateHz times a second,
+        and moves the slider when the host, a program or the node on the response changes the parameter
     */
-    frequencySlider.setValue(1000, juce::NotificationType::dontSendNotification);
-    gainSlider.setValue(0, juce::NotificationType::dontSendNotification);
-    qSlider.setValue(1.0f, juce::NotificationType::dontSendNotification);
+    frequencyBinding = std::make_unique<SliderBinding>(*frequencyParameter, frequencySlider);
+    gainBinding = std::make_unique<SliderBinding>(*gainParameter, gainSlider);
+    qBinding = std::make_unique<SliderBinding>(*qParameter, qSlider);
+    
+    startTimerHz(bindingUpdateHz);
     
     /*
-        Step 7 : Use the callback function to setValue of the audio processor parameters 
+        Choosing a program switches to it; Store keeps the current settings in the chosen one
     */
-    frequencySlider.onValueChange = [this]
-    {
-        *frequencyParameter = frequencySlider.getValue();
-    };
+    updateProgramBox();
     
-    gainSlider.onValueChange = [this]
+    programBox.onChange = [this]
     {
-        *gainParameter = gainSlider.getValue();
+        if (programBox.getSelectedItemIndex() >= 0)
+            audioProcessor.setCurrentProgram(programBox.getSelectedItemIndex());
     };
     
-    qSlider.onValueChange = [this]
+    storeButton.onClick = [this]
     {
-        *qParameter = qSlider.getValue();
+        audioProcessor.storeProgram(juce::jmax(0, programBox.getSelectedItemIndex()));
     };
+    
+    audioProcessor.addListener(this);
 }
 
 
 Project4_TemplateAudioProcessorEditor::~Project4_TemplateAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.removeListener(this);
+}
+
+void Project4_TemplateAudioProcessorEditor::timerCallback()
+{
+    frequencyBinding->update();
+    gainBinding->update();
+    qBinding->update();
+}
+
+void Project4_TemplateAudioProcessorEditor::updateProgramBox()
+{
+    programBox.clear(juce::NotificationType::dontSendNotification);
+    
+    for (int index = 0; index < audioProcessor.getNumPrograms(); index++)
+        programBox.addItem(audioProcessor.getProgramName(index), index + 1);
+    
+    programBox.setSelectedItemIndex(audioProcessor.getCurrentProgram(), juce::NotificationType::dontSendNotification);
+}
+
+void Project4_TemplateAudioProcessorEditor::audioProcessorChanged(juce::AudioProcessor*, const ChangeDetails& details)
+{
+    if (! details.programChanged)
+        return;
+    
+    // A host can switch programs from any thread, and the processor announces it on that thread
+    if (! juce::MessageManager::existsAndIsCurrentThread())
+    {
+        juce::MessageManager::callAsync([safeThis = juce::Component::SafePointer<Project4_TemplateAudioProcessorEditor>(this)]
+        {
+            if (safeThis != nullptr)
+                safeThis->audioProcessorChanged(&safeThis->audioProcessor, ChangeDetails().withProgramChanged(true));
+        });
+        
+        return;
+    }
+    
+    updateProgramBox();
 }
 
 //==============================================================================
@@ -175,10 +231,22 @@ void Project4_TemplateAudioProcessorEditor::resized()
     */
 
     /*
-        Dividing the GUI window into a grid
+        The spectrum and the response over it take the top of the window, the controls the 500 pixels below it
+    */
+    auto bounds = getLocalBounds();
+    spectrumDisplay.setBounds(bounds.removeFromTop(getHeight() - 500).reduced(10));
+    responseDisplay.setBounds(spectrumDisplay.getBounds());
+    
+   #if EQ1_INSTRUMENTATION
+    instrumentationOverlay.setBounds(spectrumDisplay.getRight() - 545, spectrumDisplay.getY() + 5, 540, 76);
+   #endif
+    
+    /*
+        Dividing the rest of the GUI window into a grid
     */
-    auto x = getWidth() / 10;
-    auto y = getHeight() / 10;
+    auto x = bounds.getWidth() / 10;
+    auto y = bounds.getHeight() / 10;
+    auto top = bounds.getY();
     
     // auto x = getWidth() / 10;
     // auto y = getHeight() / 10
@@ -186,13 +254,16 @@ void Project4_TemplateAudioProcessorEditor::resized()
     /*
         Use the setBounds() function to position the GUI Components (x,y) and set the width and height (width,height)
     */
-    frequencySlider.setBounds(x, 5 * y, 2 * x, 4 * y);
-    gainSlider.setBounds(4 * x, 3 * y, 2 * x, 6 * y);
-    qSlider.setBounds(7 * x, 5 * y, 2 * x, 4 * y);
+    frequencySlider.setBounds(x, top + 5 * y, 2 * x, 4 * y);
+    gainSlider.setBounds(4 * x, top + 3 * y, 2 * x, 6 * y);
+    qSlider.setBounds(7 * x, top + 5 * y, 2 * x, 4 * y);
     
     frequencyLabel.setBounds(frequencySlider.getX(), frequencySlider.getY() - 40, frequencySlider.getWidth(), y);
     gainLabel.setBounds(gainSlider.getX(), gainSlider.getY() - 40, gainSlider.getWidth(), y);
     qLabel.setBounds(qSlider.getX(), qSlider.getY() - 40, qSlider.getWidth(), y);
+    
+    programBox.setBounds(x, top + 10, 2 * x, 28);
+    storeButton.setBounds(programBox.getRight() + 10, top + 10, x, 28);
 
     
     
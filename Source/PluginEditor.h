@@ -12,11 +12,17 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumDisplay.h"
+#include "ResponseDisplay.h"
+#include "InstrumentationOverlay.h"
+#include "ParameterBinding.h"
 
 //==============================================================================
 /**
 */
-class Project4_TemplateAudioProcessorEditor  : public juce::AudioProcessorEditor
+class Project4_TemplateAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                               private juce::AudioProcessorListener,
+                                               private juce::Timer
 {
 public:
     Project4_TemplateAudioProcessorEditor (Project4_TemplateAudioProcessor&);
@@ -26,6 +32,15 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    // The sliders follow their parameters through their bindings; a program switch only has to refresh the names
+    void audioProcessorParameterChanged(juce::AudioProcessor*, int, float) override {}
+    void audioProcessorChanged(juce::AudioProcessor*, const ChangeDetails& details) override;
+    
+    void updateProgramBox();
+    
+    // Sends what the sliders hold to the host, and moves them to what it changed, this often
+    void timerCallback() override;
+    static constexpr int bindingUpdateHz = 30;
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -40,9 +55,21 @@ private:
     juce::Label gainLabel;
     juce::Label qLabel;
     
+    juce::ComboBox programBox;
+    juce::TextButton storeButton { "Store" };
+    
+    SpectrumDisplay spectrumDisplay;
+    ResponseDisplay responseDisplay;
+    
+   #if EQ1_INSTRUMENTATION
+    InstrumentationOverlay instrumentationOverlay;
+   #endif
+    
     juce::AudioParameterInt *frequencyParameter;
     juce::AudioParameterFloat  *gainParameter;
     juce::AudioParameterFloat *qParameter;
+    
+    std::unique_ptr<SliderBinding> frequencyBinding, gainBinding, qBinding;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Project4_TemplateAudioProcessorEditor)
 };
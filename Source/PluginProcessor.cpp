@@ -10,6 +10,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AllocationTrap.h"
 
 //==============================================================================
 Project4_TemplateAudioProcessor::Project4_TemplateAudioProcessor()
@@ -18,6 +19,7 @@ Project4_TemplateAudioProcessor::Project4_TemplateAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -38,25 +40,97 @@ Project4_TemplateAudioProcessor::Project4_TemplateAudioProcessor()
     addParameter(gainParameter);
     addParameter(qParameter);
     
-    // Set current variables to use for checking
-    currentFreq = *frequencyParameter;
-    currentGain = *gainParameter;
-    currentQ = *qParameter;
+    /*
+        Add the remaining bands. Band 1 keeps the original parameters, so they stay
+        first in the parameter tree, and is the only band switched on by default.
+    */
+    int nextParameterId = 4;
+    auto nextId = [&nextParameterId] { return juce::ParameterID(juce::String(nextParameterId++), 2); };
     
-    // update/compute coefficients
-    updateCoefficients();
+    for (int band = 0; band < FilterDesign::maxBands; band++)
+    {
+        auto& parameters = bandParameters[band];
+        auto prefix = "Band " + juce::String(band + 1) + " ";
+        
+        parameters.enabled = new juce::AudioParameterBool(nextId(), prefix + "Enable", band == 0);
+        parameters.type = new juce::AudioParameterChoice(nextId(), prefix + "Type", FilterDesign::getBandTypeNames(), 0);
+        parameters.slope = new juce::AudioParameterChoice(nextId(), prefix + "Slope", FilterDesign::getSlopeNames(), 0);
+        
+        addParameter(parameters.enabled);
+        addParameter(parameters.type);
+        addParameter(parameters.slope);
+        
+        if (band == 0)
+        {
+            parameters.frequency = frequencyParameter;
+            parameters.gain = gainParameter;
+            parameters.q = qParameter;
+            continue;
+        }
+        
+        parameters.frequency = new juce::AudioParameterInt(nextId(), prefix + "Frequency", 20, 20000, 1000);
+        parameters.gain = new juce::AudioParameterFloat(nextId(), prefix + "Gain", -24.0f, 24.0f, 0.f);
+        parameters.q = new juce::AudioParameterFloat(nextId(), prefix + "Q", 0.10f, 100.0f, 1.0f);
+        
+        addParameter(parameters.frequency);
+        addParameter(parameters.gain);
+        addParameter(parameters.q);
+    }
+    
+    phaseParameter = new juce::AudioParameterChoice(juce::ParameterID(juce::String(nextParameterId++), 3), "Phase",
+                                                    juce::StringArray { "Minimum", "Linear" }, 0);
+    addParameter(phaseParameter);
     
-    // initialize arrays with zeros
-    auto numInputChannels = getTotalNumInputChannels();
+    // Dynamic mode for every band, after everything else so the earlier parameters keep their indices
+    auto nextDynamicId = [&nextParameterId] { return juce::ParameterID(juce::String(nextParameterId++), 4); };
     
-    for (int i = 0; i < numInputChannels; i++)
+    for (int band = 0; band < FilterDesign::maxBands; band++)
     {
-        a1_delay.set(i, 0.0f);
-        a2_delay.set(i, 0.0f);
-        b1_delay.set(i, 0.0f);
-        b2_delay.set(i, 0.0f);
+        auto& parameters = bandParameters[band];
+        auto prefix = "Band " + juce::String(band + 1) + " ";
+        
+        parameters.dynamic = new juce::AudioParameterBool(nextDynamicId(), prefix + "Dynamic", false);
+        parameters.threshold = new juce::AudioParameterFloat(nextDynamicId(), prefix + "Threshold", -60.0f, 0.0f, -24.0f);
+        parameters.ratio = new juce::AudioParameterFloat(nextDynamicId(), prefix + "Ratio", juce::NormalisableRange<float>(1.0f, 20.0f, 0.0f, 0.4f), 4.0f);
+        parameters.attack = new juce::AudioParameterFloat(nextDynamicId(), prefix + "Attack", juce::NormalisableRange<float>(0.1f, 100.0f, 0.0f, 0.4f), 5.0f);
+        parameters.release = new juce::AudioParameterFloat(nextDynamicId(), prefix + "Release", juce::NormalisableRange<float>(5.0f, 2000.0f, 0.0f, 0.4f), 100.0f);
+        
+        addParameter(parameters.dynamic);
+        addParameter(parameters.threshold);
+        addParameter(parameters.ratio);
+        addParameter(parameters.attack);
+        addParameter(parameters.release);
     }
     
+    detectorParameter = new juce::AudioParameterChoice(nextDynamicId(), "Detector", juce::StringArray { "Input", "Sidechain" }, 0);
+    addParameter(detectorParameter);
+    
+    oversamplingParameter = new juce::AudioParameterChoice(juce::ParameterID(juce::String(nextParameterId++), 5), "Oversampling",
+                                                           juce::StringArray { "Off", "2x", "4x" }, 0);
+    addParameter(oversamplingParameter);
+    
+    // Redesign the coefficients whenever any parameter moves
+    for (auto* parameter : getParameters())
+        parameter->addListener(this);
+    
+    // update/compute coefficients
+    messageDesigner.prepare(fs);
+    
+    for (int i = 0; i < 3; i++)
+        audioDesigners[i].prepare(fs * (1 << i));
+    
+    updateCoefficients();
+    
+    // The filter state is allocated in prepareToPlay, once the host has chosen a layout
+    cascade.setCoefficients(coefficients);
+    appliedBands = messageBands;
+    
+    // Every program starts out as the default settings
+    for (int index = 0; index < ProgramBank::numPrograms; index++)
+        programBank.setProgram(index, getCurrentSettings(true));
+    
+    startTimer(updateIntervalMs);
+    
     /*
         Initialize any properties of effect classes
     */
@@ -64,6 +138,10 @@ Project4_TemplateAudioProcessor::Project4_TemplateAudioProcessor()
 
 Project4_TemplateAudioProcessor::~Project4_TemplateAudioProcessor()
 {
+    for (auto* parameter : getParameters())
+        parameter->removeListener(this);
+    
+    stopTimer();
 }
 
 //==============================================================================
@@ -101,31 +179,182 @@ bool Project4_TemplateAudioProcessor::isMidiEffect() const
 
 double Project4_TemplateAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The latency already holds the first half of the FIR, so the output ends the other half after it
+    if (isLinearPhase())
+        return (double) (getLinearPhaseLatency() + linearPhaseThread.getLatencySamples()) / fs;
+    
+    return tailLengthSeconds.load();
 }
 
 int Project4_TemplateAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return ProgramBank::numPrograms;
 }
 
 int Project4_TemplateAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void Project4_TemplateAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow(index, ProgramBank::numPrograms))
+        return;
+    
+    currentProgram.store(index);
+    
+    // Before playback there is no next block to pick the switch up, so the parameters are set here
+    if (preparedChannels == 0)
+    {
+        setCurrentSettings(programBank.getProgram(index));
+        updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+        return;
+    }
+    
+    requestedProgram.store(index);
 }
 
 const juce::String Project4_TemplateAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return juce::isPositiveAndBelow(index, ProgramBank::numPrograms) ? programBank.getName(index) : juce::String();
 }
 
 void Project4_TemplateAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    if (juce::isPositiveAndBelow(index, ProgramBank::numPrograms))
+        programBank.setName(index, newName);
+}
+
+void Project4_TemplateAudioProcessor::storeProgram(int index)
+{
+    if (! juce::isPositiveAndBelow(index, ProgramBank::numPrograms))
+        return;
+    
+    // Brings the coefficients up to date, which designs nothing if they already are
+    updateCoefficients();
+    programBank.setProgram(index, getCurrentSettings(true));
+    currentProgram.store(index);
+}
+
+ProgramBank::Program Project4_TemplateAudioProcessor::getCurrentSettings(bool includeCoefficients) const
+{
+    ProgramBank::Program settings;
+    
+    for (auto* parameter : getParameters())
+        settings.values.push_back(parameter->getValue());
+    
+    // Only coefficients designed for exactly these settings are worth keeping
+    CascadeDesigner::Bands bands;
+    getBands(bands);
+    
+    if (includeCoefficients && bands == coefficientsBands)
+    {
+        settings.coefficients = coefficients;
+        settings.sampleRate = coefficientsSampleRate;
+    }
+    
+    return settings;
+}
+
+void Project4_TemplateAudioProcessor::setCurrentSettings(const ProgramBank::Program& settings)
+{
+    setParameterValues(settings.values);
+    
+    // The redesign those changes scheduled then finds nothing to do
+    restoreCoefficients(settings);
+}
+
+void Project4_TemplateAudioProcessor::setParameterValues(const std::vector<float>& values)
+{
+    for (auto* parameter : getParameters())
+    {
+        auto index = (size_t) parameter->getParameterIndex();
+        parameter->setValueNotifyingHost(index < values.size() ? values[index] : parameter->getDefaultValue());
+    }
+}
+
+void Project4_TemplateAudioProcessor::designPrograms()
+{
+    /*
+        Programs stored or loaded at another rate are designed again for this one, so
+        that switching never has to. One with the current settings takes the current
+        coefficients, and the designer only redesigns the bands that differ from the
+        program before, so a bank of untouched programs costs nothing.
+    */
+    CascadeDesigner::Bands bands;
+    
+    for (int index = 0; index < ProgramBank::numPrograms; index++)
+    {
+        auto program = programBank.getProgram(index);
+        auto designRate = fs * getOversamplingFactor(program.values);
+        
+        if (program.sampleRate == designRate)
+            continue;
+        
+        getBands(program.values, bands);
+        
+        if (bands == coefficientsBands && coefficientsSampleRate == designRate)
+        {
+            program.coefficients = coefficients;
+        }
+        else
+        {
+            if (programDesigner.getSampleRate() != designRate)
+                programDesigner.prepare(designRate);
+            
+            programDesigner.design(bands, program.coefficients);
+        }
+        
+        program.sampleRate = designRate;
+        programBank.setProgram(index, program);
+    }
+}
+
+const ProgramBank::Program& Project4_TemplateAudioProcessor::applyProgram(int index)
+{
+    // The parameters are set without telling anyone, as listeners can't be called from here; the message thread does that after the block
+    const auto& program = programBank.getProgramForAudioThread(index);
+    
+    for (auto* parameter : getParameters())
+    {
+        auto i = (size_t) parameter->getParameterIndex();
+        parameter->setValue(i < program.values.size() ? program.values[i] : parameter->getDefaultValue());
+    }
+    
+    programChangePending.store(true);
+    return program;
+}
+
+void Project4_TemplateAudioProcessor::switchToProgram(const ProgramBank::Program& program)
+{
+    // A program designed for another rate, e.g. before the oversampling changed, is designed here instead
+    const auto* target = &program.coefficients;
+    
+    if (program.sampleRate != fs * oversampler.getFactor())
+    {
+        designAudioCoefficients(blockBands);
+        target = &audioCoefficients;
+    }
+    
+    // Ramped, or crossfaded if the sections differ, over the same 20 ms as any other change
+    if (smoothProgramChanges.load())
+        cascade.setTarget(*target);
+    else
+        cascade.setCoefficients(*target);
+    
+    appliedBands = blockBands;
+}
+
+void Project4_TemplateAudioProcessor::announceProgramChange()
+{
+    for (auto* parameter : getParameters())
+        parameter->sendValueChangedMessageToListeners(parameter->getValue());
+    
+    // Those flagged another update, which the caller is about to do, with the program's coefficients rather than a design
+    parametersChanged.store(false);
+    restoreCoefficients(programBank.getProgram(currentProgram.load()));
+    
+    updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
 }
 
 //==============================================================================
@@ -138,7 +367,59 @@ void Project4_TemplateAudioProcessor::prepareToPlay (double sampleRate, int samp
         Initialize any variables or effect class properties
     */
     fs = sampleRate;
-    resetDelays();
+    
+    // Allocating here, for the layout the host has chosen, keeps processBlock free of any allocation
+    auto numChannels = getMainBusNumOutputChannels();
+    preparedChannels = numChannels;
+    
+    // The sidechain's channels follow the main input's in the buffer
+    auto* sidechain = getBus(true, 1);
+    numSidechainChannels = sidechain != nullptr && sidechain->isEnabled() ? sidechain->getNumberOfChannels() : 0;
+    sidechainChannel = numSidechainChannels > 0 ? getChannelIndexInProcessBlockBuffer(true, 1, 0) : 0;
+    
+    // The cascade runs on the oversampled buffers, so it's prepared for blocks of up to 4 times the size
+    auto oversamplingFactor = getOversamplingFactor();
+    oversampler.prepare(numChannels, juce::jmax(samplesPerBlock, maxSubBlockSize));
+    oversampler.setFactor(oversamplingFactor);
+    
+    cascade.prepare(numChannels, samplesPerBlock * Oversampler::maxFactor,
+                    juce::jmax(1, juce::roundToInt(sampleRate * oversamplingFactor * rampLengthSeconds)));
+    cascade.setMode(processingMode);
+    cascade.setUseDoubleState(doubleStateForFloatAudio);
+    subBlockChannels.calloc(numChannels);
+    doubleSubBlockChannels.calloc(numChannels);
+    
+    // What processInterleaved converts into when the frames can't be filtered where they are
+    interleavedBlockSize = juce::jmax(samplesPerBlock, maxSubBlockSize);
+    interleavedBuffer.setSize(numChannels, interleavedBlockSize);
+    
+    // Start from the current settings rather than ramping up from nothing. Coefficients restored with the state at this rate are used as they are
+    for (int i = 0; i < 3; i++)
+        audioDesigners[i].prepare(fs * (1 << i));
+    
+    updateCoefficients();
+    cascade.setCoefficients(coefficients);
+    appliedBands = messageBands;
+    latestSnapshot = nullptr;
+    designPrograms();
+    
+    // The FIR is ready before the first block, and its latency is reported up front
+    linearPhaseThread.prepare(fs);
+    convolver.prepare(numChannels, LinearPhaseDesigner::partitionSize, linearPhaseThread.getNumPartitions(), fs);
+    
+    if (isLinearPhase())
+        linearPhaseThread.designAndWait(coefficients);
+    
+    linearPhaseBands = messageBands;
+    wasLinearPhase = isLinearPhase();
+    
+    dynamicEQ.prepare(numChannels, fs);
+    dynamicEQ.setBands(messageBands);
+    dynamicBands = messageBands;
+    
+    spectrumAnalyzer.prepare(fs);
+    
+    setLatencySamples(getLatency());
 }
 
 void Project4_TemplateAudioProcessor::releaseResources()
@@ -154,17 +435,21 @@ bool Project4_TemplateAudioProcessor::isBusesLayoutSupported (const BusesLayout&
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout with the same channels in and out, from mono up to 64 discrete,
+    // surround (5.1, 7.1.4, ...) or ambisonic (up to 3rd order) channels. Every
+    // channel gets the same EQ, so the speaker positions don't matter.
+    auto output = layouts.getMainOutputChannelSet();
+    
+    if (output.isDisabled() || output.size() > maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    if (output != layouts.getMainInputChannelSet())
+        return false;
+    
+    // The sidechain can be off, or any layout within the same limit
+    if (layouts.inputBuses.size() > 1 && layouts.inputBuses[1].size() > maxChannels)
         return false;
    #endif
 
@@ -175,23 +460,90 @@ bool Project4_TemplateAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 
 void Project4_TemplateAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    processSamples(buffer, subBlockChannels.get());
+}
+
+void Project4_TemplateAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // A 64-bit host mix bus is filtered as it is, with double state, instead of being converted to float and back
+    processSamples(buffer, doubleSubBlockChannels.get());
+}
+
+bool Project4_TemplateAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void Project4_TemplateAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    EQ1_INSTRUMENT (instrumentation.bypassedBlocks.add());
+    AudioProcessor::processBlockBypassed(buffer, midiMessages);
+}
+
+void Project4_TemplateAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    EQ1_INSTRUMENT (instrumentation.bypassedBlocks.add());
+    AudioProcessor::processBlockBypassed(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void Project4_TemplateAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, SampleType** subBlockPointers)
+{
+    // Everything was allocated in prepareToPlay; debug builds assert if anything in here allocates
+    AllocationTrap::ScopedNoAllocation noAllocation;
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    EQ1_INSTRUMENT (Instrumentation::ScopedBlockTimer blockTimer (instrumentation));
     
+    pickUpChanges();
+    filterBuffer(buffer, subBlockPointers);
+}
+
+void Project4_TemplateAudioProcessor::pickUpChanges()
+{
+    /*
+        Pick up parameter changes. Host automation of frequency, gain and Q is
+        followed on this thread, in sub-blocks. Bands switching on or off, or
+        changing type or slope, are designed on the message thread and arrive
+        through the slot, except when rendering offline: then the message thread
+        may not run between blocks, so they are designed here as well.
+    */
+    auto programIndex = requestedProgram.exchange(-1);
+    const auto* program = programIndex >= 0 ? &applyProgram(programIndex) : nullptr;
+    
+    getBands(blockBands);
+    
+    if (auto* snapshot = coefficientSlot.pull())
+        latestSnapshot = snapshot;
     
+    if (getOversamplingFactor() != oversampler.getFactor())
+        setOversamplingFactor(getOversamplingFactor());
     
-    // Check to see if parameters have changed
-    if (currentFreq != *frequencyParameter || currentGain != *gainParameter || currentQ != *qParameter)
+    if (program != nullptr)
+        switchToProgram(*program);
+    
+    if (blockBands != appliedBands && ! CascadeDesigner::haveSameTopology(blockBands, appliedBands))
     {
-        updateCoefficients();
-        
-        currentFreq = *frequencyParameter;
-        currentGain = *gainParameter;
-        currentQ = *qParameter;
+        if (isNonRealtime())
+        {
+            designAudioCoefficients(blockBands);
+            cascade.setTarget(audioCoefficients);
+            appliedBands = blockBands;
+        }
+        else if (latestSnapshot != nullptr && latestSnapshot->sampleRate == fs * oversampler.getFactor()
+                 && CascadeDesigner::haveSameTopology(latestSnapshot->bands, blockBands))
+        {
+            cascade.setTarget(latestSnapshot->coefficients);
+            appliedBands = latestSnapshot->bands;
+        }
     }
-        
+}
 
+template <typename SampleType>
+void Project4_TemplateAudioProcessor::filterBuffer(juce::AudioBuffer<SampleType>& buffer, SampleType** subBlockPointers)
+{
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
     // guaranteed to be empty - they may contain garbage).
@@ -209,30 +561,225 @@ void Project4_TemplateAudioProcessor::processBlock (juce::AudioBuffer<float>& bu
     // the samples and the outer loop is handling the channels.
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
-    for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+    /*
+        Run the enabled sections over every channel. The cascade keeps the delays
+        in registers for the whole block and filters 4 or 8 channels, or 4 sections,
+        per instruction when the layout allows it. For 20 ms after a change the
+        coefficients are ramped or crossfaded instead.
+    */
+    auto numChannels = getNumProcessedChannels(buffer);
+    spectrumAnalyzer.pushInput(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+    
+    if (processLinearPhase(buffer, numChannels))
+    {
+        processDynamics(buffer, numChannels);
+    }
+    else if (isSilent(buffer, numChannels) && cascade.hasDecayedBelow(silenceThreshold, numChannels)
+             && dynamicEQ.hasDecayedBelow(silenceThreshold, numChannels) && oversampler.hasDecayedBelow(silenceThreshold, numChannels))
     {
-        auto *channelData = buffer.getWritePointer(channel);
+        // Silent input through a filter that has rung out stays silent, so the block is left as it is
+        EQ1_INSTRUMENT (instrumentation.skippedBlocks.add());
         
-        /*
-            Place the difference equation here
-        */
-        for (int n = 0; n < buffer.getNumSamples(); n++)
+        if (blockBands != appliedBands && CascadeDesigner::haveSameTopology(blockBands, appliedBands))
         {
-            float x = channelData[n];
-            float z = (a0 * x) + (a1 * a1_delay[channel] +
-                                  a2 * a2_delay[channel] -
-                                  b1 * b1_delay[channel] -
-                                  b2 * b2_delay[channel] );
-            
-            // Update delays
-            a2_delay.set(channel, a1_delay[channel]);
-            a1_delay.set(channel, x);
-            b2_delay.set(channel, b1_delay[channel]);
-            b1_delay.set(channel, z);
+            designAudioCoefficients(blockBands);
+            cascade.setTarget(audioCoefficients, 1);
+            appliedBands = blockBands;
+        }
+        
+        cascade.skipSilentBlock();
+    }
+    else
+    {
+        if (blockBands != appliedBands && CascadeDesigner::haveSameTopology(blockBands, appliedBands))
+            processAutomatedBlock(buffer, subBlockPointers);
+        else
+            processCascade(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples());
+        
+        processDynamics(buffer, numChannels);
+    }
+    
+    spectrumAnalyzer.pushOutput(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+}
+
+template <typename SampleType>
+void Project4_TemplateAudioProcessor::processCascade(SampleType* const* channels, int numChannels, int numSamples)
+{
+    auto factor = oversampler.getFactor();
+    
+    if (factor == 1)
+    {
+        cascade.process(channels, numChannels, numSamples);
+        return;
+    }
+    
+    // Hosts can send longer blocks than they announced, so those go through in pieces
+    for (int start = 0; start < numSamples; start += oversampler.getMaxBlockSize())
+    {
+        auto length = juce::jmin(oversampler.getMaxBlockSize(), numSamples - start);
+        
+        cascade.process(oversampler.upsample(channels, numChannels, start, length), numChannels, length * factor);
+        oversampler.downsample(channels, numChannels, start, length);
+    }
+}
+
+void Project4_TemplateAudioProcessor::processInterleaved(void* data, InterleavedAudio::Format format, int numChannels, int numFrames)
+{
+    AllocationTrap::ScopedNoAllocation noAllocation;
+    juce::ScopedNoDenormals noDenormals;
+    EQ1_INSTRUMENT (Instrumentation::ScopedBlockTimer blockTimer (instrumentation));
+    
+    // Only the layout that was prepared for; anything else, or a call before prepareToPlay, is left as it is
+    jassert(numChannels <= preparedChannels);
+    
+    if (numChannels <= 0 || numChannels > preparedChannels)
+        return;
+    
+    pickUpChanges();
+    updateDynamicBands();
+    
+    /*
+        With only the static biquads to run, at the session rate and with nothing to
+        smooth or follow, the cascade filters the frames where they are, converting
+        each sample in its loop. Anything else needs the audio in separate channels,
+        so it goes through the float buffer in pieces of the prepared block size.
+    */
+    auto isFollowingAutomation = blockBands != appliedBands && CascadeDesigner::haveSameTopology(blockBands, appliedBands);
+    
+    if (isLinearPhase() || wasLinearPhase || oversampler.getFactor() != 1 || dynamicEQ.isActive() || isFollowingAutomation
+        || spectrumAnalyzer.hasDisplay() || ! cascade.processInterleaved(data, format, numChannels, numFrames))
+    {
+        for (int start = 0; start < numFrames; start += interleavedBlockSize)
+        {
+            auto length = juce::jmin(interleavedBlockSize, numFrames - start);
+            interleavedBuffer.setSize(numChannels, length, false, false, true);
             
-            channelData[n] = z * c0 + x * d0;
+            InterleavedAudio::deinterleave(data, format, numChannels, start, length, interleavedBuffer.getArrayOfWritePointers());
+            filterBuffer(interleavedBuffer, subBlockChannels.get());
+            InterleavedAudio::interleave(interleavedBuffer.getArrayOfReadPointers(), data, format, numChannels, start, length);
+        }
+    }
+}
+
+void Project4_TemplateAudioProcessor::updateDynamicBands()
+{
+    // The dynamic bands take their settings once per block; their gain moves every sample on its own
+    if (blockBands != dynamicBands)
+    {
+        dynamicEQ.setBands(blockBands);
+        dynamicBands = blockBands;
+    }
+}
+
+template <typename SampleType>
+void Project4_TemplateAudioProcessor::processDynamics(juce::AudioBuffer<SampleType>& buffer, int numChannels)
+{
+    updateDynamicBands();
+    
+    if (! dynamicEQ.isActive())
+        return;
+    
+    auto* channels = buffer.getArrayOfWritePointers();
+    
+    if (detectorParameter->getIndex() == 1 && numSidechainChannels > 0
+        && sidechainChannel + numSidechainChannels <= buffer.getNumChannels())
+    {
+        dynamicEQ.process(channels, numChannels, buffer.getArrayOfReadPointers() + sidechainChannel,
+                          numSidechainChannels, buffer.getNumSamples());
+    }
+    else
+    {
+        dynamicEQ.process(channels, numChannels, channels, numChannels, buffer.getNumSamples());
+    }
+}
+
+template <typename SampleType>
+bool Project4_TemplateAudioProcessor::processLinearPhase(juce::AudioBuffer<SampleType>& buffer, int numChannels)
+{
+    auto linearPhase = isLinearPhase();
+    
+    /*
+        Switching starts the other engine from silence. Coming back to minimum phase,
+        the biquads jump to the current settings, as they haven't been following them.
+    */
+    if (linearPhase != wasLinearPhase)
+    {
+        wasLinearPhase = linearPhase;
+        
+        if (linearPhase)
+        {
+            convolver.reset();
+        }
+        else
+        {
+            designAudioCoefficients(blockBands);
+            cascade.reset();
+            cascade.setCoefficients(audioCoefficients);
+            appliedBands = blockBands;
         }
     }
+    
+    if (! linearPhase)
+        return false;
+    
+    // Offline, the message thread may not run between blocks, so the FIR is designed here and waited for
+    if (isNonRealtime() && blockBands != linearPhaseBands)
+    {
+        designAudioCoefficients(blockBands);
+        linearPhaseThread.designAndWait(audioCoefficients);
+        linearPhaseBands = blockBands;
+    }
+    
+    convolver.process(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples());
+    return true;
+}
+
+template <typename SampleType>
+bool Project4_TemplateAudioProcessor::isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels) const
+{
+    for (int channel = 0; channel < numChannels; channel++)
+        if (buffer.getMagnitude(channel, 0, buffer.getNumSamples()) >= (SampleType) silenceThreshold)
+            return false;
+    
+    return true;
+}
+
+template <typename SampleType>
+int Project4_TemplateAudioProcessor::getNumProcessedChannels(const juce::AudioBuffer<SampleType>& buffer) const
+{
+    // Only as many channels as were prepared for; a host calling processBlock before prepareToPlay gets its audio back untouched
+    jassert(buffer.getNumChannels() <= preparedChannels + numSidechainChannels || preparedChannels == 0);
+    return juce::jmin(buffer.getNumChannels(), preparedChannels);
+}
+
+template <typename SampleType>
+void Project4_TemplateAudioProcessor::processAutomatedBlock(juce::AudioBuffer<SampleType>& buffer, SampleType** subBlockPointers)
+{
+    /*
+        The host only gives one value per block, so the settings move from where the
+        last block left them to the new values across this block, redesigned every
+        maxSubBlockSize samples with the coefficients ramped in between. However big
+        the host's buffers are, the filter follows the automation curve in steps of
+        at most 32 samples, at the cost of one block of delay.
+    */
+    auto numSamples = buffer.getNumSamples();
+    auto numChannels = getNumProcessedChannels(buffer);
+    
+    for (int start = 0; start < numSamples; start += maxSubBlockSize)
+    {
+        auto length = juce::jmin(maxSubBlockSize, numSamples - start);
+        
+        CascadeDesigner::interpolate(appliedBands, blockBands, (float) (start + length) / (float) numSamples, subBlockBands);
+        designAudioCoefficients(subBlockBands);
+        cascade.setTarget(audioCoefficients, length * oversampler.getFactor());
+        
+        for (int channel = 0; channel < numChannels; channel++)
+            subBlockPointers[channel] = buffer.getWritePointer(channel, start);
+        
+        processCascade(subBlockPointers, numChannels, length);
+    }
+    
+    appliedBands = blockBands;
 }
 
 //==============================================================================
@@ -249,15 +796,75 @@ juce::AudioProcessorEditor* Project4_TemplateAudioProcessor::createEditor()
 //==============================================================================
 void Project4_TemplateAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    /*
+        The current settings and every program, in ProgramBank's binary format, each
+        with the coefficients designed for it and their rate. Loading a session at
+        the same rate then designs nothing. Hosts may ask for the state from any
+        thread, and the coefficients are only safe to read on the message thread,
+        so from anywhere else they're left out and designed again on loading.
+    */
+    juce::MemoryOutputStream stream(destData, false);
+    
+    // A switch the audio thread hasn't picked up yet, e.g. while the instance is suspended, is saved as if it had been, so the index and the values agree
+    auto pendingProgram = requestedProgram.load();
+    
+    stream.writeInt(ProgramBank::stateTag);
+    stream.writeInt(ProgramBank::stateVersion);
+    stream.writeInt(pendingProgram >= 0 ? pendingProgram : getCurrentProgram());
+    stream.writeBool(smoothProgramChanges.load());
+    
+    if (pendingProgram >= 0)
+        ProgramBank::writeProgram(stream, programBank.getProgram(pendingProgram));
+    else
+        ProgramBank::writeProgram(stream, getCurrentSettings(juce::MessageManager::existsAndIsCurrentThread()));
+    
+    programBank.writeTo(stream);
 }
 
 void Project4_TemplateAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    juce::MemoryInputStream stream(data, (size_t) sizeInBytes, false);
+    
+    // Anything else, including the state of a newer version, leaves the settings as they are
+    if (stream.readInt() != ProgramBank::stateTag)
+        return;
+    
+    auto version = stream.readInt();
+    
+    if (version < 1 || version > ProgramBank::stateVersion)
+        return;
+    
+    auto programIndex = stream.readInt();
+    auto smooth = stream.readBool();
+    
+    ProgramBank::Program settings;
+    
+    if (! ProgramBank::readProgram(stream, settings, version) || ! programBank.readFrom(stream, version))
+        return;
+    
+    // A switch still waiting for the audio thread would undo the state
+    requestedProgram.store(-1);
+    currentProgram.store(juce::jlimit(0, ProgramBank::numPrograms - 1, programIndex));
+    smoothProgramChanges.store(smooth);
+    
+    // Only the message thread may touch the coefficients, so from anywhere else they're restored by the next timer callback
+    if (! juce::MessageManager::existsAndIsCurrentThread())
+    {
+        {
+            const juce::ScopedLock sl(restoredStateLock);
+            restoredState = settings;
+        }
+        
+        restoredStatePending.store(true);
+        setParameterValues(settings.values);
+        return;
+    }
+    
+    setCurrentSettings(settings);
+    
+    // Programs stored at another rate; before prepareToPlay the rate isn't known yet, so they're left until then
+    if (preparedChannels > 0)
+        designPrograms();
 }
 
 //==============================================================================
@@ -270,36 +877,281 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 
 void Project4_TemplateAudioProcessor::updateCoefficients()
 {
-    int frequencyValue = *frequencyParameter;
-    float gainValue = *gainParameter;
-    float qValue = *qParameter;
+    EQ1_INSTRUMENT (Instrumentation::ScopedTimer timer (instrumentation.updateCoefficients));
+    
+    // The biquads are designed for the rate they run at, which moves with the oversampling
+    auto designRate = fs * getOversamplingFactor();
+    getBands(messageBands);
     
-    float theta = 2 * M_PI * frequencyValue / fs;
-    float mu = std::pow(10.0f, (gainValue / 20.0f));
-    float xi = 4 / (1 + mu);
-    float beta = 0.5 * ((1 - xi * tan(theta / (2 * qValue))) / (1 + xi * tan(theta / (2 * qValue))));
-    float gamma = (0.5 + beta) * cos(theta);
+    // Nothing has changed since the last design, or since the coefficients were restored. Until prepareToPlay the rate is only a guess, so any will do
+    if (coefficientsSampleRate > 0 && messageBands == coefficientsBands
+        && (coefficientsSampleRate == designRate || preparedChannels == 0))
+        return;
     
-    a0 = 0.5 - beta;
-    a1 = 0.0;
-    a2 = -1 * (0.5 - beta);
-    b1 = -2 * gamma;
-    b2 = 2 * beta;
-    c0 = mu - 1.0;
-    d0 = 1.0;
+    if (messageDesigner.getSampleRate() != designRate)
+        messageDesigner.prepare(designRate);
     
+    messageDesigner.design(messageBands, coefficients);
+    coefficientsBands = messageBands;
+    coefficientsSampleRate = designRate;
+    
+    updateTailLength();
+    coefficientsVersion++;
 }
 
-void Project4_TemplateAudioProcessor::resetDelays()
+void Project4_TemplateAudioProcessor::updateTailLength()
 {
-    auto numInputChannels = getTotalNumInputChannels();
+    // The tail is how long the slowest pole takes to ring down to the silence threshold
+    auto longestTail = 0.0;
     
-    for (int i = 0; i < numInputChannels; i++)
+    for (int i = 0; i < coefficients.numSections; i++)
     {
-        a1_delay.set(i, 0.0f);
-        a2_delay.set(i, 0.0f);
-        b1_delay.set(i, 0.0f);
-        b2_delay.set(i, 0.0f);
+        const auto& section = coefficients.sections[i];
+        auto radius = FilterDesign::getPoleRadius(section);
+        
+        if (section.isIdentity() || section.hasMatchingPolesAndZeros() || radius <= 0.0)
+            continue;
+        
+        if (radius >= 1.0)
+        {
+            longestTail = std::numeric_limits<double>::infinity();
+            break;
+        }
+        
+        longestTail = juce::jmax(longestTail, std::log((double) silenceThreshold) / std::log(radius));
     }
     
+    longestTail /= coefficientsSampleRate;
+    
+    // The dynamic bands ring like their static counterparts, through a filter of their own at the session rate
+    for (const auto& band : messageBands)
+    {
+        if (! band.isDynamic())
+            continue;
+        
+        auto radius = DynamicEQ::getPoleRadius(band, fs);
+        longestTail = juce::jmax(longestTail, radius >= 1.0 ? std::numeric_limits<double>::infinity()
+                                                            : std::log((double) silenceThreshold) / std::log(radius) / fs);
+    }
+    
+    tailLengthSeconds.store(longestTail);
+}
+
+bool Project4_TemplateAudioProcessor::restoreCoefficients(const ProgramBank::Program& program)
+{
+    CascadeDesigner::Bands programBands;
+    getBands(program.values, programBands);
+    getBands(messageBands);
+    
+    if (program.sampleRate <= 0 || programBands != messageBands)
+        return false;
+    
+    coefficients = program.coefficients;
+    coefficientsBands = messageBands;
+    coefficientsSampleRate = program.sampleRate;
+    
+    updateTailLength();
+    coefficientsVersion++;
+    return true;
+}
+
+juce::RangedAudioParameter* Project4_TemplateAudioProcessor::getBandParameter(int band, BandField field) const
+{
+    jassert(juce::isPositiveAndBelow(band, FilterDesign::maxBands));
+    const auto& parameters = bandParameters[(size_t) band];
+    
+    switch (field)
+    {
+        case BandField::enabled:    return parameters.enabled;
+        case BandField::type:       return parameters.type;
+        case BandField::frequency:  return parameters.frequency;
+        case BandField::gain:       return parameters.gain;
+        case BandField::q:          return parameters.q;
+        case BandField::slope:      return parameters.slope;
+        case BandField::dynamic:    return parameters.dynamic;
+        case BandField::threshold:  return parameters.threshold;
+        case BandField::ratio:      return parameters.ratio;
+        case BandField::attack:     return parameters.attack;
+        case BandField::release:    return parameters.release;
+    }
+    
+    return nullptr;
+}
+
+FilterDesign::BandSettings Project4_TemplateAudioProcessor::getBandSettings(int band) const
+{
+    const auto& parameters = bandParameters[band];
+    
+    FilterDesign::BandSettings settings;
+    settings.enabled = *parameters.enabled;
+    settings.type = (FilterDesign::BandType) parameters.type->getIndex();
+    settings.frequency = *parameters.frequency;
+    settings.gain = *parameters.gain;
+    settings.q = *parameters.q;
+    settings.slope = (FilterDesign::Slope) parameters.slope->getIndex();
+    settings.dynamics.enabled = *parameters.dynamic;
+    settings.dynamics.threshold = *parameters.threshold;
+    settings.dynamics.ratio = *parameters.ratio;
+    settings.dynamics.attack = *parameters.attack;
+    settings.dynamics.release = *parameters.release;
+    
+    return settings;
+}
+
+void Project4_TemplateAudioProcessor::getBands(CascadeDesigner::Bands& bands) const
+{
+    for (int band = 0; band < FilterDesign::maxBands; band++)
+        bands[band] = getBandSettings(band);
+}
+
+namespace
+{
+    // What a parameter holds once set to the value in a program, or to its default if the program has none for it
+    float getValueIn(const std::vector<float>& values, juce::AudioProcessorParameter* parameter)
+    {
+        auto* ranged = static_cast<juce::RangedAudioParameter*>(parameter);
+        auto index = (size_t) parameter->getParameterIndex();
+        
+        return ranged->convertFrom0to1(index < values.size() ? values[index] : parameter->getDefaultValue());
+    }
+}
+
+void Project4_TemplateAudioProcessor::getBands(const std::vector<float>& values, CascadeDesigner::Bands& bands) const
+{
+    // Rounded and compared as the parameter classes do, so this matches getBands() once the values are set
+    for (int band = 0; band < FilterDesign::maxBands; band++)
+    {
+        const auto& parameters = bandParameters[band];
+        auto& settings = bands[band];
+        
+        settings.enabled = getValueIn(values, parameters.enabled) >= 0.5f;
+        settings.type = (FilterDesign::BandType) juce::roundToInt(getValueIn(values, parameters.type));
+        settings.frequency = juce::roundToInt(getValueIn(values, parameters.frequency));
+        settings.gain = getValueIn(values, parameters.gain);
+        settings.q = getValueIn(values, parameters.q);
+        settings.slope = (FilterDesign::Slope) juce::roundToInt(getValueIn(values, parameters.slope));
+        settings.dynamics.enabled = getValueIn(values, parameters.dynamic) >= 0.5f;
+        settings.dynamics.threshold = getValueIn(values, parameters.threshold);
+        settings.dynamics.ratio = getValueIn(values, parameters.ratio);
+        settings.dynamics.attack = getValueIn(values, parameters.attack);
+        settings.dynamics.release = getValueIn(values, parameters.release);
+    }
+}
+
+int Project4_TemplateAudioProcessor::getOversamplingFactor(const std::vector<float>& values) const
+{
+    if (juce::roundToInt(getValueIn(values, phaseParameter)) == 1)
+        return 1;
+    
+    return 1 << juce::roundToInt(getValueIn(values, oversamplingParameter));
+}
+
+void Project4_TemplateAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    // This can be called on the audio thread, so only flag the redesign for the timer
+    parametersChanged.store(true);
+}
+
+void Project4_TemplateAudioProcessor::timerCallback()
+{
+    auto needsUpdate = parametersChanged.exchange(false);
+    
+    if (restoredStatePending.exchange(false))
+    {
+        ProgramBank::Program settings;
+        
+        {
+            const juce::ScopedLock sl(restoredStateLock);
+            std::swap(settings, restoredState);
+        }
+        
+        restoreCoefficients(settings);
+        
+        if (preparedChannels > 0)
+            designPrograms();
+        
+        needsUpdate = true;
+    }
+    
+    if (programChangePending.exchange(false))
+    {
+        announceProgramChange();
+        needsUpdate = true;
+    }
+    
+    // Offline rendering designs everything in processBlock
+    if (! needsUpdate || isNonRealtime())
+        return;
+    
+    updateCoefficients();
+    coefficientSlot.publish({ coefficients, coefficientsBands, coefficientsSampleRate });
+    
+    // The FIR is only kept up to date while it's in use; switching to it designs it from scratch
+    if (isLinearPhase())
+        linearPhaseThread.requestDesign(coefficients);
+    
+    setLatencySamples(getLatency());
+}
+
+bool Project4_TemplateAudioProcessor::isLinearPhase() const
+{
+    return phaseParameter->getIndex() == 1;
+}
+
+int Project4_TemplateAudioProcessor::getLinearPhaseLatency() const
+{
+    // Half the FIR, plus one partition of the convolution
+    return linearPhaseThread.getLatencySamples() + LinearPhaseDesigner::partitionSize;
+}
+
+int Project4_TemplateAudioProcessor::getOversamplingFactor() const
+{
+    // Linear phase runs at the session rate, and its FIR is designed from the biquads' response at that rate
+    return isLinearPhase() ? 1 : 1 << oversamplingParameter->getIndex();
+}
+
+void Project4_TemplateAudioProcessor::setOversamplingFactor(int factor)
+{
+    /*
+        Called on the audio thread when the factor changes. The delay changes with it,
+        so there is a jump either way; the cascade starts again from silence at the
+        new rate, with the current settings, rather than ramping from coefficients
+        designed for another rate.
+    */
+    oversampler.setFactor(factor);
+    cascade.setRampLength(juce::jmax(1, juce::roundToInt(fs * factor * rampLengthSeconds)));
+    
+    designAudioCoefficients(blockBands);
+    cascade.reset();
+    cascade.setCoefficients(audioCoefficients);
+    appliedBands = blockBands;
+}
+
+void Project4_TemplateAudioProcessor::designAudioCoefficients(const CascadeDesigner::Bands& bands)
+{
+    getAudioDesigner().design(bands, audioCoefficients);
+    EQ1_INSTRUMENT (instrumentation.audioThreadDesigns.add());
+}
+
+int Project4_TemplateAudioProcessor::getLatency() const
+{
+    return isLinearPhase() ? getLinearPhaseLatency() : Oversampler::getLatencySamples(getOversamplingFactor());
+}
+
+void Project4_TemplateAudioProcessor::resetDelays()
+{
+    cascade.reset();
+    oversampler.reset();
+    dynamicEQ.reset();
+}
+
+void Project4_TemplateAudioProcessor::setProcessingMode(BiquadEngine::Mode newMode)
+{
+    // The engine is only switched in prepareToPlay, so the audio thread never sees it change mid-stream
+    processingMode = newMode;
+}
+
+void Project4_TemplateAudioProcessor::setDoubleStateForFloatAudio(bool shouldUseDoubleState)
+{
+    doubleStateForFloatAudio = shouldUseDoubleState;
 }
@@ -11,11 +11,23 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SmoothedCascade.h"
+#include "CascadeDesigner.h"
+#include "SnapshotSlot.h"
+#include "PartitionedConvolver.h"
+#include "LinearPhaseDesigner.h"
+#include "DynamicEQ.h"
+#include "Oversampler.h"
+#include "SpectrumAnalyzer.h"
+#include "Instrumentation.h"
+#include "ProgramBank.h"
 
 //==============================================================================
 /**
 */
-class Project4_TemplateAudioProcessor  : public juce::AudioProcessor
+class Project4_TemplateAudioProcessor  : public juce::AudioProcessor,
+                                         private juce::AudioProcessorParameter::Listener,
+                                         private juce::Timer
 {
 public:
     //==============================================================================
@@ -31,6 +43,21 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+    
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    /**
+        For hosts that hold their audio interleaved, e.g. an embedded player or an
+        offline renderer: filters numFrames frames of numChannels channels in place,
+        in 32-bit float, 16-bit or packed 24-bit integers, without converting to
+        and from separate float channels. Call it instead of processBlock, from
+        the audio thread, with at most the channels prepareToPlay was given; the
+        frames can be any number, whatever block size was prepared for.
+    */
+    void processInterleaved (void* data, InterleavedAudio::Format format, int numChannels, int numFrames);
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -55,9 +82,67 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    /** Stores the current settings, and the coefficients designed for them, as one of the programs. */
+    void storeProgram(int index);
+    
+    /** Whether switching programs crossfades to the new coefficients over 20 ms, or jumps straight to them. On by default. */
+    void setSmoothProgramChanges(bool shouldSmooth) { smoothProgramChanges.store(shouldSmooth); }
+    bool isSmoothingProgramChanges() const { return smoothProgramChanges.load(); }
+    
     void updateCoefficients();
     
     void resetDelays();
+    
+    /** Selects channel- or time-parallel filtering. Takes effect at the next prepareToPlay. */
+    void setProcessingMode(BiquadEngine::Mode newMode);
+    BiquadEngine::Mode getProcessingMode() const { return processingMode; }
+    
+    /**
+        Keeps the filter state of float audio in double, for the precision of the
+        double path without the host converting buffers, at the cost of the SIMD
+        kernels. Double audio always has double state. Takes effect at the next
+        prepareToPlay.
+    */
+    void setDoubleStateForFloatAudio(bool shouldUseDoubleState);
+    bool isUsingDoubleStateForFloatAudio() const { return doubleStateForFloatAudio; }
+    
+    /** The input and output spectra, for the editor. */
+    SpectrumAnalyzer& getSpectrumAnalyzer() { return spectrumAnalyzer; }
+    
+    enum class BandField
+    {
+        enabled = 0,
+        type,
+        frequency,
+        gain,
+        q,
+        slope,
+        dynamic,
+        threshold,
+        ratio,
+        attack,
+        release
+    };
+    
+    /** One of a band's parameters, for the tools that drive the processor, whatever it is called. */
+    juce::RangedAudioParameter* getBandParameter(int band, BandField field) const;
+    
+    /**
+        The sections the message thread last designed and the rate they're designed
+        at, for the editor to draw. Only read them on the message thread; the count
+        goes up every time they're redesigned.
+    */
+    const CascadeCoefficients& getCoefficients() const { return coefficients; }
+    double getCoefficientsSampleRate() const { return coefficientsSampleRate; }
+    juce::uint32 getCoefficientsVersion() const { return coefficientsVersion.load(); }
+    
+    // Minimum phase runs the biquads, linear phase the same curve as a symmetric FIR
+    bool isLinearPhase() const;
+    
+   #if EQ1_INSTRUMENTATION
+    /** What this instance's processing and redesigns have cost so far. Readable from any thread. */
+    const Instrumentation::ProcessorStats& getInstrumentation() const { return instrumentation; }
+   #endif
 
 private:
     //==============================================================================
@@ -70,21 +155,193 @@ private:
     juce::AudioParameterFloat *gainParameter;
     juce::AudioParameterFloat *qParameter;
     
+    // Parameters of each band. Band 1 uses the three parameters above
+    struct BandParameters
+    {
+        juce::AudioParameterBool* enabled = nullptr;
+        juce::AudioParameterChoice* type = nullptr;
+        juce::AudioParameterInt* frequency = nullptr;
+        juce::AudioParameterFloat* gain = nullptr;
+        juce::AudioParameterFloat* q = nullptr;
+        juce::AudioParameterChoice* slope = nullptr;
+        
+        // Dynamic mode, see DynamicEQ
+        juce::AudioParameterBool* dynamic = nullptr;
+        juce::AudioParameterFloat* threshold = nullptr;
+        juce::AudioParameterFloat* ratio = nullptr;
+        juce::AudioParameterFloat* attack = nullptr;
+        juce::AudioParameterFloat* release = nullptr;
+    };
+    
+    std::array<BandParameters, FilterDesign::maxBands> bandParameters;
+    
+    // Minimum or linear phase, see isLinearPhase()
+    juce::AudioParameterChoice* phaseParameter;
+    int getLinearPhaseLatency() const;
+    
+    // What the dynamic bands listen to; the sidechain falls back to the input when the host hasn't connected it
+    juce::AudioParameterChoice* detectorParameter;
+    
+    // Off, 2x or 4x for the biquads. Linear phase and the dynamic bands stay at the session rate
+    juce::AudioParameterChoice* oversamplingParameter;
+    int getOversamplingFactor() const;
+    void setOversamplingFactor(int factor);
+    int getLatency() const;
+    
+    FilterDesign::BandSettings getBandSettings(int band) const;
+    void getBands(CascadeDesigner::Bands& bands) const;
+    
+    // The same, for the values of a program rather than the parameters' current ones
+    void getBands(const std::vector<float>& values, CascadeDesigner::Bands& bands) const;
+    int getOversamplingFactor(const std::vector<float>& values) const;
+    
+    /*
+        Parameter changes are turned into coefficients on the message thread. The audio
+        thread only sets a flag, as posting a message can block, and the timer polls it.
+    */
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
+    void timerCallback() override;
+    std::atomic<bool> parametersChanged { false };
+    static constexpr int updateIntervalMs = 10;
+    
+    // Both processBlock overloads, with one cascade that runs either sample type
+    template <typename SampleType>
+    int getNumProcessedChannels(const juce::AudioBuffer<SampleType>& buffer) const;
+    
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, SampleType** subBlockPointers);
+    
+    // The start of every block, whatever form its audio is in, and the filtering of a buffer after it
+    void pickUpChanges();
+    
+    template <typename SampleType>
+    void filterBuffer(juce::AudioBuffer<SampleType>& buffer, SampleType** subBlockPointers);
+    
+    // The interleaved frames in separate channels, when they can't be filtered as they are
+    juce::AudioBuffer<float> interleavedBuffer;
+    int interleavedBlockSize = 0;
+    
+    // Runs the block through the FIR and returns true when in linear phase
+    template <typename SampleType>
+    bool processLinearPhase(juce::AudioBuffer<SampleType>& buffer, int numChannels);
+    
+    // Runs the bands in dynamic mode over the block, after the static ones
+    template <typename SampleType>
+    void processDynamics(juce::AudioBuffer<SampleType>& buffer, int numChannels);
+    void updateDynamicBands();
+    
+    // Blocks of silent input are skipped once the filter has rung out below this, about -180 dBFS
+    template <typename SampleType>
+    bool isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels) const;
+    static constexpr float silenceThreshold = 1.0e-9f;
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    
+    // Follows automation of frequency, gain and Q in sub-blocks, designed on the audio thread
+    template <typename SampleType>
+    void processAutomatedBlock(juce::AudioBuffer<SampleType>& buffer, SampleType** subBlockPointers);
+    static constexpr int maxSubBlockSize = 32;
+    
+    // Runs the cascade over the channels, at the oversampled rate if it's switched on
+    template <typename SampleType>
+    void processCascade(SampleType* const* channels, int numChannels, int numSamples);
+    
+    // The widest layout accepted; 7.1.4 is 12 channels and third-order ambisonics 16
+    static constexpr int maxChannels = 64;
+    int preparedChannels = 0;
+    
+    // Where the sidechain bus's channels start in the buffer, if the host has enabled it
+    int sidechainChannel = 0;
+    int numSidechainChannels = 0;
+    
     double fs = 44100;
     
-    float a0;
-    float a1;
-    float a2;
-    float b1;
-    float b2;
-    float c0;
-    float d0;
+    // The message thread's designs and the contiguous list of enabled sections it last built
+    CascadeDesigner messageDesigner;
+    CascadeDesigner::Bands messageBands;
+    CascadeCoefficients coefficients;
+    std::atomic<juce::uint32> coefficientsVersion { 0 };
+    
+    // The settings and rate the coefficients are for, so they're only designed again when those change
+    CascadeDesigner::Bands coefficientsBands;
+    double coefficientsSampleRate = 0;
+    
+    void updateTailLength();
+    
+    // Takes a program's coefficients instead of designing them, if they're for the current settings and rate
+    bool restoreCoefficients(const ProgramBank::Program& program);
     
-    juce::Array<float> a1_delay, a2_delay, b1_delay, b2_delay;
+    // What the message thread hands to the audio thread after a parameter change
+    struct CoefficientSnapshot
+    {
+        CascadeCoefficients coefficients;
+        CascadeDesigner::Bands bands;
+        double sampleRate = 0;
+    };
     
-    int currentFreq;
-    float currentGain;
-    float currentQ;
+    SnapshotSlot<CoefficientSnapshot> coefficientSlot;
+    const CoefficientSnapshot* latestSnapshot = nullptr;
+    
+    // The audio thread's designs, at 1x, 2x and 4x the rate, and the settings the cascade was last sent towards
+    CascadeDesigner audioDesigners[3];
+    CascadeDesigner& getAudioDesigner() { return audioDesigners[oversampler.getFactor() / 2]; }
+    void designAudioCoefficients(const CascadeDesigner::Bands& bands);
+    CascadeDesigner::Bands appliedBands, blockBands, subBlockBands;
+    CascadeCoefficients audioCoefficients;
+    juce::HeapBlock<float*> subBlockChannels;
+    juce::HeapBlock<double*> doubleSubBlockChannels;
+    
+    // Filter state and the SIMD kernels that run it, smoothed across coefficient changes
+    SmoothedCascade cascade;
+    static constexpr double rampLengthSeconds = 0.02;
+    BiquadEngine::Mode processingMode = BiquadEngine::Mode::channelParallel;
+    bool doubleStateForFloatAudio = false;
+    
+    // The linear-phase FIR, designed on its own thread and convolved on the audio thread
+    PartitionedConvolver convolver;
+    LinearPhaseDesignThread linearPhaseThread { convolver.getKernelSlot() };
+    CascadeDesigner::Bands linearPhaseBands;
+    bool wasLinearPhase = false;
+    
+    // The bands in dynamic mode, with their gain modulated every sample
+    DynamicEQ dynamicEQ;
+    CascadeDesigner::Bands dynamicBands;
+    
+    // Up to 4 times the rate around the cascade, with the oversampled buffers it runs on
+    Oversampler oversampler;
+    
+    /*
+        Programs keep the coefficients designed for them. A switch is picked up at the
+        start of the audio thread's next block, which sets the parameters and moves
+        the cascade to those coefficients; the message thread then tells the host
+        and the editor about the new values.
+    */
+    ProgramBank programBank;
+    CascadeDesigner programDesigner;
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> requestedProgram { -1 };
+    std::atomic<bool> programChangePending { false };
+    std::atomic<bool> smoothProgramChanges { true };
+    
+    // The settings of a state set off the message thread, whose coefficients wait there for the next timer callback
+    juce::CriticalSection restoredStateLock;
+    ProgramBank::Program restoredState;
+    std::atomic<bool> restoredStatePending { false };
+    
+    ProgramBank::Program getCurrentSettings(bool includeCoefficients) const;
+    void setCurrentSettings(const ProgramBank::Program& settings);
+    void setParameterValues(const std::vector<float>& values);
+    void designPrograms();
+    const ProgramBank::Program& applyProgram(int index);
+    void switchToProgram(const ProgramBank::Program& program);
+    void announceProgramChange();
+    
+    // Sees every block before and after filtering, while an editor is showing it
+    SpectrumAnalyzer spectrumAnalyzer;
+    
+   #if EQ1_INSTRUMENTATION
+    Instrumentation::ProcessorStats instrumentation;
+   #endif
     
     /*
         Declare Effect Classes
@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    ProgramBank.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ProgramBank.h"
+
+namespace
+{
+    // Far more than the processor has, to catch a corrupt count before it's allocated
+    constexpr int maxValues = 4096;
+
+    bool isValidSection (const BiquadCoefficients& section) noexcept
+    {
+        for (auto value : { section.a0, section.a1, section.a2, section.b1, section.b2, section.c0, section.d0 })
+            if (! std::isfinite (value))
+                return false;
+
+        if (section.topology == BiquadCoefficients::Topology::directForm)
+            return true;
+
+        // Negative g or k would run an unstable filter
+        const auto& s = section.stateVariable;
+
+        for (auto value : { s.g, s.k, s.outputX, s.outputV1, s.outputV2 })
+            if (! std::isfinite (value))
+                return false;
+
+        return s.g > 0.0f && s.k > 0.0f;
+    }
+}
+
+//==============================================================================
+ProgramBank::ProgramBank()
+{
+    for (int index = 0; index < numPrograms; index++)
+    {
+        programs[index].name = "Program " + juce::String (index + 1);
+        slots[index].publish (programs[index]);
+    }
+}
+
+ProgramBank::Program ProgramBank::getProgram (int index) const
+{
+    const juce::ScopedLock sl (lock);
+    return programs[index];
+}
+
+void ProgramBank::setProgram (int index, const Program& program)
+{
+    const juce::ScopedLock sl (lock);
+
+    auto name = programs[index].name;
+    programs[index] = program;
+    programs[index].name = name;
+
+    // Storing under the lock keeps this the slot's only producer
+    slots[index].publish (programs[index]);
+}
+
+juce::String ProgramBank::getName (int index) const
+{
+    const juce::ScopedLock sl (lock);
+    return programs[index].name;
+}
+
+void ProgramBank::setName (int index, const juce::String& newName)
+{
+    // The audio thread has no use for names, so they aren't published
+    const juce::ScopedLock sl (lock);
+    programs[index].name = newName;
+}
+
+const ProgramBank::Program& ProgramBank::getProgramForAudioThread (int index) noexcept
+{
+    if (auto* program = slots[index].pull())
+        audioPrograms[index] = program;
+
+    return *audioPrograms[index];
+}
+
+//==============================================================================
+void ProgramBank::writeProgram (juce::OutputStream& stream, const Program& program)
+{
+    stream.writeString (program.name);
+
+    stream.writeInt ((int) program.values.size());
+
+    for (auto value : program.values)
+        stream.writeFloat (value);
+
+    // Coefficients designed at one rate are no use at another, so the rate goes with them
+    auto numSections = program.sampleRate > 0.0 ? program.coefficients.numSections : 0;
+    stream.writeDouble (program.sampleRate);
+    stream.writeInt (numSections);
+
+    for (int i = 0; i < numSections; i++)
+    {
+        const auto& section = program.coefficients.sections[i];
+
+        stream.writeByte ((char) program.coefficients.slots[i]);
+        stream.writeByte ((char) section.topology);
+
+        for (auto value : { section.a0, section.a1, section.a2, section.b1, section.b2, section.c0, section.d0 })
+            stream.writeFloat (value);
+
+        if (section.topology == BiquadCoefficients::Topology::stateVariable)
+        {
+            const auto& s = section.stateVariable;
+
+            for (auto value : { s.g, s.k, s.outputX, s.outputV1, s.outputV2 })
+                stream.writeFloat (value);
+        }
+    }
+}
+
+bool ProgramBank::readProgram (juce::InputStream& stream, Program& program, int version)
+{
+    // Reading past the end gives zeros rather than failing, so every length is checked first
+    Program result;
+    result.name = stream.readString();
+
+    if (stream.getNumBytesRemaining() < 4)
+        return false;
+
+    auto numValues = stream.readInt();
+
+    if (! juce::isPositiveAndNotGreaterThan (numValues, maxValues) || stream.getNumBytesRemaining() < 4 * (juce::int64) numValues + 12)
+        return false;
+
+    result.values.resize ((size_t) numValues);
+
+    for (auto& value : result.values)
+        value = juce::jlimit (0.0f, 1.0f, stream.readFloat());
+
+    result.sampleRate = stream.readDouble();
+    auto numSections = stream.readInt();
+
+    if (! std::isfinite (result.sampleRate) || result.sampleRate < 0.0
+        || ! juce::isPositiveAndNotGreaterThan (numSections, CascadeCoefficients::maxSections)
+        || stream.getNumBytesRemaining() < (version >= 2 ? 30 : 29) * (juce::int64) numSections)
+        return false;
+
+    for (int i = 0; i < numSections; i++)
+    {
+        auto slot = (int) (juce::uint8) stream.readByte();
+        auto topology = version >= 2 ? (int) (juce::uint8) stream.readByte() : 0;
+
+        if (topology > (int) BiquadCoefficients::Topology::stateVariable)
+            return false;
+
+        BiquadCoefficients section;
+        section.topology = (BiquadCoefficients::Topology) topology;
+        section.a0 = stream.readFloat();
+        section.a1 = stream.readFloat();
+        section.a2 = stream.readFloat();
+        section.b1 = stream.readFloat();
+        section.b2 = stream.readFloat();
+        section.c0 = stream.readFloat();
+        section.d0 = stream.readFloat();
+
+        if (section.topology == BiquadCoefficients::Topology::stateVariable)
+        {
+            // Only these sections have the extra values, so the length check above couldn't cover them
+            if (stream.getNumBytesRemaining() < 20 + 30 * (juce::int64) (numSections - i - 1))
+                return false;
+
+            auto& s = section.stateVariable;
+            s.g = stream.readFloat();
+            s.k = stream.readFloat();
+            s.outputX = stream.readFloat();
+            s.outputV1 = stream.readFloat();
+            s.outputV2 = stream.readFloat();
+        }
+
+        if (slot >= CascadeCoefficients::maxSections || ! isValidSection (section))
+            return false;
+
+        result.coefficients.add (slot, section);
+    }
+
+    if (version < 2)
+    {
+        result.coefficients.clear();
+        result.sampleRate = 0.0;
+    }
+
+    program = std::move (result);
+    return true;
+}
+
+void ProgramBank::writeTo (juce::OutputStream& stream) const
+{
+    const juce::ScopedLock sl (lock);
+
+    stream.writeInt (numPrograms);
+
+    for (const auto& program : programs)
+        writeProgram (stream, program);
+}
+
+bool ProgramBank::readFrom (juce::InputStream& stream, int version)
+{
+    auto count = stream.readInt();
+
+    if (! juce::isPositiveAndNotGreaterThan (count, 1024))
+        return false;
+
+    // Read into a copy, so a bank that turns out to be corrupt halfway doesn't replace anything
+    std::vector<Program> loaded ((size_t) count);
+
+    for (auto& program : loaded)
+        if (! readProgram (stream, program, version))
+            return false;
+
+    const juce::ScopedLock sl (lock);
+
+    // A bank from a build with fewer programs leaves the rest as they were; one with more loses the extra
+    for (int index = 0; index < juce::jmin (count, numPrograms); index++)
+    {
+        programs[index] = std::move (loaded[(size_t) index]);
+        slots[index].publish (programs[index]);
+    }
+
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    ProgramBank.h
+
+    The processor's programs: a value for every parameter, stored together
+    with the sections already designed for them. Switching programs on the
+    audio thread then only copies the values into the parameters and sends
+    the cascade towards coefficients that are already there, without
+    designing anything. The message thread stores and names the programs;
+    each one reaches the audio thread through a SnapshotSlot of its own, so a
+    switch never waits for a store.
+
+    It also reads and writes programs in the binary state format. A state
+    starts with a tag and a version number, and a state from a newer version
+    is refused rather than misread.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQCascade.h"
+#include "SnapshotSlot.h"
+
+class ProgramBank
+{
+public:
+    static constexpr int numPrograms = 8;
+
+    struct Program
+    {
+        juce::String name;
+
+        // Every parameter's normalised value, in the processor's parameter order
+        std::vector<float> values;
+
+        // The sections of the static bands for those values, designed at sampleRate, or 0 if they haven't been
+        CascadeCoefficients coefficients;
+        double sampleRate = 0.0;
+    };
+
+    ProgramBank();
+
+    //==============================================================================
+    /** A copy of a program. Any thread but the audio thread. */
+    Program getProgram (int index) const;
+
+    /** Replaces a program, keeping its name, and hands it to the audio thread. Any thread but the audio thread. */
+    void setProgram (int index, const Program& program);
+
+    juce::String getName (int index) const;
+    void setName (int index, const juce::String& newName);
+
+    /** The newest version of a program, for the audio thread. It stays valid until the next call with the same index. */
+    const Program& getProgramForAudioThread (int index) noexcept;
+
+    //==============================================================================
+    static constexpr juce::int32 stateTag = 0x53315145;    // "EQ1S" in the first four bytes
+    /**
+        Version 2 added each section's topology. The sections of a version 1 state
+        are read and dropped, so the programs are designed again with the
+        topologies this version would pick.
+    */
+    static constexpr juce::int32 stateVersion = 2;
+
+    static void writeProgram (juce::OutputStream& stream, const Program& program);
+
+    /**
+        Reads a program written by the given version of the format. False, leaving
+        the program as it was, if the stream ends early or holds anything impossible.
+    */
+    static bool readProgram (juce::InputStream& stream, Program& program, int version = stateVersion);
+
+    /** Every program in turn. */
+    void writeTo (juce::OutputStream& stream) const;
+
+    /** Replaces every program, names included, or none of them if the stream can't be read. */
+    bool readFrom (juce::InputStream& stream, int version = stateVersion);
+
+private:
+    juce::CriticalSection lock;
+    Program programs[numPrograms];
+
+    SnapshotSlot<Program> slots[numPrograms];
+    const Program* audioPrograms[numPrograms] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProgramBank)
+};
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    ResponseDisplay.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ResponseDisplay.h"
+
+//==============================================================================
+namespace
+{
+    // Band 1's frequency, gain and Q are the first three parameters
+    juce::RangedAudioParameter& getBandParameter (juce::AudioProcessor& processor, int index)
+    {
+        return *(juce::RangedAudioParameter*) processor.getParameters().getUnchecked (index);
+    }
+}
+
+//==============================================================================
+ResponseDisplay::ResponseDisplay (Project4_TemplateAudioProcessor& processorToShow)
+    : processor (processorToShow),
+      frequencyBinding (getBandParameter (processorToShow, 0)),
+      gainBinding (getBandParameter (processorToShow, 1)),
+      qBinding (getBandParameter (processorToShow, 2))
+{
+    // Moving the node only repaints; the curve catches up when the processor has the new coefficients
+    for (auto* binding : { &frequencyBinding, &gainBinding, &qBinding })
+        binding->onChange = [this] (float) { repaint(); };
+
+    setOpaque (false);
+    setBufferedToImage (true);
+
+    drawnVersion = processor.getCoefficientsVersion();
+    evaluateResponse();
+}
+
+float ResponseDisplay::getX (double frequency) const noexcept
+{
+    return (float) (getWidth() * std::log (frequency / 20.0) / std::log (1000.0));
+}
+
+double ResponseDisplay::getFrequency (float x) const noexcept
+{
+    return 20.0 * std::pow (1000.0, x / (double) juce::jmax (1, getWidth()));
+}
+
+float ResponseDisplay::getMagnitudeY (float decibels) const noexcept
+{
+    return juce::jmap (juce::jlimit (-topDecibels, topDecibels, decibels), topDecibels, -topDecibels, 0.0f, (float) getHeight());
+}
+
+float ResponseDisplay::getPhaseY (float radians) const noexcept
+{
+    auto pi = juce::MathConstants<float>::pi;
+    return juce::jmap (radians, pi, -pi, 0.0f, (float) getHeight());
+}
+
+juce::Point<float> ResponseDisplay::getNodePosition() const
+{
+    return { getX ((double) frequencyBinding.getValue()), getMagnitudeY (gainBinding.getValue()) };
+}
+
+//==============================================================================
+void ResponseDisplay::update()
+{
+    for (auto* binding : { &frequencyBinding, &gainBinding, &qBinding })
+        binding->update();
+
+    updateResponse();
+}
+
+void ResponseDisplay::updateResponse()
+{
+    auto version = processor.getCoefficientsVersion();
+
+    if (version == drawnVersion)
+        return;
+
+    drawnVersion = version;
+    evaluateResponse();
+    updatePaths();
+    repaint();
+}
+
+void ResponseDisplay::evaluateResponse()
+{
+    auto sampleRate = processor.getCoefficientsSampleRate();
+
+    if (sampleRate <= 0.0)
+        return;
+
+    if (response.getSampleRate() != sampleRate)
+        response.prepare (sampleRate);
+
+    response.evaluate (processor.getCoefficients(), magnitudeDecibels, phaseRadians);
+
+    // The FIR of linear phase has the magnitude of the biquads, and no phase shift once its delay is compensated
+    showPhase = ! processor.isLinearPhase();
+}
+
+void ResponseDisplay::updatePaths()
+{
+    magnitudePath.clear();
+    phasePath.clear();
+
+    auto numPoints = response.getNumValidPoints();
+
+    for (int point = 0; point < numPoints; point++)
+    {
+        auto x = getX (FrequencyResponse::getPointFrequency (point));
+        auto magnitudeY = getMagnitudeY (magnitudeDecibels[point]);
+        auto phaseY = getPhaseY (phaseRadians[point]);
+
+        if (point == 0)
+        {
+            magnitudePath.startNewSubPath (x, magnitudeY);
+            phasePath.startNewSubPath (x, phaseY);
+        }
+        else
+        {
+            magnitudePath.lineTo (x, magnitudeY);
+
+            // Break the line where the phase wraps from -pi to pi
+            if (std::abs (phaseRadians[point] - phaseRadians[point - 1]) > juce::MathConstants<float>::pi)
+                phasePath.startNewSubPath (x, phaseY);
+            else
+                phasePath.lineTo (x, phaseY);
+        }
+    }
+}
+
+void ResponseDisplay::paint (juce::Graphics& g)
+{
+    if (showPhase)
+    {
+        g.setColour (juce::Colours::lightblue.withAlpha (0.5f));
+        g.strokePath (phasePath, juce::PathStrokeType (1.0f));
+    }
+
+    g.setColour (juce::Colours::white);
+    g.strokePath (magnitudePath, juce::PathStrokeType (2.0f));
+
+    auto node = getNodePosition();
+    g.setColour (juce::Colours::red);
+    g.fillEllipse (juce::Rectangle<float> (2.0f * nodeRadius, 2.0f * nodeRadius).withCentre (node));
+    g.setColour (juce::Colours::white);
+    g.drawEllipse (juce::Rectangle<float> (2.0f * nodeRadius, 2.0f * nodeRadius).withCentre (node), 1.5f);
+}
+
+void ResponseDisplay::resized()
+{
+    updatePaths();
+}
+
+//==============================================================================
+bool ResponseDisplay::hitTest (int x, int y)
+{
+    // Only the node takes the mouse
+    return getNodePosition().getDistanceFrom ({ (float) x, (float) y }) <= 2.0f * nodeRadius;
+}
+
+void ResponseDisplay::mouseDown (const juce::MouseEvent&)
+{
+    frequencyBinding.beginGesture();
+    gainBinding.beginGesture();
+}
+
+void ResponseDisplay::mouseDrag (const juce::MouseEvent& e)
+{
+    auto position = e.position.toFloat();
+    auto gain = juce::jmap (position.y, 0.0f, (float) getHeight(), topDecibels, -topDecibels);
+
+    frequencyBinding.setValue ((float) getFrequency (position.x));
+    gainBinding.setValue (gain);
+    repaint();
+}
+
+void ResponseDisplay::mouseUp (const juce::MouseEvent&)
+{
+    frequencyBinding.endGesture();
+    gainBinding.endGesture();
+}
+
+void ResponseDisplay::mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    // A notch of the wheel is about a sixth of an octave of Q
+    auto q = qBinding.getValue() * std::pow (2.0f, wheel.deltaY * (wheel.isReversed ? -1.0f : 1.0f));
+
+    // Outside a gesture, so sent at once as one of its own
+    qBinding.setValue (q);
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    ResponseDisplay.h
+
+    Draws the magnitude and phase of the processor's current cascade over the
+    spectrum, with a node for band 1 that drags its frequency and gain and
+    scrolls its Q. The processor counts its coefficient updates; the display
+    looks at the count once per display refresh and only evaluates the
+    response and rebuilds its paths when it has moved. The component is
+    buffered to an image, so the spectrum repainting underneath it, or the
+    sliders moving, composite the cached curve rather than stroking 1024
+    points again. Bands in dynamic mode are drawn at rest, which is flat.
+
+    The node goes through ParameterBindings, updated on the same refresh, so
+    a drag is one gesture whose values reach the host once per frame, and
+    the node follows the sliders and automation without being told to.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "FrequencyResponse.h"
+#include "ParameterBinding.h"
+
+class ResponseDisplay  : public juce::Component
+{
+public:
+    explicit ResponseDisplay (Project4_TemplateAudioProcessor& processorToShow);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+    bool hitTest (int x, int y) override;
+    void mouseDown (const juce::MouseEvent&) override;
+    void mouseDrag (const juce::MouseEvent&) override;
+    void mouseUp (const juce::MouseEvent&) override;
+    void mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+private:
+    void update();
+    void updateResponse();
+    void evaluateResponse();
+    void updatePaths();
+
+    float getX (double frequency) const noexcept;
+    double getFrequency (float x) const noexcept;
+    float getMagnitudeY (float decibels) const noexcept;
+    float getPhaseY (float radians) const noexcept;
+    juce::Point<float> getNodePosition() const;
+
+    Project4_TemplateAudioProcessor& processor;
+    ParameterBinding frequencyBinding, gainBinding, qBinding;
+
+    FrequencyResponse response;
+    float magnitudeDecibels[FrequencyResponse::numPoints];
+    float phaseRadians[FrequencyResponse::numPoints];
+    juce::uint32 drawnVersion = 0;
+    bool showPhase = true;
+
+    juce::Path magnitudePath, phasePath;
+
+    juce::VBlankAttachment vBlankAttachment { this, [this] { update(); } };
+
+    static constexpr float topDecibels = 24.0f;
+    static constexpr float nodeRadius = 7.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseDisplay)
+};
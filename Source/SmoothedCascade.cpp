@@ -0,0 +1,307 @@
+/*
+  ==============================================================================
+
+    SmoothedCascade.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "SmoothedCascade.h"
+
+//==============================================================================
+void SmoothedCascade::prepare (int maxNumChannels, int maxBlockSize, int rampLengthSamples)
+{
+    for (auto& cascade : cascades)
+        cascade.prepare (maxNumChannels);
+
+    auto fadeChunk = juce::jlimit (1, maxFadeChunk, maxBlockSize);
+    fadeBuffer.setSize (maxNumChannels, fadeChunk);
+    doubleFadeBuffer.setSize (maxNumChannels, fadeChunk);
+    channelPointers.calloc ((size_t) juce::jmax (1, maxNumChannels));
+    doubleChannelPointers.calloc ((size_t) juce::jmax (1, maxNumChannels));
+
+    rampLength = juce::jmax (1, rampLengthSamples);
+    rampRemaining = 0;
+    fadeRemaining = 0;
+    hasPending = false;
+}
+
+void SmoothedCascade::reset() noexcept
+{
+    for (auto& cascade : cascades)
+        cascade.reset();
+}
+
+void SmoothedCascade::setMode (BiquadEngine::Mode newMode) noexcept
+{
+    for (auto& cascade : cascades)
+        cascade.setMode (newMode);
+}
+
+void SmoothedCascade::setKernel (BiquadEngine::Kernel newKernel) noexcept
+{
+    for (auto& cascade : cascades)
+        cascade.setKernel (newKernel);
+}
+
+void SmoothedCascade::setUseDoubleState (bool shouldUseDoubleState) noexcept
+{
+    for (auto& cascade : cascades)
+        cascade.setUseDoubleState (shouldUseDoubleState);
+}
+
+void SmoothedCascade::setRampLength (int rampLengthSamples) noexcept
+{
+    rampLength = juce::jmax (1, rampLengthSamples);
+    fadeRemaining = juce::jmin (fadeRemaining, rampLength);
+}
+
+//==============================================================================
+void SmoothedCascade::setCoefficients (const CascadeCoefficients& newCoefficients) noexcept
+{
+    current = newCoefficients;
+    target = newCoefficients;
+    rampRemaining = 0;
+    fadeRemaining = 0;
+    hasPending = false;
+}
+
+void SmoothedCascade::setTarget (const CascadeCoefficients& newTarget) noexcept
+{
+    setTarget (newTarget, rampLength);
+}
+
+void SmoothedCascade::setTarget (const CascadeCoefficients& newTarget, int numRampSamples) noexcept
+{
+    // A crossfade always runs to the end, otherwise a third cascade would be needed
+    if (fadeRemaining > 0)
+    {
+        pending = newTarget;
+        hasPending = true;
+        return;
+    }
+
+    target = newTarget;
+
+    if (haveSameSections (current, target))
+        startRamp (juce::jmax (1, numRampSamples));
+    else
+        startCrossfade();
+}
+
+bool SmoothedCascade::haveSameSections (const CascadeCoefficients& a, const CascadeCoefficients& b) noexcept
+{
+    if (a.numSections != b.numSections || std::memcmp (a.slots, b.slots, (size_t) a.numSections * sizeof (a.slots[0])) != 0)
+        return false;
+
+    // A section changing topology has different delays, so it can't ramp
+    for (int i = 0; i < a.numSections; i++)
+        if (a.sections[i].topology != b.sections[i].topology)
+            return false;
+
+    return true;
+}
+
+void SmoothedCascade::startRamp (int numRampSamples) noexcept
+{
+    // Restarting from wherever the previous ramp had got to keeps the coefficients continuous
+    auto scale = 1.0f / (float) numRampSamples;
+
+    increments = current;
+
+    for (int i = 0; i < current.numSections; i++)
+    {
+        const auto& from = current.sections[i];
+        const auto& to = target.sections[i];
+        auto& step = increments.sections[i];
+
+        step.a0 = (to.a0 - from.a0) * scale;
+        step.a1 = (to.a1 - from.a1) * scale;
+        step.a2 = (to.a2 - from.a2) * scale;
+        step.b1 = (to.b1 - from.b1) * scale;
+        step.b2 = (to.b2 - from.b2) * scale;
+        step.c0 = (to.c0 - from.c0) * scale;
+        step.d0 = (to.d0 - from.d0) * scale;
+
+        step.stateVariable.g = (to.stateVariable.g - from.stateVariable.g) * scale;
+        step.stateVariable.k = (to.stateVariable.k - from.stateVariable.k) * scale;
+        step.stateVariable.outputX = (to.stateVariable.outputX - from.stateVariable.outputX) * scale;
+        step.stateVariable.outputV1 = (to.stateVariable.outputV1 - from.stateVariable.outputV1) * scale;
+        step.stateVariable.outputV2 = (to.stateVariable.outputV2 - from.stateVariable.outputV2) * scale;
+    }
+
+    rampRemaining = numRampSamples;
+}
+
+void SmoothedCascade::startCrossfade() noexcept
+{
+    fadingOut = current;
+    current = target;
+    rampRemaining = 0;
+    fadeRemaining = rampLength;
+
+    // The incoming cascade starts from silence, the outgoing one keeps its state until the fade ends
+    activeCascade ^= 1;
+    cascades[activeCascade].reset();
+}
+
+//==============================================================================
+void SmoothedCascade::process (float* const* channelData, int numChannels, int numSamples) noexcept
+{
+    processChunks (channelData, numChannels, numSamples, channelPointers.get(), fadeBuffer);
+}
+
+void SmoothedCascade::process (double* const* channelData, int numChannels, int numSamples) noexcept
+{
+    processChunks (channelData, numChannels, numSamples, doubleChannelPointers.get(), doubleFadeBuffer);
+}
+
+bool SmoothedCascade::processInterleaved (void* data, InterleavedAudio::Format format, int numChannels, int numFrames) noexcept
+{
+    if (isSmoothing())
+        return false;
+
+    isIdle = false;
+    cascades[activeCascade].processInterleaved (data, format, numChannels, numFrames, current);
+    return true;
+}
+
+bool SmoothedCascade::hasDecayedBelow (float threshold, int numChannels) const noexcept
+{
+    if (isIdle)
+        return true;
+
+    if (fadeRemaining > 0 && ! cascades[activeCascade ^ 1].hasDecayedBelow (threshold, numChannels))
+        return false;
+
+    return cascades[activeCascade].hasDecayedBelow (threshold, numChannels);
+}
+
+void SmoothedCascade::skipSilentBlock() noexcept
+{
+    if (! isIdle)
+    {
+        reset();
+        isIdle = true;
+    }
+
+    if (hasPending)
+    {
+        target = pending;
+        hasPending = false;
+    }
+
+    if (isSmoothing())
+    {
+        current = target;
+        rampRemaining = 0;
+        fadeRemaining = 0;
+    }
+}
+
+template <typename SampleType>
+void SmoothedCascade::processChunks (SampleType* const* channelData, int numChannels, int numSamples,
+                                     SampleType** pointers, juce::AudioBuffer<SampleType>& fade) noexcept
+{
+    jassert (numChannels <= fade.getNumChannels());
+    isIdle = false;
+
+    for (int done = 0; done < numSamples;)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+            pointers[channel] = channelData[channel] + done;
+
+        auto remaining = numSamples - done;
+        int length;
+
+        if (fadeRemaining > 0)
+        {
+            length = juce::jmin (remaining, fadeRemaining, fade.getNumSamples());
+            processCrossfade (pointers, numChannels, length, fade);
+
+            if (fadeRemaining == 0 && hasPending)
+            {
+                hasPending = false;
+                setTarget (pending);
+            }
+        }
+        else if (rampRemaining > 0)
+        {
+            length = juce::jmin (remaining, rampRemaining);
+            processRamp (pointers, numChannels, length);
+        }
+        else
+        {
+            length = remaining;
+            cascades[activeCascade].process (pointers, numChannels, length, current);
+        }
+
+        done += length;
+    }
+}
+
+template <typename SampleType>
+void SmoothedCascade::processRamp (SampleType* const* channelData, int numChannels, int numSamples) noexcept
+{
+    cascades[activeCascade].processRamp (channelData, numChannels, numSamples, current, increments);
+    rampRemaining -= numSamples;
+
+    if (rampRemaining == 0)
+    {
+        current = target;
+        return;
+    }
+
+    // Move on to where the kernel got to, which is start + numSamples * increment
+    auto steps = (float) numSamples;
+
+    for (int i = 0; i < current.numSections; i++)
+    {
+        auto& c = current.sections[i];
+        const auto& step = increments.sections[i];
+
+        c.a0 += steps * step.a0;
+        c.a1 += steps * step.a1;
+        c.a2 += steps * step.a2;
+        c.b1 += steps * step.b1;
+        c.b2 += steps * step.b2;
+        c.c0 += steps * step.c0;
+        c.d0 += steps * step.d0;
+
+        c.stateVariable.g += steps * step.stateVariable.g;
+        c.stateVariable.k += steps * step.stateVariable.k;
+        c.stateVariable.outputX += steps * step.stateVariable.outputX;
+        c.stateVariable.outputV1 += steps * step.stateVariable.outputV1;
+        c.stateVariable.outputV2 += steps * step.stateVariable.outputV2;
+    }
+}
+
+template <typename SampleType>
+void SmoothedCascade::processCrossfade (SampleType* const* channelData, int numChannels, int numSamples,
+                                        juce::AudioBuffer<SampleType>& fade) noexcept
+{
+    for (int channel = 0; channel < numChannels; channel++)
+        fade.copyFrom (channel, 0, channelData[channel], numSamples);
+
+    cascades[activeCascade ^ 1].process (fade.getArrayOfWritePointers(), numChannels, numSamples, fadingOut);
+    cascades[activeCascade].process (channelData, numChannels, numSamples, current);
+
+    auto position = rampLength - fadeRemaining;
+    auto scale = (SampleType) 1 / (SampleType) rampLength;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto* out = channelData[channel];
+        auto* old = fade.getReadPointer (channel);
+
+        for (int n = 0; n < numSamples; n++)
+        {
+            auto gain = (SampleType) (position + n + 1) * scale;
+            out[n] = old[n] + gain * (out[n] - old[n]);
+        }
+    }
+
+    fadeRemaining -= numSamples;
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    SmoothedCascade.h
+
+    Moves the cascade from one set of coefficients to the next without zipper
+    noise. If only coefficient values change, every coefficient is ramped
+    linearly per sample; a straight line between two stable sections stays
+    stable, because the stable (b1, b2) region is a triangle, and so does one
+    between two state-variable sections, whose g and k only need to stay
+    positive. If the set of sections changes (a band switched on or off, a new
+    type or slope, or a section moving between the direct form and the
+    state-variable filter), the old and new cascades run side by side and
+    their outputs are crossfaded.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQCascade.h"
+
+class SmoothedCascade
+{
+public:
+    SmoothedCascade() = default;
+
+    /** Allocates both cascades and the crossfade buffers. Call from prepareToPlay. */
+    void prepare (int maxNumChannels, int maxBlockSize, int rampLengthSamples);
+
+    void reset() noexcept;
+
+    void setMode (BiquadEngine::Mode newMode) noexcept;
+    void setKernel (BiquadEngine::Kernel newKernel) noexcept;
+
+    /** Keeps the delays of float audio in double. See EQCascade::setUseDoubleState(). */
+    void setUseDoubleState (bool shouldUseDoubleState) noexcept;
+
+    /** Changes the ramp and crossfade length, e.g. when the rate the cascade runs at changes. Doesn't allocate. */
+    void setRampLength (int rampLengthSamples) noexcept;
+
+    /** Jumps straight to new coefficients, without smoothing. */
+    void setCoefficients (const CascadeCoefficients& newCoefficients) noexcept;
+
+    /** Moves to new coefficients over the ramp length. */
+    void setTarget (const CascadeCoefficients& newTarget) noexcept;
+
+    /**
+        Same, but ramps over a given number of samples instead, e.g. one sub-block of
+        an automation curve. Changes of topology still crossfade over the ramp length.
+    */
+    void setTarget (const CascadeCoefficients& newTarget, int numRampSamples) noexcept;
+
+    /** The coefficients the cascade is heading for (or sitting at). */
+    const CascadeCoefficients& getTarget() const noexcept   { return target; }
+
+    bool isSmoothing() const noexcept                       { return rampRemaining > 0 || fadeRemaining > 0; }
+
+    void process (float* const* channelData, int numChannels, int numSamples) noexcept;
+    void process (double* const* channelData, int numChannels, int numSamples) noexcept;
+
+    /**
+        Filters interleaved frames in place with the current coefficients. Ramps and
+        crossfades need the audio in separate channels, so while one is running this
+        returns false and leaves the frames alone.
+    */
+    bool processInterleaved (void* data, InterleavedAudio::Format format, int numChannels, int numFrames) noexcept;
+
+    /**
+        True if the filter has rung out: every delay of the cascade, and of the one
+        being faded out, is below threshold on the first numChannels channels.
+    */
+    bool hasDecayedBelow (float threshold, int numChannels) const noexcept;
+
+    /**
+        Call instead of process() for a block of silent input once the filter has
+        rung out. The first call clears the delays, so they hold exact zeros rather
+        than decaying through denormals; every call jumps straight to the latest
+        target, since there is nothing audible to smooth.
+    */
+    void skipSilentBlock() noexcept;
+
+private:
+    static bool haveSameSections (const CascadeCoefficients& a, const CascadeCoefficients& b) noexcept;
+
+    void startRamp (int numRampSamples) noexcept;
+    void startCrossfade() noexcept;
+
+    template <typename SampleType>
+    void processChunks (SampleType* const* channelData, int numChannels, int numSamples,
+                        SampleType** pointers, juce::AudioBuffer<SampleType>& fade) noexcept;
+
+    template <typename SampleType>
+    void processRamp (SampleType* const* channelData, int numChannels, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void processCrossfade (SampleType* const* channelData, int numChannels, int numSamples,
+                           juce::AudioBuffer<SampleType>& fade) noexcept;
+
+    EQCascade cascades[2];
+    int activeCascade = 0;
+
+    CascadeCoefficients current, target, increments, fadingOut, pending;
+    bool hasPending = false;
+
+    int rampLength = 0;
+    int rampRemaining = 0;
+    int fadeRemaining = 0;
+    bool isIdle = false;
+
+    // Crossfades are run in chunks of at most maxFadeChunk samples, so the buffers stay small whatever the block size
+    static constexpr int maxFadeChunk = 256;
+
+    juce::AudioBuffer<float> fadeBuffer;
+    juce::AudioBuffer<double> doubleFadeBuffer;
+    juce::HeapBlock<float*> channelPointers;
+    juce::HeapBlock<double*> doubleChannelPointers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SmoothedCascade)
+};
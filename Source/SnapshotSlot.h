@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    SnapshotSlot.h
+
+    Single-producer / single-consumer handoff of the latest value of a
+    snapshot, built as a triple buffer. The producer never waits for the
+    consumer and the consumer never waits for the producer; if several
+    snapshots are published between two pulls, the consumer only sees the
+    newest one.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename Snapshot>
+class SnapshotSlot
+{
+public:
+    SnapshotSlot() = default;
+
+    /** Producer side. Copies the snapshot in and makes it the newest one. */
+    void publish (const Snapshot& snapshot) noexcept
+    {
+        buffers[back] = snapshot;
+        back = middle.exchange (back | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /**
+        Consumer side. Returns the newest snapshot if one was published since the
+        last pull, or nullptr. The snapshot stays valid until the next pull.
+    */
+    const Snapshot* pull() noexcept
+    {
+        if ((middle.load (std::memory_order_acquire) & freshFlag) == 0)
+            return nullptr;
+
+        front = middle.exchange (front, std::memory_order_acq_rel) & indexMask;
+        return &buffers[front];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    Snapshot buffers[3];
+
+    // The index of the buffer in between, plus a flag saying it hasn't been pulled yet
+    alignas (64) std::atomic<int> middle { 1 };
+
+    alignas (64) int back = 0;      // only touched by the producer
+    alignas (64) int front = 2;     // only touched by the consumer
+
+    JUCE_DECLARE_NON_COPYABLE (SnapshotSlot)
+};
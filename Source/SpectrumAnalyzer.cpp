@@ -0,0 +1,305 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+//==============================================================================
+SpectrumAnalysisThread::SpectrumAnalysisThread()
+    : juce::Thread ("EQ1 spectrum analysis")
+{
+}
+
+SpectrumAnalysisThread::~SpectrumAnalysisThread()
+{
+    stopThread (2000);
+}
+
+void SpectrumAnalysisThread::add (SpectrumAnalyzer& analyzer)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        analyzers.addIfNotAlreadyThere (&analyzer);
+    }
+
+    if (! isThreadRunning())
+        startThread();
+
+    notify();
+}
+
+void SpectrumAnalysisThread::remove (SpectrumAnalyzer& analyzer)
+{
+    // Once this returns, the thread is no longer inside the analyzer
+    const juce::ScopedLock sl (lock);
+    analyzers.removeFirstMatchingValue (&analyzer);
+}
+
+void SpectrumAnalysisThread::run()
+{
+    while (! threadShouldExit())
+    {
+        bool anyAttached;
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            for (auto* analyzer : analyzers)
+                analyzer->analyse();
+
+            anyAttached = ! analyzers.isEmpty();
+        }
+
+        wait (anyAttached ? 10 : -1);
+    }
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer()
+{
+    std::fill (frame.input, frame.input + numPoints, minDecibels);
+    std::fill (frame.output, frame.output + numPoints, minDecibels);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    analysisThread->remove (*this);
+}
+
+double SpectrumAnalyzer::getPointFrequency (int point) noexcept
+{
+    return 20.0 * std::pow (1000.0, point / (double) (numPoints - 1));
+}
+
+void SpectrumAnalyzer::prepare (double sampleRate)
+{
+    // The analysis thread may be reading the buffers that are about to be replaced
+    const juce::ScopedLock sl (analysisThread->getLock());
+
+    // About 11 Hz per bin at any rate, and a frame every 21 ms
+    auto order = sampleRate <= 50000.0 ? 12 : (sampleRate <= 100000.0 ? 13 : 14);
+    fft = std::make_unique<juce::dsp::FFT> (order);
+    fftSize = 1 << order;
+    hopSize = fftSize / 4;
+
+    // Room for 4 frames, so the analysis thread can fall well behind before anything is dropped
+    fifo.setTotalSize (4 * fftSize);
+    fifoInput.calloc ((size_t) (4 * fftSize));
+    fifoOutput.calloc ((size_t) (4 * fftSize));
+    isWriting = false;
+
+    inputHistory.calloc ((size_t) fftSize);
+    outputHistory.calloc ((size_t) fftSize);
+    fftBuffer.calloc ((size_t) (2 * fftSize));
+    window.calloc ((size_t) fftSize);
+    historyPosition = 0;
+    samplesSinceFrame = 0;
+
+    // Hann, scaled so a full-scale sine reads 0 dB
+    for (int i = 0; i < fftSize; i++)
+        window[i] = (float) ((1.0 - std::cos (juce::MathConstants<double>::twoPi * i / fftSize)) * 2.0 / fftSize);
+
+    // Levels fall at 40 dB per second and rise at once
+    decayPerFrame = (float) (40.0 * hopSize / sampleRate);
+
+    pointStartBin.calloc ((size_t) numPoints);
+    pointEndBin.calloc ((size_t) numPoints);
+    pointBinPosition.calloc ((size_t) numPoints);
+
+    auto binWidth = sampleRate / fftSize;
+    auto halfStep = std::pow (1000.0, 0.5 / (numPoints - 1));
+    auto lastBin = fftSize / 2;
+
+    for (int point = 0; point < numPoints; point++)
+    {
+        auto frequency = getPointFrequency (point);
+        auto start = juce::jlimit (0, lastBin, (int) std::ceil (frequency / halfStep / binWidth));
+        auto end = juce::jlimit (0, lastBin, (int) std::floor (frequency * halfStep / binWidth) + 1);
+
+        pointStartBin[point] = start;
+        pointEndBin[point] = end;
+        pointBinPosition[point] = frequency < sampleRate / 2.0 ? (float) (frequency / binWidth) : -1.0f;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void SpectrumAnalyzer::push (const SampleType* const* channelData, int numChannels, int numSamples, bool isOutput) noexcept
+{
+    if (! isOutput)
+    {
+        isWriting = numDisplays.load (std::memory_order_relaxed) > 0 && fftSize > 0 && numChannels > 0;
+
+        // Whatever doesn't fit is dropped rather than waited for
+        if (isWriting)
+            fifo.prepareToWrite (numSamples, writeStart1, writeSize1, writeStart2, writeSize2);
+    }
+
+    if (! isWriting)
+        return;
+
+    auto* destination = isOutput ? fifoOutput.get() : fifoInput.get();
+    auto gain = 1.0f / (float) numChannels;
+    int regions[2][3] = { { writeStart1, writeSize1, 0 }, { writeStart2, writeSize2, writeSize1 } };
+
+    for (auto& region : regions)
+    {
+        auto* mono = destination + region[0];
+        auto size = region[1];
+        auto offset = region[2];
+
+        if (size <= 0)
+            continue;
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::copyWithMultiply (mono, channelData[0] + offset, gain, size);
+
+            for (int channel = 1; channel < numChannels; channel++)
+                juce::FloatVectorOperations::addWithMultiply (mono, channelData[channel] + offset, gain, size);
+        }
+        else
+        {
+            for (int i = 0; i < size; i++)
+            {
+                SampleType sum = 0;
+
+                for (int channel = 0; channel < numChannels; channel++)
+                    sum += channelData[channel][offset + i];
+
+                mono[i] = (float) sum * gain;
+            }
+        }
+    }
+
+    if (isOutput)
+    {
+        fifo.finishedWrite (writeSize1 + writeSize2);
+        isWriting = false;
+    }
+}
+
+void SpectrumAnalyzer::pushInput (const float* const* channelData, int numChannels, int numSamples) noexcept
+{
+    push (channelData, numChannels, numSamples, false);
+}
+
+void SpectrumAnalyzer::pushInput (const double* const* channelData, int numChannels, int numSamples) noexcept
+{
+    push (channelData, numChannels, numSamples, false);
+}
+
+void SpectrumAnalyzer::pushOutput (const float* const* channelData, int numChannels, int numSamples) noexcept
+{
+    push (channelData, numChannels, numSamples, true);
+}
+
+void SpectrumAnalyzer::pushOutput (const double* const* channelData, int numChannels, int numSamples) noexcept
+{
+    push (channelData, numChannels, numSamples, true);
+}
+
+//==============================================================================
+void SpectrumAnalyzer::addDisplay()
+{
+    if (numDisplays++ == 0)
+        analysisThread->add (*this);
+}
+
+void SpectrumAnalyzer::removeDisplay()
+{
+    if (--numDisplays == 0)
+        analysisThread->remove (*this);
+}
+
+void SpectrumAnalyzer::analyse()
+{
+    if (fft == nullptr)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (auto [start, size] : { std::make_pair (start1, size1), std::make_pair (start2, size2) })
+    {
+        while (size > 0)
+        {
+            auto length = juce::jmin (size, fftSize - historyPosition, hopSize - samplesSinceFrame);
+
+            std::copy (fifoInput + start, fifoInput + start + length, inputHistory + historyPosition);
+            std::copy (fifoOutput + start, fifoOutput + start + length, outputHistory + historyPosition);
+
+            start += length;
+            size -= length;
+            historyPosition = (historyPosition + length) % fftSize;
+            samplesSinceFrame += length;
+
+            if (samplesSinceFrame == hopSize)
+            {
+                analyseFrame();
+                samplesSinceFrame = 0;
+            }
+        }
+    }
+
+    fifo.finishedRead (size1 + size2);
+}
+
+void SpectrumAnalyzer::analyseFrame() noexcept
+{
+    for (auto [history, points] : { std::make_pair (inputHistory.get(), frame.input),
+                                    std::make_pair (outputHistory.get(), frame.output) })
+    {
+        // Oldest sample first, windowed, with the upper half the FFT works in cleared
+        std::copy (history + historyPosition, history + fftSize, fftBuffer.get());
+        std::copy (history, history + historyPosition, fftBuffer + (fftSize - historyPosition));
+        juce::FloatVectorOperations::multiply (fftBuffer, window, fftSize);
+        juce::FloatVectorOperations::clear (fftBuffer + fftSize, fftSize);
+
+        fft->performFrequencyOnlyForwardTransform (fftBuffer);
+        updatePoints (fftBuffer, points);
+    }
+
+    frames.publish (frame);
+}
+
+void SpectrumAnalyzer::updatePoints (const float* magnitudes, float* points) noexcept
+{
+    float levels[numPoints];
+
+    for (int point = 0; point < numPoints; point++)
+    {
+        auto start = pointStartBin[point];
+        auto end = pointEndBin[point];
+        auto position = pointBinPosition[point];
+        float magnitude;
+
+        if (position < 0.0f)
+        {
+            magnitude = 0.0f;
+        }
+        else if (end > start)
+        {
+            magnitude = juce::FloatVectorOperations::findMaximum (magnitudes + start, end - start);
+        }
+        else
+        {
+            auto bin = (int) position;
+            auto fraction = position - (float) bin;
+            magnitude = magnitudes[bin] + fraction * (magnitudes[bin + 1] - magnitudes[bin]);
+        }
+
+        levels[point] = magnitude > 0.0f ? 20.0f * std::log10 (magnitude) : minDecibels;
+    }
+
+    // Fall at the decay rate, jump up to anything louder, and stop at the floor
+    juce::FloatVectorOperations::add (points, -decayPerFrame, numPoints);
+    juce::FloatVectorOperations::max (points, points, levels, numPoints);
+    juce::FloatVectorOperations::max (points, points, minDecibels, numPoints);
+}
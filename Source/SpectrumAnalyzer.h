@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+    The spectrum of the input and the output, for the editor to draw. The audio
+    thread mixes each block down to mono and writes it into a FIFO, or drops it
+    if the FIFO is full; it never waits, and when no editor is open it does
+    nothing but read one atomic. Windowing, FFTs and smoothing run on a
+    background thread shared by every instance in the process, which hands the
+    finished frames to the message thread through a SnapshotSlot.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SnapshotSlot.h"
+
+class SpectrumAnalyzer;
+
+/**
+    The one thread that analyses every instance's spectrum, so 50 open editors
+    cost one thread rather than 50. It wakes up every 10 ms while any display
+    is attached, and sleeps otherwise.
+*/
+class SpectrumAnalysisThread  : private juce::Thread
+{
+public:
+    SpectrumAnalysisThread();
+    ~SpectrumAnalysisThread() override;
+
+    void add (SpectrumAnalyzer& analyzer);
+    void remove (SpectrumAnalyzer& analyzer);
+
+    /** Held while analysing. Take it to change an analyzer's buffers under the thread's feet. */
+    juce::CriticalSection& getLock() noexcept               { return lock; }
+
+private:
+    void run() override;
+
+    juce::CriticalSection lock;
+    juce::Array<SpectrumAnalyzer*> analyzers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalysisThread)
+};
+
+//==============================================================================
+class SpectrumAnalyzer
+{
+public:
+    /** Points per spectrum, log-spaced from 20 Hz to 20 kHz. */
+    static constexpr int numPoints = 256;
+    static constexpr float minDecibels = -120.0f;
+
+    /** One smoothed spectrum of each signal, in dB relative to a full-scale sine. */
+    struct Frame
+    {
+        float input[numPoints];
+        float output[numPoints];
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer();
+
+    /** Sizes the FFT for the sample rate and allocates everything. Not real-time safe. */
+    void prepare (double sampleRate);
+
+    static double getPointFrequency (int point) noexcept;
+
+    //==============================================================================
+    /**
+        Audio thread: call with the block before it's filtered, then with the
+        same block afterwards. Both are skipped while no display is attached.
+    */
+    void pushInput (const float* const* channelData, int numChannels, int numSamples) noexcept;
+    void pushInput (const double* const* channelData, int numChannels, int numSamples) noexcept;
+    void pushOutput (const float* const* channelData, int numChannels, int numSamples) noexcept;
+    void pushOutput (const double* const* channelData, int numChannels, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Message thread: a display registers while it's showing, which starts the analysis. */
+    void addDisplay();
+    void removeDisplay();
+
+    /** True while a display is registered, and the pushes are doing anything. */
+    bool hasDisplay() const noexcept                        { return numDisplays.load (std::memory_order_relaxed) > 0; }
+
+    /** The newest frame, or nullptr if there hasn't been a new one since the last call. Only one display can pull. */
+    const Frame* pullFrame() noexcept                       { return frames.pull(); }
+
+    /** Analysis thread: turns everything the FIFO holds into frames. */
+    void analyse();
+
+private:
+    template <typename SampleType>
+    void push (const SampleType* const* channelData, int numChannels, int numSamples, bool isOutput) noexcept;
+
+    void analyseFrame() noexcept;
+    void updatePoints (const float* magnitudes, float* points) noexcept;
+
+    // Written by the audio thread, read by the analysis thread. Input and output share one write position
+    juce::AbstractFifo fifo { 1 };
+    juce::HeapBlock<float> fifoInput, fifoOutput;
+    int writeStart1 = 0, writeSize1 = 0, writeStart2 = 0, writeSize2 = 0;
+    bool isWriting = false;
+
+    std::atomic<int> numDisplays { 0 };
+
+    // The analysis thread's own: the last fftSize samples of each signal, and the smoothed points
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int fftSize = 0;
+    int hopSize = 0;
+    juce::HeapBlock<float> inputHistory, outputHistory, window, fftBuffer;
+    int historyPosition = 0;
+    int samplesSinceFrame = 0;
+    float decayPerFrame = 0.0f;
+
+    // Each point is the loudest bin between its neighbours, or interpolated between bins below a few hundred Hz
+    juce::HeapBlock<int> pointStartBin, pointEndBin;
+    juce::HeapBlock<float> pointBinPosition;
+
+    Frame frame;
+    SnapshotSlot<Frame> frames;
+
+    juce::SharedResourcePointer<SpectrumAnalysisThread> analysisThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+
+//==============================================================================
+SpectrumDisplay::SpectrumDisplay (SpectrumAnalyzer& analyzerToShow)
+    : analyzer (analyzerToShow)
+{
+    std::fill (frame.input, frame.input + SpectrumAnalyzer::numPoints, SpectrumAnalyzer::minDecibels);
+    std::fill (frame.output, frame.output + SpectrumAnalyzer::numPoints, SpectrumAnalyzer::minDecibels);
+
+    setOpaque (true);
+    analyzer.addDisplay();
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+    analyzer.removeDisplay();
+}
+
+float SpectrumDisplay::getX (double frequency) const noexcept
+{
+    return (float) (getWidth() * std::log (frequency / 20.0) / std::log (1000.0));
+}
+
+float SpectrumDisplay::getY (float decibels) const noexcept
+{
+    return juce::jmap (juce::jlimit (bottomDecibels, topDecibels, decibels), topDecibels, bottomDecibels, 0.0f, (float) getHeight());
+}
+
+//==============================================================================
+void SpectrumDisplay::updateFrame()
+{
+    if (auto* newFrame = analyzer.pullFrame())
+    {
+        frame = *newFrame;
+        updatePaths();
+        repaint();
+    }
+}
+
+void SpectrumDisplay::updatePaths()
+{
+    inputPath.clear();
+    outputPath.clear();
+
+    auto bottom = (float) getHeight();
+
+    // The input is filled down to the bottom edge, the output is a line over it
+    inputPath.startNewSubPath (0.0f, bottom);
+
+    for (int point = 0; point < SpectrumAnalyzer::numPoints; point++)
+    {
+        auto x = getX (SpectrumAnalyzer::getPointFrequency (point));
+        inputPath.lineTo (x, getY (frame.input[point]));
+
+        if (point == 0)
+            outputPath.startNewSubPath (x, getY (frame.output[point]));
+        else
+            outputPath.lineTo (x, getY (frame.output[point]));
+    }
+
+    inputPath.lineTo ((float) getWidth(), bottom);
+    inputPath.closeSubPath();
+}
+
+void SpectrumDisplay::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black);
+
+    // Decades and every 12 dB
+    g.setColour (juce::Colours::white.withAlpha (0.15f));
+
+    for (auto frequency : { 100.0, 1000.0, 10000.0 })
+        g.drawVerticalLine (juce::roundToInt (getX (frequency)), 0.0f, (float) getHeight());
+
+    for (auto decibels = 0.0f; decibels > bottomDecibels; decibels -= 12.0f)
+        g.drawHorizontalLine (juce::roundToInt (getY (decibels)), 0.0f, (float) getWidth());
+
+    g.setColour (juce::Colours::white.withAlpha (0.25f));
+    g.fillPath (inputPath);
+
+    g.setColour (juce::Colours::hotpink);
+    g.strokePath (outputPath, juce::PathStrokeType (1.5f));
+}
+
+void SpectrumDisplay::resized()
+{
+    updatePaths();
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.h
+
+    Draws the analyzer's input and output spectra. It checks for a new frame
+    once per display refresh and only rebuilds its paths and repaints when one
+    has arrived, so the message thread's cost per editor is bounded by the
+    frame rate of the analysis, about 47 per second, whatever the host's
+    block size.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyzer.h"
+
+class SpectrumDisplay  : public juce::Component
+{
+public:
+    explicit SpectrumDisplay (SpectrumAnalyzer& analyzerToShow);
+    ~SpectrumDisplay() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void updateFrame();
+    void updatePaths();
+
+    float getX (double frequency) const noexcept;
+    float getY (float decibels) const noexcept;
+
+    SpectrumAnalyzer& analyzer;
+    SpectrumAnalyzer::Frame frame;
+    juce::Path inputPath, outputPath;
+
+    juce::VBlankAttachment vBlankAttachment { this, [this] { updateFrame(); } };
+
+    static constexpr float topDecibels = 6.0f;
+    static constexpr float bottomDecibels = -90.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumDisplay)
+};
@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Benchmarks for the EQ's real-time path. Results are written as JSON, and
+    can be checked against a saved baseline to catch regressions.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ProcessorBenchmarks.h"
+#include "../../../Source/FilterDesign.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: Benchmarks [options]" << std::endl
+              << std::endl
+              << "  --output <file>        write the JSON results here instead of to stdout" << std::endl
+              << "  --compare <file>       compare with a baseline written by --output" << std::endl
+              << "  --threshold <percent>  how much slower than the baseline counts as a regression, 10 by default" << std::endl
+              << "  --bands <count>        bands switched on, 4 by default" << std::endl
+              << "  --quick                fewer block sizes and shorter runs, for a rough check" << std::endl;
+}
+
+static juce::var toJSON (const juce::Array<BenchmarkResult>& results)
+{
+    juce::Array<juce::var> entries;
+
+    for (auto& result : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("name", result.name);
+
+        if (result.wasSkipped())
+        {
+            entry->setProperty ("skipped", result.skipReason);
+        }
+        else
+        {
+            entry->setProperty ("value", result.value);
+            entry->setProperty ("unit", result.unit);
+        }
+
+        entries.add (juce::var (entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+    root->setProperty ("results", entries);
+
+    return juce::var (root);
+}
+
+/** Prints every case that got slower than the threshold allows, and returns how many did. */
+static int compareWithBaseline (const juce::Array<BenchmarkResult>& results, const juce::var& baseline, double threshold)
+{
+    std::map<juce::String, double> baselineValues;
+
+    if (auto* entries = baseline["results"].getArray())
+        for (auto& entry : *entries)
+            if (entry.hasProperty ("value"))
+                baselineValues[entry["name"].toString()] = (double) entry["value"];
+
+    int numRegressions = 0;
+
+    for (auto& result : results)
+    {
+        auto found = baselineValues.find (result.name);
+
+        if (result.wasSkipped() || found == baselineValues.end() || found->second <= 0)
+            continue;
+
+        auto change = result.value / found->second - 1.0;
+        auto isRegression = change > threshold;
+
+        if (isRegression)
+            ++numRegressions;
+
+        std::cerr << (isRegression ? "REGRESSION " : "           ")
+                  << result.name.paddedRight (' ', 40) << juce::String (found->second, 2).paddedLeft (' ', 10) << " -> "
+                  << juce::String (result.value, 2).paddedLeft (' ', 10) << " " << result.unit
+                  << " (" << (change >= 0 ? "+" : "") << juce::String (change * 100.0, 1) << "%)" << std::endl;
+    }
+
+    return numRegressions;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    BenchmarkOptions options;
+
+    if (args.containsOption ("--bands"))
+        options.numBands = juce::jlimit (1, FilterDesign::maxBands, args.removeValueForOption ("--bands").getIntValue());
+
+    if (args.containsOption ("--quick"))
+    {
+        options.blockSizes = { 16, 128, 1024, 8192 };
+        options.secondsPerRun = 0.01;
+        options.numRuns = 3;
+    }
+
+    auto threshold = 0.1;
+
+    if (args.containsOption ("--threshold"))
+        threshold = args.removeValueForOption ("--threshold").getDoubleValue() / 100.0;
+
+    juce::var baseline;
+
+    if (args.containsOption ("--compare"))
+    {
+        auto baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--compare"));
+        baseline = juce::JSON::parse (baselineFile);
+
+        if (! baseline.isObject())
+        {
+            std::cerr << "can't read a baseline from " << baselineFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    //==============================================================================
+    auto printResult = [] (const BenchmarkResult& result)
+    {
+        if (result.wasSkipped())
+            std::cerr << result.name.paddedRight (' ', 40) << "skipped: " << result.skipReason << std::endl;
+        else
+            std::cerr << result.name.paddedRight (' ', 40) << juce::String (result.value, 2).paddedLeft (' ', 10) << " " << result.unit << std::endl;
+    };
+
+    auto results = runProcessBlockBenchmarks (options, printResult);
+    results.addArray (runInterleavedBenchmarks (options, printResult));
+    results.addArray (runUpdateCoefficientsBenchmarks (options, printResult));
+
+    auto json = juce::JSON::toString (toJSON (results));
+
+    if (args.containsOption ("--output"))
+    {
+        auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output"));
+
+        if (! outputFile.replaceWithText (json))
+        {
+            std::cerr << "can't write " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    if (baseline.isObject())
+    {
+        std::cerr << std::endl << "Compared with the baseline:" << std::endl;
+        auto numRegressions = compareWithBaseline (results, baseline, threshold);
+
+        if (numRegressions > 0)
+        {
+            std::cerr << numRegressions << " regressions" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
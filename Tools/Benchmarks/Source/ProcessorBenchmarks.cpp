@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmarks.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ProcessorBenchmarks.h"
+#include "../../Shared/ProcessorSetup.h"
+
+using namespace ProcessorSetup;
+
+namespace
+{
+    /**
+        Calls the function in batches of at least a millisecond, so reading the clock
+        doesn't show up in the result, and returns the median time per unit.
+    */
+    double timeRuns (const BenchmarkOptions& options, double unitsPerCall, const std::function<void()>& call)
+    {
+        auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+
+        int batchSize = 1;
+
+        for (;;)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < batchSize; i++)
+                call();
+
+            if ((double) (juce::Time::getHighResolutionTicks() - start) / ticksPerSecond >= 0.001 || batchSize >= (1 << 20))
+                break;
+
+            batchSize *= 2;
+        }
+
+        std::vector<double> runs;
+
+        for (int run = 0; run < options.numRuns; run++)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            auto end = start + (juce::int64) (options.secondsPerRun * ticksPerSecond);
+            juce::int64 numCalls = 0;
+            juce::int64 now;
+
+            do
+            {
+                for (int i = 0; i < batchSize; i++)
+                    call();
+
+                numCalls += batchSize;
+                now = juce::Time::getHighResolutionTicks();
+            }
+            while (now < end);
+
+            runs.push_back ((double) (now - start) / ticksPerSecond * 1.0e9 / ((double) numCalls * unitsPerCall));
+        }
+
+        std::sort (runs.begin(), runs.end());
+        return runs[runs.size() / 2];
+    }
+
+    enum class Input
+    {
+        staticParameters,
+        automated,
+        nearSilent,
+        dynamic,
+        oversampled2x,
+        oversampled4x,
+        lowFrequencies,
+        ringDown
+    };
+
+    BenchmarkResult measureProcessBlock (const BenchmarkOptions& options, Input input, int numChannels, int blockSize)
+    {
+        static const char* inputNames[] = { "static", "automated", "silent", "dynamic", "2x", "4x", "low", "ring-down" };
+
+        BenchmarkResult result;
+        result.name = "processBlock/" + juce::String (inputNames[(int) input]) + "/" + juce::String (numChannels) + "ch/" + juce::String (blockSize);
+        result.unit = "ns/sample";
+
+        Project4_TemplateAudioProcessor processor;
+
+        if (! setNumChannels (processor, numChannels))
+        {
+            result.skipReason = "buses don't support " + juce::String (numChannels) + " channels";
+            return result;
+        }
+
+        // Bands from 20 to 200 Hz, which run as state-variable filters
+        if (input == Input::lowFrequencies)
+            setUpBands (processor, options.numBands, 20.0, 200.0);
+        else
+            setUpBands (processor, options.numBands);
+
+        // The same bands with their gain following the input, from a threshold the noise is always over
+        if (input == Input::dynamic)
+        {
+            for (int band = 0; band < options.numBands; band++)
+            {
+                processor.getBandParameter (band, BandField::dynamic)->setValueNotifyingHost (1.0f);
+                setText (processor.getBandParameter (band, BandField::threshold), "-40");
+            }
+        }
+
+        if (input == Input::oversampled2x || input == Input::oversampled4x)
+            setText (findParameter (processor, "Oversampling"), input == Input::oversampled2x ? "2x" : "4x");
+
+        processor.setRateAndBufferSizeDetails (options.sampleRate, blockSize);
+        processor.prepareToPlay (options.sampleRate, blockSize);
+
+        // Noise, or noise far below the silence threshold, which the processor skips without filtering
+        juce::AudioBuffer<float> source (numChannels, blockSize), buffer (numChannels, blockSize);
+        juce::Random random (1);
+        auto level = input == Input::nearSilent ? 1.0e-37f : 0.5f;
+
+        for (int channel = 0; channel < numChannels; channel++)
+            for (int i = 0; i < blockSize; i++)
+                source.setSample (channel, i, level * (random.nextFloat() * 2.0f - 1.0f));
+
+        juce::MidiBuffer midi;
+        auto* automatedParameter = processor.getBandParameter (0, BandField::frequency);
+        int blockIndex = 0;
+
+        // A burst of noise every half second, and silence in between for the tails to ring down through to the skip
+        auto ringDownBlocks = juce::jmax (2, juce::roundToInt (0.5 * options.sampleRate / blockSize));
+
+        result.value = timeRuns (options, (double) (numChannels * blockSize), [&]
+        {
+            // Sweep band 1 around its setting, moving every block
+            if (input == Input::automated)
+                automatedParameter->setValueNotifyingHost (0.05f + 0.04f * std::sin (0.05f * (float) blockIndex++));
+
+            if (input == Input::ringDown && blockIndex++ % ringDownBlocks != 0)
+            {
+                buffer.clear();
+            }
+            else
+            {
+                for (int channel = 0; channel < numChannels; channel++)
+                    buffer.copyFrom (channel, 0, source, channel, 0, blockSize);
+            }
+
+            processor.processBlock (buffer, midi);
+        });
+
+        processor.releaseResources();
+        return result;
+    }
+
+    //==============================================================================
+    BenchmarkResult measureInterleaved (const BenchmarkOptions& options, InterleavedAudio::Format format, bool isFused,
+                                        int numChannels, int blockSize)
+    {
+        static const char* formatNames[] = { "float", "int16", "int24" };
+
+        BenchmarkResult result;
+        result.name = "interleaved/" + juce::String (formatNames[(int) format]) + (isFused ? "/fused/" : "/converted/")
+                    + juce::String (numChannels) + "ch/" + juce::String (blockSize);
+        result.unit = "ns/sample";
+
+        Project4_TemplateAudioProcessor processor;
+
+        if (! setNumChannels (processor, numChannels))
+        {
+            result.skipReason = "buses don't support " + juce::String (numChannels) + " channels";
+            return result;
+        }
+
+        setUpBands (processor, options.numBands);
+        processor.setRateAndBufferSizeDetails (options.sampleRate, blockSize);
+        processor.prepareToPlay (options.sampleRate, blockSize);
+
+        auto numBytes = (size_t) (numChannels * blockSize * InterleavedAudio::getBytesPerSample (format));
+        juce::HeapBlock<char> source (numBytes), frames (numBytes);
+        juce::AudioBuffer<float> noise (numChannels, blockSize), buffer (numChannels, blockSize);
+        juce::Random random (1);
+
+        for (int channel = 0; channel < numChannels; channel++)
+            for (int i = 0; i < blockSize; i++)
+                noise.setSample (channel, i, 0.5f * (random.nextFloat() * 2.0f - 1.0f));
+
+        InterleavedAudio::interleave (noise.getArrayOfReadPointers(), source, format, numChannels, 0, blockSize);
+
+        juce::MidiBuffer midi;
+
+        result.value = timeRuns (options, (double) (numChannels * blockSize), [&]
+        {
+            std::memcpy (frames, source, numBytes);
+
+            if (isFused)
+            {
+                processor.processInterleaved (frames, format, numChannels, blockSize);
+            }
+            else
+            {
+                // What a host without processInterleaved does around processBlock
+                InterleavedAudio::deinterleave (frames, format, numChannels, 0, blockSize, buffer.getArrayOfWritePointers());
+                processor.processBlock (buffer, midi);
+                InterleavedAudio::interleave (buffer.getArrayOfReadPointers(), frames, format, numChannels, 0, blockSize);
+            }
+        });
+
+        processor.releaseResources();
+        return result;
+    }
+}
+
+//==============================================================================
+juce::Array<BenchmarkResult> runProcessBlockBenchmarks (const BenchmarkOptions& options,
+                                                        std::function<void (const BenchmarkResult&)> onResult)
+{
+    juce::Array<BenchmarkResult> results;
+
+    for (auto input : { Input::staticParameters, Input::automated, Input::nearSilent, Input::dynamic,
+                        Input::oversampled2x, Input::oversampled4x, Input::lowFrequencies, Input::ringDown })
+    {
+        for (auto numChannels : options.channelCounts)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                results.add (measureProcessBlock (options, input, numChannels, blockSize));
+                onResult (results.getReference (results.size() - 1));
+            }
+        }
+    }
+
+    return results;
+}
+
+juce::Array<BenchmarkResult> runInterleavedBenchmarks (const BenchmarkOptions& options,
+                                                       std::function<void (const BenchmarkResult&)> onResult)
+{
+    juce::Array<BenchmarkResult> results;
+
+    for (auto format : { InterleavedAudio::Format::float32, InterleavedAudio::Format::int16, InterleavedAudio::Format::int24 })
+    {
+        for (auto numChannels : options.channelCounts)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                for (auto isFused : { true, false })
+                {
+                    results.add (measureInterleaved (options, format, isFused, numChannels, blockSize));
+                    onResult (results.getReference (results.size() - 1));
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+juce::Array<BenchmarkResult> runUpdateCoefficientsBenchmarks (const BenchmarkOptions& options,
+                                                              std::function<void (const BenchmarkResult&)> onResult)
+{
+    juce::Array<BenchmarkResult> results;
+
+    Project4_TemplateAudioProcessor processor;
+    setUpBands (processor, options.numBands);
+    processor.setRateAndBufferSizeDetails (options.sampleRate, 512);
+    processor.prepareToPlay (options.sampleRate, 512);
+
+    // Nudging every enabled band's gain forces all of them to be redesigned
+    juce::Array<juce::AudioProcessorParameter*> gains;
+
+    for (int band = 0; band < options.numBands; band++)
+        gains.add (processor.getBandParameter (band, BandField::gain));
+
+    int callIndex = 0;
+
+    BenchmarkResult changed;
+    changed.name = "updateCoefficients/changed";
+    changed.unit = "ns/call";
+    changed.value = timeRuns (options, 1.0, [&]
+    {
+        auto value = (callIndex++ & 1) != 0 ? 0.55f : 0.45f;
+
+        for (auto* gain : gains)
+            gain->setValueNotifyingHost (value);
+
+        processor.updateCoefficients();
+    });
+
+    results.add (changed);
+    onResult (changed);
+
+    BenchmarkResult unchanged;
+    unchanged.name = "updateCoefficients/unchanged";
+    unchanged.unit = "ns/call";
+    unchanged.value = timeRuns (options, 1.0, [&] { processor.updateCoefficients(); });
+
+    results.add (unchanged);
+    onResult (unchanged);
+
+    processor.releaseResources();
+    return results;
+}
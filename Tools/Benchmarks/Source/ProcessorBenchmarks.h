@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmarks.h
+
+    Timings of the EQ processor's real-time path. Each case runs for a fixed
+    time, a few times over, and keeps the median, so one result can be
+    compared with another run on the same machine.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/InterleavedAudio.h"
+
+struct BenchmarkResult
+{
+    /** Identifies the case when comparing with a baseline, e.g. "processBlock/static/2ch/512". */
+    juce::String name;
+
+    /** Nanoseconds per sample of one channel, or per call. */
+    double value = 0;
+    juce::String unit;
+
+    /** Set when the processor can't run the case, e.g. a channel count its buses don't allow. */
+    juce::String skipReason;
+
+    bool wasSkipped() const noexcept        { return skipReason.isNotEmpty(); }
+};
+
+struct BenchmarkOptions
+{
+    /** Bands switched on, cycling through the band types. */
+    int numBands = 4;
+
+    double sampleRate = 48000;
+    double secondsPerRun = 0.05;
+    int numRuns = 5;
+
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    juce::Array<int> channelCounts { 1, 2, 8, 64 };
+};
+
+/**
+    processBlock with the parameters held still, with a parameter automated every
+    block, with input below the silence threshold, which is skipped, with the
+    same bands in dynamic mode, for the cost of modulating them every sample
+    against the static cascade, with the static bands oversampled 2x and 4x,
+    with every band between 20 and 200 Hz, where the sections run as
+    state-variable filters, and with a burst of noise every half second and
+    silence between, so the filter runs on its tails as they ring down, until
+    they pass the silence threshold and the skip takes over. The input is
+    copied into the buffer before every block, and that copy is part of the
+    time.
+*/
+juce::Array<BenchmarkResult> runProcessBlockBenchmarks (const BenchmarkOptions& options,
+                                                        std::function<void (const BenchmarkResult&)> onResult);
+
+/**
+    processInterleaved on interleaved float, 16-bit and 24-bit frames with the
+    parameters held still, against converting the same frames to a float
+    buffer, calling processBlock and converting back. Both copy the input into
+    the frames before every block, and that copy is part of the time.
+*/
+juce::Array<BenchmarkResult> runInterleavedBenchmarks (const BenchmarkOptions& options,
+                                                       std::function<void (const BenchmarkResult&)> onResult);
+
+/** updateCoefficients after every band changed, and with nothing changed. */
+juce::Array<BenchmarkResult> runUpdateCoefficientsBenchmarks (const BenchmarkOptions& options,
+                                                              std::function<void (const BenchmarkResult&)> onResult);
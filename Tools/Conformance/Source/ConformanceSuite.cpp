@@ -0,0 +1,684 @@
+/*
+  ==============================================================================
+
+    ConformanceSuite.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ConformanceSuite.h"
+#include "ReferenceModel.h"
+#include "../../Shared/ProcessorSetup.h"
+
+juce::String ConformanceCase::getName() const
+{
+    return juce::String (juce::roundToInt (sampleRate)) + " Hz: " + juce::String (frequency) + " Hz, "
+         + (gain > 0 ? "+" : "") + juce::String (gain) + " dB, Q " + juce::String (q);
+}
+
+using namespace ProcessorSetup;
+
+namespace
+{
+    double toDecibels (double gain)
+    {
+        return juce::Decibels::gainToDecibels (gain, -400.0);
+    }
+
+    //==============================================================================
+    /**
+        The band a path runs for a case, repeated numBands times. The copies after
+        the first alternate between cut and boost, so four bands of +24 dB don't
+        drive the output 96 dB over the input.
+    */
+    FilterDesign::BandSettings getBandSettings (const ConformanceCase& testCase, int band)
+    {
+        FilterDesign::BandSettings settings;
+        settings.enabled = true;
+        settings.type = FilterDesign::BandType::peak;
+        settings.frequency = testCase.frequency;
+        settings.gain = band % 2 == 0 ? testCase.gain : -testCase.gain;
+        settings.q = testCase.q;
+
+        return settings;
+    }
+
+    constexpr int maxBands = 4;
+
+    /** One way of running the band: filters a buffer in place, starting from silence every time. */
+    class Path
+    {
+    public:
+        Path (const juce::String& pathName, int channels, int bands)
+            : name (pathName), numChannels (channels), numBands (bands)
+        {
+        }
+
+        virtual ~Path() = default;
+
+        /** Designs the case, or returns why it can't be run. */
+        virtual juce::String prepare (const ConformanceCase& testCase) = 0;
+
+        /** True if the case just prepared has any section in the state-variable topology. */
+        virtual bool isStateVariable() const = 0;
+
+        virtual void process (juce::AudioBuffer<double>& buffer, int numSamples) = 0;
+
+        const juce::String name;
+        const int numChannels, numBands;
+
+        /** Set when the path can't run at all on this machine. */
+        juce::String skipReason;
+    };
+
+    /** Copies numSamples samples of each channel from source, from start on, into the start of destination. */
+    template <typename Destination, typename Source>
+    void copyBlock (juce::AudioBuffer<Destination>& destination, const juce::AudioBuffer<Source>& source, int start,
+                    int numSamples, int destinationStart = 0)
+    {
+        for (int channel = 0; channel < destination.getNumChannels(); channel++)
+            for (int i = 0; i < numSamples; i++)
+                destination.setSample (channel, destinationStart + i, (Destination) source.getSample (channel, start + i));
+    }
+
+    //==============================================================================
+    /** EQCascade on its own, run the way processBlock runs it once the coefficients have settled. */
+    class CascadePath : public Path
+    {
+    public:
+        enum class Input
+        {
+            float32,
+            doubleState,
+            float64,
+            interleaved
+        };
+
+        CascadePath (const juce::String& pathName, Input inputToUse, BiquadEngine::Kernel kernel, BiquadEngine::Mode mode,
+                     int channels, int bands, double noiseTargetToUse, int blockSizeToUse)
+            : Path (pathName, channels, bands),
+              input (inputToUse), noiseTarget (noiseTargetToUse), blockSize (blockSizeToUse),
+              floatBlock (channels, blockSizeToUse),
+              doubleChannels ((size_t) channels),
+              frames ((size_t) (channels * blockSizeToUse))
+        {
+            if (BiquadEngine::isKernelAvailable (kernel))
+                cascade.setKernel (kernel);
+            else
+                skipReason = juce::String (BiquadEngine::getKernelName (kernel)) + " isn't available on this CPU";
+
+            cascade.prepare (channels);
+            cascade.setMode (mode);
+            cascade.setUseDoubleState (input == Input::doubleState);
+        }
+
+        juce::String prepare (const ConformanceCase& testCase) override
+        {
+            coefficients.clear();
+
+            for (int band = 0; band < numBands; band++)
+            {
+                BiquadCoefficients sections[FilterDesign::maxSectionsPerBand];
+                auto numSections = FilterDesign::designBand (getBandSettings (testCase, band), testCase.sampleRate,
+                                                             sections, noiseTarget);
+
+                for (int i = 0; i < numSections; i++)
+                    coefficients.add (band * FilterDesign::maxSectionsPerBand + i, sections[i]);
+            }
+
+            return {};
+        }
+
+        bool isStateVariable() const override
+        {
+            for (int i = 0; i < coefficients.numSections; i++)
+                if (coefficients.sections[i].topology == BiquadCoefficients::Topology::stateVariable)
+                    return true;
+
+            return false;
+        }
+
+        void process (juce::AudioBuffer<double>& buffer, int numSamples) override
+        {
+            cascade.reset();
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                auto numBlockSamples = juce::jmin (blockSize, numSamples - start);
+
+                if (input == Input::float64)
+                {
+                    for (int channel = 0; channel < numChannels; channel++)
+                        doubleChannels[(size_t) channel] = buffer.getWritePointer (channel, start);
+
+                    cascade.process (doubleChannels.data(), numChannels, numBlockSamples, coefficients);
+                    continue;
+                }
+
+                copyBlock (floatBlock, buffer, start, numBlockSamples);
+
+                if (input == Input::interleaved)
+                {
+                    InterleavedAudio::interleave (floatBlock.getArrayOfReadPointers(), frames.data(),
+                                                  InterleavedAudio::Format::float32, numChannels, 0, numBlockSamples);
+                    cascade.processInterleaved (frames.data(), InterleavedAudio::Format::float32, numChannels,
+                                                numBlockSamples, coefficients);
+                    InterleavedAudio::deinterleave (frames.data(), InterleavedAudio::Format::float32, numChannels, 0,
+                                                    numBlockSamples, floatBlock.getArrayOfWritePointers());
+                }
+                else
+                {
+                    cascade.process (floatBlock.getArrayOfWritePointers(), numChannels, numBlockSamples, coefficients);
+                }
+
+                copyBlock (buffer, floatBlock, 0, numBlockSamples, start);
+            }
+        }
+
+    private:
+        Input input;
+        double noiseTarget;
+        int blockSize;
+
+        EQCascade cascade;
+        CascadeCoefficients coefficients;
+
+        juce::AudioBuffer<float> floatBlock;
+        std::vector<double*> doubleChannels;
+        std::vector<float> frames;
+    };
+
+    //==============================================================================
+    /**
+        The whole processor, with band 1 set through its parameters: the design
+        in updateCoefficients as well as the filtering.
+    */
+    class ProcessorPath : public Path
+    {
+    public:
+        enum class Input
+        {
+            float32,
+            timeParallel,
+            doubleState,
+            float64,
+            interleaved
+        };
+
+        ProcessorPath (const juce::String& pathName, Input inputToUse, int channels, int blockSizeToUse)
+            : Path (pathName, channels, 1),
+              input (inputToUse), blockSize (blockSizeToUse),
+              floatBlock (channels, blockSizeToUse), doubleBlock (channels, blockSizeToUse),
+              frames ((size_t) (channels * blockSizeToUse))
+        {
+            Project4_TemplateAudioProcessor processorToCheck;
+
+            if (! setNumChannels (processorToCheck, channels))
+                skipReason = "buses don't support " + juce::String (channels) + " channels";
+        }
+
+        juce::String prepare (const ConformanceCase& testCase) override
+        {
+            // A new processor for each case, so nothing is left over from the last one
+            processor = std::make_unique<Project4_TemplateAudioProcessor>();
+            setNumChannels (*processor, numChannels);
+
+            processor->getBandParameter (0, BandField::enabled)->setValueNotifyingHost (1.0f);
+            setText (processor->getBandParameter (0, BandField::type), "Peak");
+
+            auto frequency = setValue (processor->getBandParameter (0, BandField::frequency), (float) testCase.frequency);
+            auto gain = setValue (processor->getBandParameter (0, BandField::gain), testCase.gain);
+            auto q = setValue (processor->getBandParameter (0, BandField::q), testCase.q);
+
+            // The reference is designed from the case, so the parameters have to hold it as it is
+            auto isClose = [] (float a, float b)    { return std::abs (a - b) <= 1.0e-5f * juce::jmax (1.0f, std::abs (b)); };
+
+            if (! isClose (frequency, (float) testCase.frequency) || ! isClose (gain, testCase.gain) || ! isClose (q, testCase.q))
+                return "the parameters hold " + juce::String (frequency) + " Hz, " + juce::String (gain) + " dB, Q " + juce::String (q);
+
+            processor->setProcessingMode (input == Input::timeParallel ? BiquadEngine::Mode::timeParallel
+                                                                       : BiquadEngine::Mode::channelParallel);
+            processor->setDoubleStateForFloatAudio (input == Input::doubleState);
+            processor->setProcessingPrecision (input == Input::float64 ? juce::AudioProcessor::doublePrecision
+                                                                       : juce::AudioProcessor::singlePrecision);
+
+            processor->setRateAndBufferSizeDetails (testCase.sampleRate, blockSize);
+            processor->prepareToPlay (testCase.sampleRate, blockSize);
+
+            return {};
+        }
+
+        bool isStateVariable() const override
+        {
+            auto& coefficients = processor->getCoefficients();
+
+            for (int i = 0; i < coefficients.numSections; i++)
+                if (coefficients.sections[i].topology == BiquadCoefficients::Topology::stateVariable)
+                    return true;
+
+            return false;
+        }
+
+        void process (juce::AudioBuffer<double>& buffer, int numSamples) override
+        {
+            processor->resetDelays();
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                auto numBlockSamples = juce::jmin (blockSize, numSamples - start);
+
+                if (input == Input::float64)
+                {
+                    doubleBlock.setSize (numChannels, numBlockSamples, false, false, true);
+                    copyBlock (doubleBlock, buffer, start, numBlockSamples);
+                    processor->processBlock (doubleBlock, midi);
+                    copyBlock (buffer, doubleBlock, 0, numBlockSamples, start);
+                    continue;
+                }
+
+                floatBlock.setSize (numChannels, numBlockSamples, false, false, true);
+                copyBlock (floatBlock, buffer, start, numBlockSamples);
+
+                if (input == Input::interleaved)
+                {
+                    InterleavedAudio::interleave (floatBlock.getArrayOfReadPointers(), frames.data(),
+                                                  InterleavedAudio::Format::float32, numChannels, 0, numBlockSamples);
+                    processor->processInterleaved (frames.data(), InterleavedAudio::Format::float32, numChannels,
+                                                   numBlockSamples);
+                    InterleavedAudio::deinterleave (frames.data(), InterleavedAudio::Format::float32, numChannels, 0,
+                                                    numBlockSamples, floatBlock.getArrayOfWritePointers());
+                }
+                else
+                {
+                    processor->processBlock (floatBlock, midi);
+                }
+
+                copyBlock (buffer, floatBlock, 0, numBlockSamples, start);
+            }
+        }
+
+    private:
+        Input input;
+        int blockSize;
+
+        std::unique_ptr<Project4_TemplateAudioProcessor> processor;
+
+        juce::AudioBuffer<float> floatBlock;
+        juce::AudioBuffer<double> doubleBlock;
+        std::vector<float> frames;
+        juce::MidiBuffer midi;
+    };
+
+    //==============================================================================
+    juce::OwnedArray<Path> createPaths (const ConformanceOptions& options)
+    {
+        juce::OwnedArray<Path> paths;
+
+        auto addPath = [&] (Path* path)
+        {
+            if (options.pathFilter.isEmpty() || path->name.contains (options.pathFilter))
+                paths.add (path);
+            else
+                delete path;
+        };
+
+        // The designer's choice of topology, and every section as a state-variable filter
+        struct Topology
+        {
+            const char* suffix;
+            double noiseTarget;
+        };
+
+        const Topology topologies[] = { { "", FilterDesign::defaultNoiseTarget }, { "/state-variable", 0.0 } };
+
+        for (auto kernel : { BiquadEngine::Kernel::scalar, BiquadEngine::Kernel::sse2, BiquadEngine::Kernel::avx2, BiquadEngine::Kernel::neon })
+        {
+            juce::String kernelName (BiquadEngine::getKernelName (kernel));
+
+            for (auto numChannels : options.channelCounts)
+            {
+                /*
+                    With 4 or more channels both modes run the channel-parallel kernels. Under 4,
+                    four bands run band-parallel in channel-parallel mode and a section at a time
+                    on the time-parallel kernels in time-parallel mode, so the two are separate paths.
+                */
+                for (auto mode : { BiquadEngine::Mode::channelParallel, BiquadEngine::Mode::timeParallel })
+                {
+                    if (mode == BiquadEngine::Mode::timeParallel && numChannels >= 4)
+                        continue;
+
+                    auto modeName = mode == BiquadEngine::Mode::timeParallel ? "/time/" : "/channel/";
+
+                    for (auto numBands : { 1, maxBands })
+                        for (auto& topology : topologies)
+                            addPath (new CascadePath ("cascade/" + kernelName + modeName + juce::String (numChannels) + "ch"
+                                                        + (numBands > 1 ? "/" + juce::String (numBands) + " bands" : juce::String())
+                                                        + topology.suffix,
+                                                      CascadePath::Input::float32, kernel, mode, numChannels, numBands,
+                                                      topology.noiseTarget, options.blockSize));
+                }
+
+                for (auto numBands : { 1, maxBands })
+                    addPath (new CascadePath ("interleaved/" + kernelName + "/" + juce::String (numChannels) + "ch"
+                                                + (numBands > 1 ? "/" + juce::String (numBands) + " bands" : juce::String()),
+                                              CascadePath::Input::interleaved, kernel, BiquadEngine::Mode::channelParallel,
+                                              numChannels, numBands, FilterDesign::defaultNoiseTarget, options.blockSize));
+            }
+        }
+
+        // Double state runs the scalar double kernel whatever the kernel and mode
+        for (auto numChannels : options.channelCounts)
+        {
+            for (auto numBands : { 1, maxBands })
+            {
+                auto bandsName = numBands > 1 ? "/" + juce::String (numBands) + " bands" : juce::String();
+
+                for (auto& topology : topologies)
+                {
+                    addPath (new CascadePath ("cascade/double state/" + juce::String (numChannels) + "ch" + bandsName + topology.suffix,
+                                              CascadePath::Input::doubleState, BiquadEngine::getBestAvailableKernel(),
+                                              BiquadEngine::Mode::channelParallel, numChannels, numBands,
+                                              topology.noiseTarget, options.blockSize));
+
+                    addPath (new CascadePath ("cascade/double/" + juce::String (numChannels) + "ch" + bandsName + topology.suffix,
+                                              CascadePath::Input::float64, BiquadEngine::getBestAvailableKernel(),
+                                              BiquadEngine::Mode::channelParallel, numChannels, numBands,
+                                              topology.noiseTarget, options.blockSize));
+                }
+            }
+        }
+
+        static const char* processorInputNames[] = { "processBlock/float", "processBlock/time", "processBlock/double state",
+                                                     "processBlock/double", "processInterleaved/float" };
+
+        for (auto numChannels : options.channelCounts)
+            for (int input = 0; input <= (int) ProcessorPath::Input::interleaved; input++)
+                addPath (new ProcessorPath (juce::String (processorInputNames[input]) + "/" + juce::String (numChannels) + "ch",
+                                            (ProcessorPath::Input) input, numChannels, options.blockSize));
+
+        return paths;
+    }
+
+    juce::Array<ConformanceCase> createCases (const ConformanceOptions& options)
+    {
+        juce::Array<ConformanceCase> cases;
+
+        for (auto sampleRate : options.sampleRates)
+            for (auto frequency : options.frequencies)
+                if (frequency <= 0.45 * sampleRate)
+                    for (auto gain : options.gains)
+                        for (auto q : options.qs)
+                            cases.add ({ sampleRate, frequency, gain, q });
+
+        return cases;
+    }
+
+    //==============================================================================
+    /** What every path is measured against for one case, with one band and with maxBands. */
+    struct Reference
+    {
+        struct Run
+        {
+            juce::AudioBuffer<double> noiseOutput;
+            std::vector<double> impulseResponse;
+            std::vector<double> magnitudes;
+
+            /** e^-jwn at each response frequency w, for the first impulseResponse.size() samples. */
+            std::vector<std::vector<std::complex<double>>> phasors;
+        };
+
+        Run runs[2];
+
+        const Run& get (int numBands) const noexcept    { return runs[numBands > 1 ? 1 : 0]; }
+    };
+
+    /** The magnitude response of the first length samples of impulseResponse. */
+    void getMagnitudes (const double* impulseResponse, const std::vector<std::vector<std::complex<double>>>& phasors,
+                        std::vector<double>& magnitudes)
+    {
+        magnitudes.resize (phasors.size());
+
+        for (size_t k = 0; k < phasors.size(); k++)
+        {
+            std::complex<double> sum;
+
+            for (size_t n = 0; n < phasors[k].size(); n++)
+                sum += impulseResponse[n] * phasors[k][n];
+
+            magnitudes[k] = std::abs (sum);
+        }
+    }
+
+    void createReference (const ConformanceOptions& options, const ConformanceCase& testCase,
+                          const juce::AudioBuffer<double>& noise, Reference& reference)
+    {
+        for (int run = 0; run < 2; run++)
+        {
+            auto& output = reference.runs[run];
+            auto numBands = run == 0 ? 1 : maxBands;
+
+            std::vector<ReferenceModel::Biquad> sections;
+            ReferenceModel::Real poleRadius = 0;
+
+            for (int band = 0; band < numBands; band++)
+            {
+                // With Q raised where designBand raises it, so both run the same peak
+                auto settings = getBandSettings (testCase, band);
+                auto q = juce::jmax ((double) settings.q, FilterDesign::getLowestPeakQ (settings.frequency, testCase.sampleRate));
+                sections.push_back (ReferenceModel::designPeak (testCase.sampleRate, settings.frequency, settings.gain, q));
+                poleRadius = std::max (poleRadius, sections.back().getPoleRadius());
+            }
+
+            std::vector<ReferenceModel::Real> samples ((size_t) juce::jmax (options.numNoiseSamples, options.maxImpulseLength));
+            output.noiseOutput.setSize (noise.getNumChannels(), options.numNoiseSamples);
+
+            for (int channel = 0; channel < noise.getNumChannels(); channel++)
+            {
+                for (int i = 0; i < options.numNoiseSamples; i++)
+                    samples[(size_t) i] = noise.getSample (channel, i);
+
+                ReferenceModel::process (sections, samples.data(), options.numNoiseSamples);
+
+                for (int i = 0; i < options.numNoiseSamples; i++)
+                    output.noiseOutput.setSample (channel, i, (double) samples[(size_t) i]);
+            }
+
+            // Until the ringing has decayed by 140 dB, within the limit
+            auto length = poleRadius < 1 ? (double) std::ceil (std::log ((ReferenceModel::Real) 1.0e-7) / std::log (poleRadius)) : 1.0e9;
+            auto impulseLength = (int) juce::jlimit (64.0, (double) options.maxImpulseLength, length);
+
+            std::fill (samples.begin(), samples.end(), (ReferenceModel::Real) 0);
+            samples[0] = 1;
+            ReferenceModel::process (sections, samples.data(), impulseLength);
+            output.impulseResponse.assign (samples.begin(), samples.begin() + impulseLength);
+
+            output.phasors.resize ((size_t) options.numResponsePoints);
+
+            for (int k = 0; k < options.numResponsePoints; k++)
+            {
+                auto frequency = 10.0 * std::pow (0.49 * testCase.sampleRate / 10.0, k / (double) juce::jmax (1, options.numResponsePoints - 1));
+                auto w = juce::MathConstants<double>::twoPi * frequency / testCase.sampleRate;
+
+                auto& phasors = output.phasors[(size_t) k];
+                phasors.resize ((size_t) impulseLength);
+
+                for (int n = 0; n < impulseLength; n++)
+                    phasors[(size_t) n] = std::polar (1.0, -w * n);
+            }
+
+            getMagnitudes (output.impulseResponse.data(), output.phasors, output.magnitudes);
+        }
+    }
+
+    //==============================================================================
+    void checkTolerance (ConformanceResult& result, const ConformanceCase& testCase, const char* measurement,
+                         double value, double tolerance, const char* unit)
+    {
+        if (value > tolerance)
+            result.failures.add (testCase.getName() + ": " + measurement + " " + juce::String (value, 1) + " " + unit
+                                 + " over " + juce::String (tolerance, 1));
+    }
+
+    void measure (Path& path, const ConformanceOptions& options, const ConformanceCase& testCase,
+                  const juce::AudioBuffer<double>& noise, const Reference& reference, ConformanceResult& result,
+                  juce::AudioBuffer<double>& buffer)
+    {
+        auto& expected = reference.get (path.numBands);
+        auto impulseLength = (int) expected.impulseResponse.size();
+
+        // Noise, different on every channel
+        buffer.setSize (path.numChannels, options.numNoiseSamples, false, false, true);
+
+        for (int channel = 0; channel < path.numChannels; channel++)
+            buffer.copyFrom (channel, 0, noise, channel, 0, options.numNoiseSamples);
+
+        path.process (buffer, options.numNoiseSamples);
+
+        double maxError = 0, sumOfSquares = 0;
+
+        for (int channel = 0; channel < path.numChannels; channel++)
+        {
+            for (int i = 0; i < options.numNoiseSamples; i++)
+            {
+                auto error = buffer.getSample (channel, i) - expected.noiseOutput.getSample (channel, i);
+                maxError = juce::jmax (maxError, std::abs (error));
+                sumOfSquares += error * error;
+            }
+        }
+
+        auto residual = std::sqrt (sumOfSquares / (double) (path.numChannels * options.numNoiseSamples));
+
+        // An impulse on every channel, and the response of the channel furthest from the reference
+        buffer.setSize (path.numChannels, impulseLength, false, false, true);
+        buffer.clear();
+
+        for (int channel = 0; channel < path.numChannels; channel++)
+            buffer.setSample (channel, 0, 1.0);
+
+        path.process (buffer, impulseLength);
+
+        double impulseDeviation = 0;
+        int worstChannel = 0;
+
+        for (int channel = 0; channel < path.numChannels; channel++)
+        {
+            for (int n = 0; n < impulseLength; n++)
+            {
+                auto deviation = std::abs (buffer.getSample (channel, n) - expected.impulseResponse[(size_t) n]);
+
+                if (deviation > impulseDeviation)
+                {
+                    impulseDeviation = deviation;
+                    worstChannel = channel;
+                }
+            }
+        }
+
+        std::vector<double> magnitudes;
+        getMagnitudes (buffer.getReadPointer (worstChannel), expected.phasors, magnitudes);
+
+        double responseDeviation = 0;
+
+        for (size_t k = 0; k < magnitudes.size(); k++)
+            responseDeviation = juce::jmax (responseDeviation, std::abs (toDecibels (magnitudes[k]) - toDecibels (expected.magnitudes[k])));
+
+        //==============================================================================
+        auto keepWorst = [&] (double value, double& worst, ConformanceCase& worstCase)
+        {
+            if (value > worst || result.numCases == 0)
+            {
+                worst = value;
+                worstCase = testCase;
+            }
+        };
+
+        keepWorst (toDecibels (maxError), result.maxError, result.maxErrorCase);
+        keepWorst (toDecibels (residual), result.residual, result.residualCase);
+        keepWorst (toDecibels (impulseDeviation), result.impulseDeviation, result.impulseDeviationCase);
+        keepWorst (responseDeviation, result.responseDeviation, result.responseDeviationCase);
+
+        auto& tolerances = options.tolerances;
+        checkTolerance (result, testCase, "max error", toDecibels (maxError), tolerances.maxError, "dBFS");
+        checkTolerance (result, testCase, "residual", toDecibels (residual), tolerances.residual, "dBFS");
+        checkTolerance (result, testCase, "impulse deviation", toDecibels (impulseDeviation), tolerances.impulseDeviation, "dBFS");
+
+        if (responseDeviation > tolerances.responseDeviation)
+            result.failures.add (testCase.getName() + ": response deviation " + juce::String (responseDeviation, 4)
+                                 + " dB over " + juce::String (tolerances.responseDeviation, 4));
+
+        result.numCases++;
+    }
+}
+
+//==============================================================================
+ConformanceReport runConformanceSuite (const ConformanceOptions& options,
+                                       std::function<void (const ConformanceResult&)> onResult)
+{
+    auto paths = createPaths (options);
+
+    ConformanceReport report;
+    auto& results = report.results;
+    auto cases = createCases (options);
+
+    for (auto* path : paths)
+    {
+        ConformanceResult result;
+        result.name = path->name;
+        result.skipReason = path->skipReason;
+        results.add (result);
+    }
+
+    // Noise at -6 dBFS, in float so every path starts from the same samples as the reference
+    auto maxChannels = 1;
+
+    for (auto numChannels : options.channelCounts)
+        maxChannels = juce::jmax (maxChannels, numChannels);
+
+    juce::AudioBuffer<double> noise (maxChannels, options.numNoiseSamples);
+
+    for (int channel = 0; channel < maxChannels; channel++)
+    {
+        juce::Random random (channel + 1);
+
+        for (int i = 0; i < options.numNoiseSamples; i++)
+            noise.setSample (channel, i, (double) (0.5f * (random.nextFloat() * 2.0f - 1.0f)));
+    }
+
+    // Every path runs a case before the next one, so only one case's reference is kept
+    Reference reference;
+    juce::AudioBuffer<double> buffer;
+
+    for (auto& testCase : cases)
+    {
+        createReference (options, testCase, noise, reference);
+
+        for (int i = 0; i < paths.size(); i++)
+        {
+            auto* path = paths[i];
+            auto& result = results.getReference (i);
+
+            if (result.wasSkipped())
+                continue;
+
+            auto reason = path->prepare (testCase);
+
+            if (reason.isNotEmpty())
+            {
+                result.failures.add (testCase.getName() + ": " + reason);
+                continue;
+            }
+
+            if (path->isStateVariable())
+                result.numStateVariableCases++;
+
+            measure (*path, options, testCase, noise, reference, result, buffer);
+        }
+    }
+
+    for (auto& result : results)
+        onResult (result);
+
+    return report;
+}
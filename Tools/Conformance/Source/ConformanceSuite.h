@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    ConformanceSuite.h
+
+    Checks every way the EQ can run a peaking band against ReferenceModel:
+    the cascade on each kernel in channel- and time-parallel mode, with the
+    designer's choice of topology and with every section a state-variable
+    filter, on its own and as four bands (band-parallel under 4 channels in
+    channel-parallel mode, a section at a time in time-parallel); double state and
+    double audio; interleaved float frames; and processBlock and
+    processInterleaved through the processor, in minimum phase at the
+    session rate.
+
+    Each case is one band setting at one sample rate. It is designed the way
+    the path designs it, then run on seeded noise and on an impulse, starting
+    from silence each time, and measured against the reference run on the
+    same input:
+
+        max error           the largest difference on the noise, in dBFS
+        residual            the RMS of that difference, the null test, in dBFS
+        impulse deviation   the largest difference of the impulse responses,
+                            in dBFS
+        response deviation  the largest difference of the magnitude responses,
+                            at log-spaced frequencies from 10 Hz to 0.49 fs,
+                            in dB
+
+    The impulse response is taken until the reference has decayed to -140 dB,
+    or maxImpulseLength samples if it rings for longer, and both magnitude
+    responses are of the impulse responses over that length.
+
+    At low Q near the top of the band, where the bandwidth w0 / Q would pass
+    pi, the design raises Q to FilterDesign::getLowestPeakQ to stay stable. The
+    reference is designed with the same Q, so those cases check the section
+    the plugin runs rather than the one the setting asks for.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    The worst a path may measure on any case before it fails. The float paths
+    measure about -87, -96, -108 dBFS and 0.006 dB over the default sweep,
+    mostly from designing in float, so these leave 6-8 dB for rounding to move
+    around in.
+*/
+struct ConformanceTolerances
+{
+    double maxError = -80.0;            // dBFS
+    double residual = -90.0;            // dBFS
+    double impulseDeviation = -100.0;   // dBFS
+    double responseDeviation = 0.02;    // dB
+};
+
+struct ConformanceCase
+{
+    double sampleRate = 48000;
+    int frequency = 1000;
+    float gain = 0.0f;
+    float q = 1.0f;
+
+    /** e.g. "48000 Hz: 1000 Hz, +6 dB, Q 1" */
+    juce::String getName() const;
+};
+
+/** One path's measurements over the sweep, each the worst of any case, with the case it came from. */
+struct ConformanceResult
+{
+    /** e.g. "cascade/avx2/time/2ch/4 bands" */
+    juce::String name;
+
+    int numCases = 0;
+
+    /** How many of the cases had any section designed as a state-variable filter. */
+    int numStateVariableCases = 0;
+
+    double maxError = -std::numeric_limits<double>::infinity();
+    double residual = -std::numeric_limits<double>::infinity();
+    double impulseDeviation = -std::numeric_limits<double>::infinity();
+    double responseDeviation = 0.0;
+
+    ConformanceCase maxErrorCase, residualCase, impulseDeviationCase, responseDeviationCase;
+
+    /** One line for each case and measurement over its tolerance. */
+    juce::StringArray failures;
+
+    /** Set when the path can't run here, e.g. a kernel the CPU doesn't have. */
+    juce::String skipReason;
+
+    bool wasSkipped() const noexcept        { return skipReason.isNotEmpty(); }
+    bool hasPassed() const noexcept         { return failures.isEmpty(); }
+};
+
+struct ConformanceOptions
+{
+    juce::Array<double> sampleRates { 44100, 48000, 96000, 192000 };
+
+    /** Frequencies above 0.45 times a sample rate are left out at that rate. */
+    juce::Array<int> frequencies { 20, 60, 200, 1000, 5000, 15000, 20000 };
+    juce::Array<float> gains { -24.0f, -6.0f, 6.0f, 24.0f };
+    juce::Array<float> qs { 0.3f, 1.0f, 5.0f, 20.0f };
+
+    /** 3 leaves a channel over from the band-parallel pairs, and 8 fills two SIMD groups. */
+    juce::Array<int> channelCounts { 1, 2, 3, 8 };
+
+    /** Odd, so every kernel's loop over the samples left after its SIMD steps runs. */
+    int blockSize = 441;
+
+    int numNoiseSamples = 8192;
+    int maxImpulseLength = 8192;
+    int numResponsePoints = 32;
+
+    /** Only the paths with this in their name, or all of them when empty. */
+    juce::String pathFilter;
+
+    ConformanceTolerances tolerances;
+};
+
+struct ConformanceReport
+{
+    juce::Array<ConformanceResult> results;
+};
+
+/**
+    Runs every case on every path, one case at a time so only one reference is
+    kept, and calls onResult for each path at the end.
+*/
+ConformanceReport runConformanceSuite (const ConformanceOptions& options,
+                                                    std::function<void (const ConformanceResult&)> onResult);
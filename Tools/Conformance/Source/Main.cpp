@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Checks every processing path of the EQ against a long double reference of
+    the peaking band, over a sweep of frequency, gain, Q and sample rate.
+    Results are written as JSON, and the exit code is non-zero when any path
+    is outside the tolerances.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ConformanceSuite.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: Conformance [options]" << std::endl
+              << std::endl
+              << "  --output <file>        write the JSON results here instead of to stdout" << std::endl
+              << "  --max-error <dBFS>     the largest difference allowed on noise, -80 by default" << std::endl
+              << "  --residual <dBFS>      the RMS difference allowed on noise, -90 by default" << std::endl
+              << "  --impulse <dBFS>       the largest difference allowed in the impulse response, -100 by default" << std::endl
+              << "  --response <dB>        the largest magnitude response difference allowed, 0.02 by default" << std::endl
+              << "  --paths <text>         only run the paths with this in their name, e.g. processBlock or avx2" << std::endl
+              << "  --quick                fewer cases and shorter runs, for a rough check" << std::endl;
+}
+
+static juce::var toJSON (const ConformanceOptions& options, const ConformanceReport& report)
+{
+    juce::Array<juce::var> entries;
+
+    for (auto& result : report.results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("name", result.name);
+
+        if (result.wasSkipped())
+        {
+            entry->setProperty ("skipped", result.skipReason);
+        }
+        else
+        {
+            auto addMeasurement = [entry] (const char* name, double value, const ConformanceCase& worstCase)
+            {
+                auto* measurement = new juce::DynamicObject();
+                measurement->setProperty ("value", value);
+                measurement->setProperty ("case", worstCase.getName());
+                entry->setProperty (name, juce::var (measurement));
+            };
+
+            entry->setProperty ("cases", result.numCases);
+            entry->setProperty ("stateVariableCases", result.numStateVariableCases);
+            addMeasurement ("maxError", result.maxError, result.maxErrorCase);
+            addMeasurement ("residual", result.residual, result.residualCase);
+            addMeasurement ("impulseDeviation", result.impulseDeviation, result.impulseDeviationCase);
+            addMeasurement ("responseDeviation", result.responseDeviation, result.responseDeviationCase);
+            entry->setProperty ("passed", result.hasPassed());
+
+            if (! result.hasPassed())
+                entry->setProperty ("failures", result.failures);
+        }
+
+        entries.add (juce::var (entry));
+    }
+
+    auto* tolerances = new juce::DynamicObject();
+    tolerances->setProperty ("maxError", options.tolerances.maxError);
+    tolerances->setProperty ("residual", options.tolerances.residual);
+    tolerances->setProperty ("impulseDeviation", options.tolerances.impulseDeviation);
+    tolerances->setProperty ("responseDeviation", options.tolerances.responseDeviation);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+    root->setProperty ("tolerances", juce::var (tolerances));
+
+    root->setProperty ("results", entries);
+
+    return juce::var (root);
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    ConformanceOptions options;
+    auto& tolerances = options.tolerances;
+
+    if (args.containsOption ("--max-error"))
+        tolerances.maxError = args.removeValueForOption ("--max-error").getDoubleValue();
+
+    if (args.containsOption ("--residual"))
+        tolerances.residual = args.removeValueForOption ("--residual").getDoubleValue();
+
+    if (args.containsOption ("--impulse"))
+        tolerances.impulseDeviation = args.removeValueForOption ("--impulse").getDoubleValue();
+
+    if (args.containsOption ("--response"))
+        tolerances.responseDeviation = args.removeValueForOption ("--response").getDoubleValue();
+
+    if (args.containsOption ("--paths"))
+        options.pathFilter = args.removeValueForOption ("--paths");
+
+    if (args.containsOption ("--quick"))
+    {
+        options.sampleRates = { 48000, 192000 };
+        options.frequencies = { 20, 1000, 15000 };
+        options.gains = { -24.0f, 24.0f };
+        options.qs = { 1.0f, 20.0f };
+        options.channelCounts = { 1, 2, 8 };
+        options.numNoiseSamples = 4096;
+        options.maxImpulseLength = 4096;
+    }
+
+    //==============================================================================
+    int numFailed = 0;
+
+    auto printResult = [&numFailed] (const ConformanceResult& result)
+    {
+        if (result.wasSkipped())
+        {
+            std::cerr << "         " << result.name.paddedRight (' ', 48) << "skipped: " << result.skipReason << std::endl;
+            return;
+        }
+
+        if (! result.hasPassed())
+            ++numFailed;
+
+        std::cerr << (result.hasPassed() ? "         " : "FAILED   ") << result.name.paddedRight (' ', 48)
+                  << juce::String (result.maxError, 1).paddedLeft (' ', 8)
+                  << juce::String (result.residual, 1).paddedLeft (' ', 8)
+                  << juce::String (result.impulseDeviation, 1).paddedLeft (' ', 8)
+                  << juce::String (result.responseDeviation, 5).paddedLeft (' ', 10) << std::endl;
+
+        // The first few are enough to see where it goes wrong; the JSON has them all
+        for (int i = 0; i < juce::jmin (3, result.failures.size()); i++)
+            std::cerr << "           " << result.failures[i] << std::endl;
+
+        if (result.failures.size() > 3)
+            std::cerr << "           and " << (result.failures.size() - 3) << " more" << std::endl;
+    };
+
+    std::cerr << "         " << juce::String ("path").paddedRight (' ', 48)
+              << juce::String ("error").paddedLeft (' ', 8) << juce::String ("null").paddedLeft (' ', 8)
+              << juce::String ("impulse").paddedLeft (' ', 8) << juce::String ("response").paddedLeft (' ', 10) << std::endl;
+
+    auto report = runConformanceSuite (options, printResult);
+
+    auto json = juce::JSON::toString (toJSON (options, report));
+
+    if (args.containsOption ("--output"))
+    {
+        auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output"));
+
+        if (! outputFile.replaceWithText (json))
+        {
+            std::cerr << "can't write " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    if (numFailed > 0)
+    {
+        std::cerr << numFailed << " paths outside the tolerances" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    ReferenceModel.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ReferenceModel.h"
+
+namespace ReferenceModel
+{
+    Real Biquad::getPoleRadius() const noexcept
+    {
+        // Complex poles have |p|^2 = d2; real ones are the roots of z^2 + d1 z + d2
+        auto discriminant = d1 * d1 - 4 * d2;
+
+        if (discriminant < 0)
+            return std::sqrt (d2);
+
+        auto root = std::sqrt (discriminant);
+        return std::max (std::abs (-d1 + root), std::abs (-d1 - root)) / 2;
+    }
+
+    Biquad designPeak (double sampleRate, double frequency, double gain, double q) noexcept
+    {
+        const Real pi = 3.141592653589793238462643383279502884L;
+
+        // The terms of FilterDesign's designPeak, unrounded
+        auto theta = 2 * pi * (Real) frequency / (Real) sampleRate;
+        auto mu = std::pow ((Real) 10, (Real) gain / 20);
+        auto xi = 4 / (1 + mu);
+        auto t = std::tan (theta / (2 * (Real) q));
+        auto beta = (Real) 0.5 * ((1 - xi * t) / (1 + xi * t));
+        auto gamma = ((Real) 0.5 + beta) * std::cos (theta);
+
+        // y = x + (mu - 1) w, with w the band-pass (a0 - a0 z^-2) / (1 + b1 z^-1 + b2 z^-2)
+        auto a0 = (Real) 0.5 - beta;
+        auto wet = (mu - 1) * a0;
+
+        Biquad section;
+        section.d1 = -2 * gamma;
+        section.d2 = 2 * beta;
+        section.n0 = 1 + wet;
+        section.n1 = section.d1;
+        section.n2 = section.d2 - wet;
+
+        return section;
+    }
+
+    void process (const std::vector<Biquad>& sections, Real* samples, int numSamples) noexcept
+    {
+        for (auto& section : sections)
+        {
+            Real x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+            for (int n = 0; n < numSamples; n++)
+            {
+                auto x = samples[n];
+                auto y = section.n0 * x + section.n1 * x1 + section.n2 * x2 - section.d1 * y1 - section.d2 * y2;
+
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+
+                samples[n] = y;
+            }
+        }
+    }
+}
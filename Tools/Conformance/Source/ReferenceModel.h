@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    ReferenceModel.h
+
+    The peaking band in long double, as the conformance suite's reference:
+    the original single-band design from updateCoefficients(), with every
+    term computed by the library functions instead of FastMath, nothing
+    rounded to float, and the difference equation run in long double.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace ReferenceModel
+{
+    using Real = long double;
+
+    /** H(z) = (n0 + n1 z^-1 + n2 z^-2) / (1 + d1 z^-1 + d2 z^-2) */
+    struct Biquad
+    {
+        Real n0 = 1, n1 = 0, n2 = 0, d1 = 0, d2 = 0;
+
+        /** The largest magnitude of the poles, which sets how long the section rings. */
+        Real getPoleRadius() const noexcept;
+    };
+
+    /** The peak at frequency Hz with gain dB and the given Q, at sampleRate. */
+    Biquad designPeak (double sampleRate, double frequency, double gain, double q) noexcept;
+
+    /** Filters the samples in place through each section in turn, starting from silence. */
+    void process (const std::vector<Biquad>& sections, Real* samples, int numSamples) noexcept;
+}
@@ -0,0 +1,552 @@
+/*
+  ==============================================================================
+
+    EQFitter.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "EQFitter.h"
+
+namespace
+{
+    using BandType = FilterDesign::BandType;
+
+    constexpr float shelfQ = 0.707f;
+    constexpr float lowestPeakQ = 0.3f;
+    constexpr float highestPeakQ = 8.0f;
+
+    /** Points this far below the loudest in the spectrum are noise, or nothing at all, and aren't fitted. */
+    constexpr double floorDecibels = 80.0;
+
+    bool isShelf (const FilterDesign::BandSettings& band) noexcept
+    {
+        return band.type == BandType::lowShelf || band.type == BandType::highShelf;
+    }
+
+    /** log2 of frequency, gain in dB and log2 of Q, or only the first two for a shelf, whose Q stays put. */
+    int getNumParameters (const FilterDesign::BandSettings& band) noexcept
+    {
+        return isShelf (band) ? 2 : 3;
+    }
+
+    void toParameters (const FilterDesign::BandSettings& band, double* parameters) noexcept
+    {
+        parameters[0] = std::log2 ((double) band.frequency);
+        parameters[1] = (double) band.gain;
+
+        if (! isShelf (band))
+            parameters[2] = std::log2 ((double) band.q);
+    }
+
+    /** Solves matrix x = vector in place, by Gaussian elimination with partial pivoting. */
+    bool solveLinearSystem (std::vector<double>& matrix, std::vector<double>& vector, int size)
+    {
+        auto at = [&matrix, size] (int row, int column) -> double& { return matrix[(size_t) (row * size + column)]; };
+
+        for (int column = 0; column < size; column++)
+        {
+            auto pivot = column;
+
+            for (int row = column + 1; row < size; row++)
+                if (std::abs (at (row, column)) > std::abs (at (pivot, column)))
+                    pivot = row;
+
+            if (at (pivot, column) == 0.0)
+                return false;
+
+            if (pivot != column)
+            {
+                for (int i = 0; i < size; i++)
+                    std::swap (at (pivot, i), at (column, i));
+
+                std::swap (vector[(size_t) pivot], vector[(size_t) column]);
+            }
+
+            for (int row = column + 1; row < size; row++)
+            {
+                auto factor = at (row, column) / at (column, column);
+
+                for (int i = column; i < size; i++)
+                    at (row, i) -= factor * at (column, i);
+
+                vector[(size_t) row] -= factor * vector[(size_t) column];
+            }
+        }
+
+        for (int row = size - 1; row >= 0; row--)
+        {
+            auto sum = vector[(size_t) row];
+
+            for (int i = row + 1; i < size; i++)
+                sum -= at (row, i) * vector[(size_t) i];
+
+            vector[(size_t) row] = sum / at (row, row);
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+TargetCurve TargetCurve::pink()
+{
+    return { { { 20.0, 3.0 * std::log2 (1000.0 / 20.0) }, { 20000.0, -3.0 * std::log2 (20000.0 / 1000.0) } } };
+}
+
+TargetCurve TargetCurve::flat()
+{
+    return { { { 1000.0, 0.0 } } };
+}
+
+double TargetCurve::getLevel (double frequency) const
+{
+    if (points.empty())
+        return 0.0;
+
+    if (frequency <= points.front().first)
+        return points.front().second;
+
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        if (frequency < points[i].first)
+        {
+            auto& start = points[i - 1];
+            auto& end = points[i];
+            auto proportion = std::log (frequency / start.first) / std::log (end.first / start.first);
+            return start.second + proportion * (end.second - start.second);
+        }
+    }
+
+    return points.back().second;
+}
+
+juce::String parseTargetFile (const juce::File& file, TargetCurve& target)
+{
+    if (! file.existsAsFile())
+        return "can't find " + file.getFullPathName();
+
+    juce::StringArray lines;
+    file.readLines (lines);
+    target.points.clear();
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        auto line = lines[i].trim();
+
+        if (line.isEmpty() || line.startsWithChar ('#'))
+            continue;
+
+        auto fields = juce::StringArray::fromTokens (line, ",", "\"");
+        fields.trim();
+
+        if (fields.size() != 2 || fields[0].getDoubleValue() <= 0.0)
+            return file.getFileName() + " line " + juce::String (i + 1) + ": expected <Hz>, <dB>";
+
+        target.points.push_back ({ fields[0].getDoubleValue(), fields[1].getDoubleValue() });
+    }
+
+    if (target.points.empty())
+        return file.getFileName() + " has no points";
+
+    std::stable_sort (target.points.begin(), target.points.end(),
+                      [] (const std::pair<double, double>& a, const std::pair<double, double>& b) { return a.first < b.first; });
+    return {};
+}
+
+//==============================================================================
+EQFitter::EQFitter (const FitSettings& fitSettings)
+    : settings (fitSettings),
+      frequencyResponse (std::make_unique<FrequencyResponse>()),
+      allMagnitudes ((size_t) FrequencyResponse::numPoints),
+      allPhases ((size_t) FrequencyResponse::numPoints)
+{
+    settings.numBands = juce::jlimit (1, FilterDesign::maxBands, settings.numBands);
+}
+
+FitResult EQFitter::fit (const LongTermSpectrum& spectrum, const TargetCurve& target)
+{
+    FitResult result;
+
+    if (sampleRate != spectrum.getSampleRate())
+    {
+        sampleRate = spectrum.getSampleRate();
+        table = FilterDesign::FrequencyTable::getFor (sampleRate);
+        frequencyResponse->prepare (sampleRate);
+    }
+
+    //==============================================================================
+    std::vector<double> measured;
+    points.clear();
+
+    for (int point = 0; point < frequencyResponse->getNumValidPoints(); point++)
+    {
+        auto frequency = FrequencyResponse::getPointFrequency (point);
+
+        if (frequency >= settings.lowestFrequency && frequency <= settings.highestFrequency)
+        {
+            points.push_back (point);
+            measured.push_back (spectrum.getLevel (frequency, settings.smoothing));
+        }
+    }
+
+    auto loudest = measured.empty() ? 0.0 : *std::max_element (measured.begin(), measured.end());
+    auto numPoints = points.size();
+    double sumOfWeights = 0.0, meanDeviation = 0.0;
+
+    weights.assign (numPoints, 0.0);
+    deviation.assign (numPoints, 0.0);
+    correction.assign (numPoints, 0.0);
+
+    for (size_t i = 0; i < numPoints; i++)
+    {
+        if (std::isfinite (measured[i]) && measured[i] > loudest - floorDecibels)
+        {
+            weights[i] = 1.0;
+            deviation[i] = target.getLevel (FrequencyResponse::getPointFrequency (points[i])) - measured[i];
+            sumOfWeights += 1.0;
+            meanDeviation += deviation[i];
+        }
+    }
+
+    //==============================================================================
+    auto numBands = settings.numBands;
+    bands.assign ((size_t) numBands, {});
+    responses.assign ((size_t) numBands, std::vector<float> (numPoints, 0.0f));
+
+    for (int band = 0; band < numBands; band++)
+    {
+        auto& settingsOfBand = bands[(size_t) band];
+        settingsOfBand.enabled = true;
+        settingsOfBand.q = 1.0f;
+
+        if (numBands >= 3 && band == 0)
+        {
+            settingsOfBand.type = BandType::lowShelf;
+            settingsOfBand.frequency = 100;
+            settingsOfBand.q = shelfQ;
+        }
+        else if (numBands >= 3 && band == numBands - 1)
+        {
+            settingsOfBand.type = BandType::highShelf;
+            settingsOfBand.frequency = 8000;
+            settingsOfBand.q = shelfQ;
+        }
+
+        limit (settingsOfBand);
+    }
+
+    // A silent file, or one with nothing in the fitted range, gets the bands at 0 dB
+    if (sumOfWeights == 0.0)
+    {
+        result.bands = bands;
+        return result;
+    }
+
+    meanDeviation /= sumOfWeights;
+
+    for (size_t i = 0; i < numPoints; i++)
+    {
+        if (weights[i] > 0.0)
+        {
+            deviation[i] -= meanDeviation;
+            correction[i] = juce::jlimit ((double) -settings.maxGain, (double) settings.maxGain, deviation[i]);
+        }
+    }
+
+    result.errorBefore = std::sqrt (getCost (deviation) / sumOfWeights);
+
+    //==============================================================================
+    std::vector<int> shelves, peaks;
+
+    for (int band = 0; band < numBands; band++)
+        (isShelf (bands[(size_t) band]) ? shelves : peaks).push_back (band);
+
+    if (! shelves.empty())
+        solve (shelves, 20);
+
+    for (auto peak : peaks)
+    {
+        // Where the most is left to correct
+        size_t worst = 0;
+        double worstDifference = 0.0;
+        double differenceThere = 0.0;
+
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            auto difference = correction[i];
+
+            for (auto& response : responses)
+                difference -= (double) response[i];
+
+            if (weights[i] * std::abs (difference) > worstDifference)
+            {
+                worst = i;
+                worstDifference = weights[i] * std::abs (difference);
+                differenceThere = difference;
+            }
+        }
+
+        auto& band = bands[(size_t) peak];
+        band.frequency = juce::roundToInt (FrequencyResponse::getPointFrequency (points[worst]));
+        band.gain = (float) differenceThere;
+        band.q = 1.0f;
+        limit (band);
+        evaluate (band, responses[(size_t) peak].data());
+
+        solve ({ peak }, 20);
+    }
+
+    std::vector<int> allBands;
+
+    for (int band = 0; band < numBands; band++)
+        allBands.push_back (band);
+
+    solve (allBands, 50);
+
+    // To the resolution the values are shown at, so the state reads back as what was fitted
+    for (int band = 0; band < numBands; band++)
+    {
+        auto& settingsOfBand = bands[(size_t) band];
+        settingsOfBand.gain = std::round (settingsOfBand.gain * 10.0f) / 10.0f;
+
+        if (! isShelf (settingsOfBand))
+            settingsOfBand.q = std::round (settingsOfBand.q * 100.0f) / 100.0f;
+
+        limit (settingsOfBand);
+        evaluate (settingsOfBand, responses[(size_t) band].data());
+    }
+
+    result.bands = bands;
+    result.errorAfter = std::sqrt (getCost (deviation) / sumOfWeights);
+    return result;
+}
+
+//==============================================================================
+void EQFitter::limit (FilterDesign::BandSettings& band) const noexcept
+{
+    auto highest = juce::jmin (settings.highestFrequency, 0.45 * sampleRate, (double) FilterDesign::maxFrequency);
+    auto lowest = juce::jmin (settings.lowestFrequency, highest);
+
+    band.frequency = juce::jlimit ((int) std::ceil (lowest), (int) std::floor (highest), band.frequency);
+    band.gain = juce::jlimit (-settings.maxGain, settings.maxGain, band.gain);
+
+    if (isShelf (band))
+    {
+        band.q = shelfQ;
+    }
+    else
+    {
+        // The lowest Q on the 0.01 steps the result is rounded to that the design doesn't raise
+        auto stableQ = (float) (std::ceil (FilterDesign::getLowestPeakQ (band.frequency, sampleRate) * 100.0) / 100.0);
+        band.q = juce::jlimit (juce::jmax (lowestPeakQ, stableQ), highestPeakQ, band.q);
+    }
+}
+
+void EQFitter::evaluate (const FilterDesign::BandSettings& band, float* magnitude)
+{
+    BiquadCoefficients sections[FilterDesign::maxSectionsPerBand];
+    auto numSections = FilterDesign::designBand (band, *table, sections);
+
+    cascade.clear();
+
+    for (int i = 0; i < numSections; i++)
+        cascade.add (i, sections[i]);
+
+    frequencyResponse->evaluate (cascade, allMagnitudes.data(), allPhases.data());
+
+    for (size_t i = 0; i < points.size(); i++)
+        magnitude[i] = allMagnitudes[(size_t) points[i]];
+}
+
+double EQFitter::getCost (const std::vector<double>& curve) const noexcept
+{
+    double cost = 0.0;
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        auto difference = curve[i];
+
+        for (auto& response : responses)
+            difference -= (double) response[i];
+
+        cost += weights[i] * difference * difference;
+    }
+
+    return cost;
+}
+
+void EQFitter::solve (const std::vector<int>& bandsToFit, int maxIterations)
+{
+    auto numPoints = points.size();
+
+    std::vector<int> offsets;
+    int numParameters = 0;
+
+    for (auto band : bandsToFit)
+    {
+        offsets.push_back (numParameters);
+        numParameters += getNumParameters (bands[(size_t) band]);
+    }
+
+    auto size = (size_t) numParameters;
+    std::vector<double> parameters (size), trial (size);
+    std::vector<double> jacobian (size * numPoints), normal (size * size), gradient (size);
+    std::vector<float> shifted (numPoints);
+
+    for (size_t k = 0; k < bandsToFit.size(); k++)
+        toParameters (bands[(size_t) bandsToFit[k]], parameters.data() + offsets[k]);
+
+    auto savedBands = bands;
+    auto savedResponses = responses;
+    auto cost = getCost (correction);
+    auto damping = 1.0e-3;
+
+    for (int iteration = 0; iteration < maxIterations; iteration++)
+    {
+        /*
+            Forward differences, designing only the band that moves. Frequency is a
+            whole number of Hz, so its step is never less than 1.5 Hz, and a step
+            that the limits take back is tried the other way.
+        */
+        for (size_t k = 0; k < bandsToFit.size(); k++)
+        {
+            auto bandIndex = (size_t) bandsToFit[k];
+            auto& band = bands[bandIndex];
+            auto& response = responses[bandIndex];
+
+            for (int j = 0; j < getNumParameters (band); j++)
+            {
+                double step = j == 1 ? 0.1 : 1.0 / 48.0;
+
+                if (j == 0)
+                    step = juce::jmax (step, std::log2 ((band.frequency + 1.5) / band.frequency));
+
+                auto column = (size_t) (offsets[k] + j);
+                double moved[3], realised[3];
+                auto actualStep = 0.0;
+
+                for (auto direction : { 1.0, -1.0 })
+                {
+                    toParameters (band, moved);
+                    moved[j] += direction * step;
+
+                    auto shiftedBand = band;
+                    shiftedBand.frequency = juce::roundToInt (std::exp2 (moved[0]));
+                    shiftedBand.gain = (float) moved[1];
+
+                    if (! isShelf (band))
+                        shiftedBand.q = (float) std::exp2 (moved[2]);
+
+                    limit (shiftedBand);
+                    toParameters (shiftedBand, realised);
+                    toParameters (band, moved);
+                    actualStep = realised[j] - moved[j];
+
+                    if (std::abs (actualStep) > 1.0e-9)
+                    {
+                        evaluate (shiftedBand, shifted.data());
+                        break;
+                    }
+                }
+
+                for (size_t i = 0; i < numPoints; i++)
+                    jacobian[column * numPoints + i] = std::abs (actualStep) > 1.0e-9
+                                                           ? ((double) shifted[i] - (double) response[i]) / actualStep
+                                                           : 0.0;
+            }
+        }
+
+        // J^T W J and J^T W r
+        std::vector<double> residual (numPoints);
+
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            residual[i] = correction[i];
+
+            for (auto& response : responses)
+                residual[i] -= (double) response[i];
+        }
+
+        for (size_t row = 0; row < size; row++)
+        {
+            auto* rowDerivatives = jacobian.data() + row * numPoints;
+            double sum = 0.0;
+
+            for (size_t i = 0; i < numPoints; i++)
+                sum += weights[i] * rowDerivatives[i] * residual[i];
+
+            gradient[row] = sum;
+
+            for (size_t column = row; column < size; column++)
+            {
+                auto* columnDerivatives = jacobian.data() + column * numPoints;
+                double product = 0.0;
+
+                for (size_t i = 0; i < numPoints; i++)
+                    product += weights[i] * rowDerivatives[i] * columnDerivatives[i];
+
+                normal[row * size + column] = normal[column * size + row] = product;
+            }
+        }
+
+        //==============================================================================
+        auto improved = false;
+
+        while (damping < 1.0e6)
+        {
+            auto dampedNormal = normal;
+            auto step = gradient;
+
+            for (size_t i = 0; i < size; i++)
+                dampedNormal[i * size + i] += damping * normal[i * size + i] + 1.0e-9;
+
+            if (! solveLinearSystem (dampedNormal, step, numParameters))
+            {
+                damping *= 4.0;
+                continue;
+            }
+
+            savedBands = bands;
+            savedResponses = responses;
+
+            for (size_t k = 0; k < bandsToFit.size(); k++)
+            {
+                auto bandIndex = (size_t) bandsToFit[k];
+                auto& band = bands[bandIndex];
+                auto* bandParameters = parameters.data() + offsets[k];
+                auto* bandStep = step.data() + offsets[k];
+
+                band.frequency = juce::roundToInt (std::exp2 (bandParameters[0] + bandStep[0]));
+                band.gain = (float) (bandParameters[1] + bandStep[1]);
+
+                if (! isShelf (band))
+                    band.q = (float) std::exp2 (bandParameters[2] + bandStep[2]);
+
+                limit (band);
+                evaluate (band, responses[bandIndex].data());
+                toParameters (band, trial.data() + offsets[k]);
+            }
+
+            auto trialCost = getCost (correction);
+
+            if (trialCost < cost)
+            {
+                improved = cost - trialCost > 1.0e-6 * cost;
+                cost = trialCost;
+                parameters = trial;
+                damping = juce::jmax (damping / 3.0, 1.0e-7);
+                break;
+            }
+
+            bands = savedBands;
+            responses = savedResponses;
+            damping *= 4.0;
+        }
+
+        if (! improved)
+            break;
+    }
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    EQFitter.h
+
+    Fits the EQ's bands so that a file's long-term spectrum follows a target
+    curve. The bands are designed and evaluated with the plugin's own
+    FilterDesign and FrequencyResponse, so the fitted curve is the one the
+    processor will run, frequency rounded to whole Hz included.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LongTermSpectrum.h"
+#include "../../../Source/FrequencyResponse.h"
+
+//==============================================================================
+/**
+    The spectrum to aim for, as points of <Hz>, <dB> with straight lines between
+    them on a log frequency axis, held flat past the first and last. Only its
+    shape matters: the fit takes out the average difference in level first.
+*/
+struct TargetCurve
+{
+    /** -3 dB/oct, the long-term average of a lot of mixed music. */
+    static TargetCurve pink();
+    static TargetCurve flat();
+
+    double getLevel (double frequency) const;
+
+    /** Hz and dB, in order of frequency. */
+    std::vector<std::pair<double, double>> points;
+};
+
+/**
+    Reads a target file, one <Hz>, <dB> per line, or returns an error message.
+    Blank lines and lines starting with '#' are ignored.
+*/
+juce::String parseTargetFile (const juce::File& file, TargetCurve& target);
+
+//==============================================================================
+struct FitSettings
+{
+    /**
+        With 3 or more, the first band is a low shelf and the last a high shelf,
+        and those between are peaks.
+    */
+    int numBands = 6;
+
+    /** The range that is fitted, and that the bands are kept in. */
+    double lowestFrequency = 30.0;
+    double highestFrequency = 16000.0;
+
+    /** The largest boost or cut of any band, and of the correction it aims for. */
+    float maxGain = 12.0f;
+
+    /** The width, in octaves, the spectrum is averaged over at each frequency. */
+    double smoothing = 1.0 / 3.0;
+};
+
+struct FitResult
+{
+    std::vector<FilterDesign::BandSettings> bands;
+
+    /** The RMS distance from the target's shape in dB, over the fitted range, without and with the bands. */
+    double errorBefore = 0;
+    double errorAfter = 0;
+};
+
+//==============================================================================
+/**
+    Each band's frequency, gain and Q (on a log scale for frequency and Q) are
+    found by Levenberg-Marquardt on the squared difference, in dB, between the
+    bands' summed response and the correction the spectrum needs, at the
+    FrequencyResponse points inside the fitted range. The shelves are fitted
+    first, then each peak goes where the largest difference is left and is
+    fitted on its own, and last every band is fitted together. Six bands take
+    tens of milliseconds, well under the time to analyse a minute of audio.
+
+    Peaks are held to a Q where their bandwidth stays below Nyquist, as the
+    peak design is unstable past it.
+*/
+class EQFitter
+{
+public:
+    explicit EQFitter (const FitSettings& settings);
+
+    FitResult fit (const LongTermSpectrum& spectrum, const TargetCurve& target);
+
+private:
+    /** Keeps a band's settings within the range, the gain limit and the stable Q. */
+    void limit (FilterDesign::BandSettings& band) const noexcept;
+
+    /** Designs a band and writes its magnitude at the fitted points. */
+    void evaluate (const FilterDesign::BandSettings& band, float* magnitude);
+
+    /** The weighted sum of squares of curve minus the responses of every band. */
+    double getCost (const std::vector<double>& curve) const noexcept;
+
+    void solve (const std::vector<int>& bandsToFit, int maxIterations);
+
+    FitSettings settings;
+    double sampleRate = 0;
+    std::shared_ptr<const FilterDesign::FrequencyTable> table;
+
+    std::unique_ptr<FrequencyResponse> frequencyResponse;
+    CascadeCoefficients cascade;
+    std::vector<float> allMagnitudes, allPhases;
+
+    /** The FrequencyResponse points inside the fitted range, and what's known at each. */
+    std::vector<int> points;
+    std::vector<double> weights, deviation, correction;
+
+    std::vector<FilterDesign::BandSettings> bands;
+    std::vector<std::vector<float>> responses;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQFitter)
+};
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    LongTermSpectrum.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "LongTermSpectrum.h"
+
+LongTermSpectrum::LongTermSpectrum()
+    : fft (fftOrder),
+      window ((size_t) fftSize),
+      fftData ((size_t) (2 * fftSize)),
+      power ((size_t) (fftSize / 2 + 1))
+{
+    // Periodic Hann, which sums to a constant at 50% overlap
+    for (int i = 0; i < fftSize; i++)
+        window[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
+}
+
+void LongTermSpectrum::analyse (juce::AudioFormatReader& reader)
+{
+    sampleRate = reader.sampleRate;
+    numChannels = juce::jmax (1, (int) reader.numChannels);
+    numFrames = 0;
+    std::fill (power.begin(), power.end(), 0.0);
+
+    // The frame slides along a hop at a time: the second half moves down and the next hop is read in after it
+    juce::AudioBuffer<float> frame (numChannels, fftSize);
+    frame.clear();
+
+    auto length = reader.lengthInSamples;
+    reader.read (&frame, hopSize, hopSize, 0, true, true);
+
+    for (juce::int64 position = hopSize; position - hopSize < length; position += hopSize)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+            frame.copyFrom (channel, 0, frame, channel, hopSize, hopSize);
+
+        // Past the end, the reader fills with silence
+        reader.read (&frame, hopSize, hopSize, position, true, true);
+        addFrame (frame);
+    }
+}
+
+void LongTermSpectrum::addFrame (const juce::AudioBuffer<float>& frame)
+{
+    double sumOfSquares = 0.0;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto* samples = frame.getReadPointer (channel);
+
+        for (int i = 0; i < fftSize; i++)
+            sumOfSquares += (double) samples[i] * (double) samples[i];
+    }
+
+    auto rms = std::sqrt (sumOfSquares / (double) (numChannels * fftSize));
+
+    if (juce::Decibels::gainToDecibels (rms, -400.0) < (double) gateDecibels)
+        return;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        juce::FloatVectorOperations::multiply (fftData.data(), frame.getReadPointer (channel), window.data(), fftSize);
+        fft.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+        for (size_t bin = 0; bin < power.size(); bin++)
+            power[bin] += (double) fftData[bin] * (double) fftData[bin];
+    }
+
+    numFrames++;
+}
+
+double LongTermSpectrum::getLevel (double frequency, double octaves) const
+{
+    if (numFrames == 0)
+        return -std::numeric_limits<double>::infinity();
+
+    auto binWidth = sampleRate / fftSize;
+    auto lastBin = (int) power.size() - 1;
+    auto low = juce::jlimit (0, lastBin, (int) std::ceil (frequency * std::pow (2.0, -octaves / 2.0) / binWidth));
+    auto high = juce::jlimit (0, lastBin, (int) std::floor (frequency * std::pow (2.0, octaves / 2.0) / binWidth));
+
+    if (high < low)
+        low = high = juce::jlimit (0, lastBin, juce::roundToInt (frequency / binWidth));
+
+    double sum = 0.0;
+
+    for (int bin = low; bin <= high; bin++)
+        sum += power[(size_t) bin];
+
+    // A full-scale sine through the Hann window peaks at fftSize / 4
+    auto fullScale = (double) fftSize / 4.0;
+    auto meanPower = sum / ((double) (high - low + 1) * numFrames * numChannels);
+
+    return 10.0 * std::log10 (juce::jmax (meanPower, 1.0e-30) / (fullScale * fullScale));
+}
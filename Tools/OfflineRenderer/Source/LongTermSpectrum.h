@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    LongTermSpectrum.h
+
+    The long-term average spectrum of a file, from a streaming STFT: 8192
+    point Hann windows at 50% overlap, read a hop at a time, with the power of
+    every channel summed into one running average. Only one frame of audio is
+    held, so memory stays the same however long the file is.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class LongTermSpectrum
+{
+public:
+    static constexpr int fftOrder = 13;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+
+    /**
+        Frames quieter than this, as an RMS over every channel, are left out of the
+        average, so silence, fades and gaps between tracks don't pull it down.
+    */
+    static constexpr float gateDecibels = -60.0f;
+
+    LongTermSpectrum();
+
+    /** Reads the whole file from the start and averages every frame above the gate. */
+    void analyse (juce::AudioFormatReader& reader);
+
+    double getSampleRate() const noexcept                   { return sampleRate; }
+
+    /** How many frames were above the gate. With none, every level is -inf. */
+    int getNumFrames() const noexcept                       { return numFrames; }
+
+    /**
+        The average level around frequency, in dB against a full-scale sine: the
+        power of the bins within octaves / 2 either side of it, or of the nearest
+        bin where that's narrower than a bin.
+    */
+    double getLevel (double frequency, double octaves) const;
+
+private:
+    void addFrame (const juce::AudioBuffer<float>& frame);
+
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+    std::vector<float> fftData;
+
+    /** Power summed over frames and channels, from DC up to Nyquist. */
+    std::vector<double> power;
+
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    int numFrames = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LongTermSpectrum)
+};
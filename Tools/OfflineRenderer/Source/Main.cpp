@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless batch renderer for the EQ. Runs audio files through the plugin's
+    processor offline, several files at once, and reports how much faster
+    than realtime each one went. It can fit the bands to a target curve for
+    each file first, and save them as the plugin's state.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RenderJob.h"
+#include "../../../Source/Instrumentation.h"
+
+static void printUsage()
+{
+    std::cout << "Usage: OfflineRenderer [options] <audio files or folders...>" << std::endl
+              << std::endl
+              << "  --output <folder>            write here instead of next to each input (adding \"_eq\")" << std::endl
+              << "  --format wav|aiff            output format, the input's format by default" << std::endl
+              << "  --set \"<parameter>=<value>\"  hold a parameter, by name or ID, e.g. --set \"Band 1 Gain=-3\"" << std::endl
+              << "  --automation <file>          lines of <seconds>, <parameter>, <value>" << std::endl
+              << "  --block-size <samples>       largest block passed to processBlock, 8192 by default" << std::endl
+              << "  --threads <count>            files rendered at once, one per core by default" << std::endl
+              << "  --profile <file>             write each file's processing times and counts here" << std::endl
+              << "  --fit <file>|pink|flat       fit the bands to a target curve of <Hz>, <dB> lines, and save them" << std::endl
+              << "                               next to the output as <name>.eq1state" << std::endl
+              << "  --fit-bands <count>          bands to fit, 6 by default: a low shelf, peaks and a high shelf" << std::endl
+              << "  --max-gain <dB>              the largest boost or cut of a fitted band, 12 by default" << std::endl
+              << "  --fit-only                   save the fitted state without rendering" << std::endl;
+}
+
+static juce::String describe (const FilterDesign::BandSettings& band)
+{
+    auto description = FilterDesign::getBandTypeNames()[(int) band.type] + " " + juce::String (band.frequency) + " Hz "
+                     + (band.gain > 0.0f ? "+" : "") + juce::String (band.gain, 1) + " dB";
+
+    if (band.type == FilterDesign::BandType::peak)
+        description << " Q " << juce::String (band.q, 2);
+
+    return description;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.size() == 0 || args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    RenderSettings settings;
+    auto numThreads = juce::SystemStats::getNumCpus();
+
+    if (args.containsOption ("--output"))
+    {
+        settings.outputFolder = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output"));
+        settings.outputFolder.createDirectory();
+    }
+
+    if (args.containsOption ("--format"))
+        settings.outputFormat = args.removeValueForOption ("--format").toLowerCase();
+
+    if (args.containsOption ("--block-size"))
+        settings.blockSize = juce::jlimit (16, 1 << 20, args.removeValueForOption ("--block-size").getIntValue());
+
+    if (args.containsOption ("--threads"))
+        numThreads = juce::jmax (1, args.removeValueForOption ("--threads").getIntValue());
+
+    juce::File profileFile;
+
+    if (args.containsOption ("--profile"))
+    {
+       #if EQ1_INSTRUMENTATION
+        profileFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--profile"));
+       #else
+        std::cerr << "--profile needs a build with EQ1_INSTRUMENTATION=1" << std::endl;
+        return 1;
+       #endif
+    }
+
+    while (args.containsOption ("--set"))
+    {
+        auto assignment = args.removeValueForOption ("--set");
+        settings.parameterValues.set (assignment.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                      assignment.fromFirstOccurrenceOf ("=", false, false).trim());
+    }
+
+    if (args.containsOption ("--automation"))
+    {
+        auto error = parseAutomationFile (juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--automation")),
+                                          settings.automation);
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption ("--fit"))
+    {
+        auto target = args.removeValueForOption ("--fit");
+        settings.fitToTarget = true;
+
+        if (target.equalsIgnoreCase ("pink"))
+            settings.target = TargetCurve::pink();
+        else if (target.equalsIgnoreCase ("flat"))
+            settings.target = TargetCurve::flat();
+        else
+        {
+            auto error = parseTargetFile (juce::File::getCurrentWorkingDirectory().getChildFile (target), settings.target);
+
+            if (error.isNotEmpty())
+            {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (args.containsOption ("--fit-bands"))
+        settings.fit.numBands = juce::jlimit (1, FilterDesign::maxBands, args.removeValueForOption ("--fit-bands").getIntValue());
+
+    if (args.containsOption ("--max-gain"))
+        settings.fit.maxGain = juce::jlimit (0.1f, 24.0f, args.removeValueForOption ("--max-gain").getFloatValue());
+
+    if (args.removeOptionIfFound ("--fit-only"))
+    {
+        if (! settings.fitToTarget)
+        {
+            std::cerr << "--fit-only needs --fit" << std::endl;
+            return 1;
+        }
+
+        settings.fitOnly = true;
+    }
+
+    juce::Array<juce::File> inputs;
+
+    for (auto& arg : args.arguments)
+    {
+        auto file = arg.resolveAsFile();
+
+        if (file.isDirectory())
+            inputs.addArray (file.findChildFiles (juce::File::findFiles, false, "*.wav;*.aif;*.aiff"));
+        else
+            inputs.add (file);
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    //==============================================================================
+    juce::CriticalSection outputLock;
+    int numFailed = 0;
+    juce::String profiles;
+
+    auto onFinished = [&] (const RenderResult& result)
+    {
+        const juce::ScopedLock sl (outputLock);
+
+        if (! result.succeeded())
+        {
+            std::cerr << result.input.getFileName() << ": " << result.error << std::endl;
+            ++numFailed;
+            return;
+        }
+
+        auto& written = result.output != juce::File() ? result.output : result.state;
+
+        std::cout << result.input.getFileName() << " -> " << written.getFileName() << ": "
+                  << juce::String (result.audioSeconds, 1) << " s of audio in " << juce::String (result.renderSeconds, 2) << " s ("
+                  << juce::String (result.getRealtimeFactor(), 1) << "x realtime)" << std::endl;
+
+        if (result.state != juce::File())
+        {
+            std::cout << "    " << juce::String (result.fit.errorBefore, 2) << " dB from the target, "
+                      << juce::String (result.fit.errorAfter, 2) << " dB with the bands" << std::endl;
+
+            for (auto& band : result.fit.bands)
+                std::cout << "    " << describe (band) << std::endl;
+        }
+
+        if (result.profile.isNotEmpty())
+            profiles << result.input.getFullPathName() << juce::newLine << result.profile << juce::newLine;
+    };
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        juce::ThreadPool pool (numThreads);
+
+        for (auto& input : inputs)
+            pool.addJob (new RenderJob (input, settings, onFinished), true);
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep (20);
+    }
+
+    if (profileFile != juce::File() && ! profileFile.replaceWithText (profiles))
+    {
+        std::cerr << "can't write " << profileFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << inputs.size() << " files in " << juce::String ((juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0, 2)
+              << " s on " << numThreads << " threads" << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    RenderJob.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "RenderJob.h"
+#include "../../Shared/ProcessorSetup.h"
+
+using namespace ProcessorSetup;
+
+namespace
+{
+    /** Sets the first bands to the fitted settings through their parameters, as a host would. */
+    bool setBandParameters (Project4_TemplateAudioProcessor& processor, const std::vector<FilterDesign::BandSettings>& bands)
+    {
+        if (bands.size() > (size_t) FilterDesign::maxBands)
+            return false;
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            auto& band = bands[i];
+            auto index = (int) i;
+
+            setValue (processor.getBandParameter (index, BandField::enabled), band.enabled ? 1.0f : 0.0f);
+            setValue (processor.getBandParameter (index, BandField::type), (float) band.type);
+            setValue (processor.getBandParameter (index, BandField::frequency), (float) band.frequency);
+            setValue (processor.getBandParameter (index, BandField::gain), band.gain);
+            setValue (processor.getBandParameter (index, BandField::q), band.q);
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    /** The breakpoints of one parameter, in samples and normalised values. */
+    struct AutomationLane
+    {
+        juce::AudioProcessorParameter* parameter = nullptr;
+        bool isSwitch = false;
+        std::vector<std::pair<juce::int64, float>> points;
+
+        float getValueAt (juce::int64 position) const
+        {
+            for (size_t i = 1; i < points.size(); ++i)
+            {
+                const auto& start = points[i - 1];
+                const auto& end = points[i];
+
+                if (position < end.first)
+                {
+                    if (isSwitch || position <= start.first)
+                        return start.second;
+
+                    auto proportion = (float) (position - start.first) / (float) (end.first - start.first);
+                    return start.second + proportion * (end.second - start.second);
+                }
+            }
+
+            return points.back().second;
+        }
+
+        juce::int64 getNextPointAfter (juce::int64 position) const
+        {
+            for (const auto& point : points)
+                if (point.first > position)
+                    return point.first;
+
+            return std::numeric_limits<juce::int64>::max();
+        }
+    };
+}
+
+//==============================================================================
+juce::String parseAutomationFile (const juce::File& file, juce::Array<AutomationPoint>& points)
+{
+    if (! file.existsAsFile())
+        return "can't find " + file.getFullPathName();
+
+    juce::StringArray lines;
+    file.readLines (lines);
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        auto line = lines[i].trim();
+
+        if (line.isEmpty() || line.startsWithChar ('#'))
+            continue;
+
+        auto fields = juce::StringArray::fromTokens (line, ",", "\"");
+        fields.trim();
+
+        if (fields.size() != 3)
+            return file.getFileName() + " line " + juce::String (i + 1) + ": expected <seconds>, <parameter>, <value>";
+
+        points.add ({ fields[0].getDoubleValue(), fields[1].unquoted(), fields[2].unquoted() });
+    }
+
+    std::stable_sort (points.begin(), points.end(),
+                      [] (const AutomationPoint& a, const AutomationPoint& b) { return a.time < b.time; });
+    return {};
+}
+
+double RenderResult::getRealtimeFactor() const noexcept
+{
+    return renderSeconds > 0 ? audioSeconds / renderSeconds : 0.0;
+}
+
+//==============================================================================
+RenderJob::RenderJob (const juce::File& inputFile, const RenderSettings& renderSettings,
+                      std::function<void (const RenderResult&)> finishedCallback)
+    : juce::ThreadPoolJob ("Render " + inputFile.getFileName()),
+      input (inputFile),
+      settings (renderSettings),
+      onFinished (std::move (finishedCallback))
+{
+}
+
+juce::ThreadPoolJob::JobStatus RenderJob::runJob()
+{
+    onFinished (render());
+    return jobHasFinished;
+}
+
+RenderResult RenderJob::render()
+{
+    RenderResult result;
+    result.input = input;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto getOutputFile = [this] (const juce::String& extension)
+    {
+        if (settings.outputFolder == juce::File())
+            return input.getSiblingFile (input.getFileNameWithoutExtension() + "_eq" + extension);
+
+        return settings.outputFolder.getChildFile (input.getFileNameWithoutExtension() + extension);
+    };
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto* inputFormat = formatManager.findFormatForFileExtension (input.getFileExtension());
+
+    if (inputFormat == nullptr)
+    {
+        result.error = "unsupported file type";
+        return result;
+    }
+
+    // Where the format allows it, map the whole file instead of copying every block through a stream
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader (inputFormat->createMemoryMappedReader (input));
+
+    if (mappedReader != nullptr && mappedReader->mapEntireFile())
+        reader = std::move (mappedReader);
+    else
+        reader.reset (formatManager.createReaderFor (input));
+
+    if (reader == nullptr)
+    {
+        result.error = "can't read the file";
+        return result;
+    }
+
+    auto numChannels = (int) reader->numChannels;
+    auto sampleRate = reader->sampleRate;
+    auto length = reader->lengthInSamples;
+
+    //==============================================================================
+    Project4_TemplateAudioProcessor processor;
+
+    if (! setNumChannels (processor, numChannels))
+    {
+        result.error = "the EQ doesn't support " + juce::String (numChannels) + " channels";
+        return result;
+    }
+
+    // Bouncing, so the processor designs its coefficients inside processBlock
+    processor.setNonRealtime (true);
+    processor.setRateAndBufferSizeDetails (sampleRate, settings.blockSize);
+
+    for (auto& name : settings.parameterValues.getAllKeys())
+    {
+        auto* parameter = findParameter (processor, name);
+
+        if (parameter == nullptr)
+        {
+            result.error = "no parameter called " + name.quoted();
+            return result;
+        }
+
+        setText (parameter, settings.parameterValues[name]);
+    }
+
+    if (settings.fitToTarget)
+    {
+        // One pass over the file before the render; with the file mapped it costs little more than the FFTs
+        LongTermSpectrum spectrum;
+        spectrum.analyse (*reader);
+
+        EQFitter fitter (settings.fit);
+        result.fit = fitter.fit (spectrum, settings.target);
+
+        if (! setBandParameters (processor, result.fit.bands))
+        {
+            result.error = "can't fit " + juce::String ((int) result.fit.bands.size()) + " bands, the EQ has "
+                         + juce::String (FilterDesign::maxBands);
+            return result;
+        }
+
+        // Off the message thread, so the state holds the settings without coefficients, and they're designed on loading
+        juce::MemoryBlock state;
+        processor.getStateInformation (state);
+        result.state = getOutputFile (".eq1state");
+
+        if (! result.state.replaceWithData (state.getData(), state.getSize()))
+        {
+            result.error = "can't write " + result.state.getFullPathName();
+            return result;
+        }
+
+        if (settings.fitOnly)
+        {
+            result.audioSeconds = (double) length / sampleRate;
+            result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+            return result;
+        }
+    }
+
+    std::vector<AutomationLane> lanes;
+
+    for (auto& point : settings.automation)
+    {
+        auto* parameter = findParameter (processor, point.parameter);
+
+        if (parameter == nullptr)
+        {
+            result.error = "no parameter called " + point.parameter.quoted();
+            return result;
+        }
+
+        auto lane = std::find_if (lanes.begin(), lanes.end(), [parameter] (const AutomationLane& l) { return l.parameter == parameter; });
+
+        if (lane == lanes.end())
+        {
+            lanes.push_back ({ parameter,
+                               dynamic_cast<juce::AudioParameterBool*> (parameter) != nullptr
+                                   || dynamic_cast<juce::AudioParameterChoice*> (parameter) != nullptr,
+                               {} });
+            lane = lanes.end() - 1;
+        }
+
+        lane->points.push_back ({ juce::roundToInt (point.time * sampleRate), parameter->getValueForText (point.value) });
+    }
+
+    for (auto& lane : lanes)
+        lane.parameter->setValueNotifyingHost (lane.getValueAt (0));
+
+    processor.prepareToPlay (sampleRate, settings.blockSize);
+
+    //==============================================================================
+    auto extension = settings.outputFormat.isNotEmpty() ? "." + settings.outputFormat : input.getFileExtension();
+    auto* outputFormat = formatManager.findFormatForFileExtension (extension);
+
+    if (outputFormat == nullptr)
+    {
+        result.error = "unsupported output format " + extension;
+        return result;
+    }
+
+    result.output = getOutputFile (extension);
+    result.output.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream (result.output.createOutputStream());
+
+    if (stream == nullptr)
+    {
+        result.error = "can't write " + result.output.getFullPathName();
+        return result;
+    }
+
+    auto bitDepth = outputFormat->getPossibleBitDepths().contains ((int) reader->bitsPerSample) ? (int) reader->bitsPerSample : 24;
+    std::unique_ptr<juce::AudioFormatWriter> writer (outputFormat->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                    bitDepth, reader->metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        result.error = "can't write " + juce::String (bitDepth) + " bit " + outputFormat->getFormatName();
+        return result;
+    }
+
+    stream.release();
+
+    //==============================================================================
+    juce::AudioBuffer<float> buffer (numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+
+    /*
+        The first latency samples out of the processor come before the input, so
+        they're dropped, and silence is run in after the end of the file until
+        the input's last sample and the bands' ringing after it are out. An
+        unstable band rings forever, so then the output stops with the input.
+    */
+    auto latency = (juce::int64) processor.getLatencySamples();
+    auto tailSeconds = processor.getTailLengthSeconds();
+    auto tail = std::isfinite (tailSeconds) ? (juce::int64) std::ceil (tailSeconds * sampleRate) : 0;
+    auto endOfRender = length + latency + tail;
+
+    for (juce::int64 position = 0; position < endOfRender;)
+    {
+        /*
+            Cut blocks at automation points, so every point lands on its sample. The
+            processor moves frequency, gain and Q across a block towards the values
+            it finds at the start of it, so those are set to where they should be
+            at the end of the block; switches take effect straight away.
+        */
+        auto end = juce::jmin (position + settings.blockSize, endOfRender);
+
+        for (auto& lane : lanes)
+            end = juce::jmin (end, lane.getNextPointAfter (position));
+
+        for (auto& lane : lanes)
+            lane.parameter->setValueNotifyingHost (lane.getValueAt (lane.isSwitch ? position : end));
+
+        auto numSamples = (int) (end - position);
+        buffer.setSize (numChannels, numSamples, false, false, true);
+
+        auto numSamplesInFile = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, length - position);
+        buffer.clear();
+        reader->read (&buffer, 0, numSamplesInFile, position, true, true);
+        processor.processBlock (buffer, midi);
+
+        auto numBeforeInput = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, latency - position);
+        writer->writeFromAudioSampleBuffer (buffer, numBeforeInput, numSamples - numBeforeInput);
+
+        position = end;
+    }
+
+   #if EQ1_INSTRUMENTATION
+    result.profile = processor.getInstrumentation().getReport();
+   #endif
+
+    processor.releaseResources();
+    writer.reset();
+
+    result.audioSeconds = (double) length / sampleRate;
+    result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    return result;
+}
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    RenderJob.h
+
+    Renders one audio file through the EQ processor, offline, on a thread
+    pool. The processor is driven exactly as a host would drive it when
+    bouncing: non-realtime, with parameter changes applied between blocks.
+
+    A job can also fit the bands to a target curve first, from the file's
+    long-term spectrum, and save the fitted settings as the plugin's state.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQFitter.h"
+
+//==============================================================================
+/**
+    One line of an automation file:
+
+        <seconds>, <parameter name or ID>, <value>
+
+    e.g. "1.5, Band 2 Frequency, 4000". Values are given as the parameter shows
+    them ("Low Shelf", "-3.5", "On"). Blank lines and lines starting with '#'
+    are ignored.
+
+    Points are breakpoints: frequency, gain and Q move from one point to the
+    next, and the enable, type and slope switches change at the point.
+*/
+struct AutomationPoint
+{
+    double time = 0;
+    juce::String parameter;
+    juce::String value;
+};
+
+/** Reads an automation file, or returns an error message. */
+juce::String parseAutomationFile (const juce::File& file, juce::Array<AutomationPoint>& points);
+
+//==============================================================================
+struct RenderSettings
+{
+    /** Empty to write next to each input, with "_eq" added to the name. */
+    juce::File outputFolder;
+
+    /** "wav" or "aiff", or empty to keep the input's format. */
+    juce::String outputFormat;
+
+    /** Parameter name or ID, and the value to hold for the whole file. */
+    juce::StringPairArray parameterValues;
+
+    juce::Array<AutomationPoint> automation;
+
+    int blockSize = 8192;
+
+    /**
+        Fits the first bands to target before rendering, replacing any values
+        held for them, and writes the processor's state with the fitted settings
+        next to the output, as <name>.eq1state.
+    */
+    bool fitToTarget = false;
+    TargetCurve target;
+    FitSettings fit;
+
+    /** Only write the fitted state, without rendering. */
+    bool fitOnly = false;
+};
+
+struct RenderResult
+{
+    juce::File input, output, state;
+    double audioSeconds = 0;
+    double renderSeconds = 0;
+    juce::String error;
+
+    /** The processor's instrumentation report, in builds that have it. */
+    juce::String profile;
+
+    /** The fitted bands, when the job fits them. */
+    FitResult fit;
+
+    bool succeeded() const noexcept     { return error.isEmpty(); }
+    double getRealtimeFactor() const noexcept;
+};
+
+//==============================================================================
+class RenderJob  : public juce::ThreadPoolJob
+{
+public:
+    RenderJob (const juce::File& input, const RenderSettings& settings,
+               std::function<void (const RenderResult&)> onFinished);
+
+    JobStatus runJob() override;
+
+private:
+    RenderResult render();
+
+    juce::File input;
+    const RenderSettings& settings;
+    std::function<void (const RenderResult&)> onFinished;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
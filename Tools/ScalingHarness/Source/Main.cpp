@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    How many EQ instances one machine really runs. Hundreds of processors in
+    one process, driven from a work-stealing pool in host-like callbacks,
+    with the callback time, throughput and cache misses reported as the
+    instance and thread counts grow. Instances that slow each other down,
+    through false sharing or a contended allocator, show up as time per
+    instance that rises with the thread count instead of staying flat.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ScalingRun.h"
+#include "../../../Source/FilterDesign.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: ScalingHarness [options]" << std::endl
+              << std::endl
+              << "  --instances <counts>     instance counts to run, 1,16,64,256 by default" << std::endl
+              << "  --threads <counts>       thread counts, 1, 2, 4 ... up to the number of cores by default" << std::endl
+              << "  --block-size <samples>   samples per callback, 256 by default" << std::endl
+              << "  --channels <count>       channels per instance, 2 by default" << std::endl
+              << "  --bands <count>          bands switched on in each instance, 4 by default" << std::endl
+              << "  --seconds <seconds>      audio time per run, 2 by default" << std::endl
+              << "  --output <file>          write the JSON results here instead of to stdout" << std::endl;
+}
+
+static juce::Array<int> parseCounts (const juce::String& text)
+{
+    juce::Array<int> counts;
+
+    for (auto& token : juce::StringArray::fromTokens (text, ",", {}))
+        if (token.getIntValue() > 0)
+            counts.add (token.getIntValue());
+
+    return counts;
+}
+
+static juce::var toJSON (const ScalingOptions& options, const juce::Array<ScalingResult>& results)
+{
+    juce::Array<juce::var> entries;
+
+    for (auto& result : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("instances", result.numInstances);
+        entry->setProperty ("threads", result.numThreads);
+        entry->setProperty ("cycles", result.numCycles);
+        entry->setProperty ("deadlineUs", result.deadlineMicroseconds);
+        entry->setProperty ("meanUs", result.meanMicroseconds);
+        entry->setProperty ("p99Us", result.p99Microseconds);
+        entry->setProperty ("worstUs", result.worstMicroseconds);
+        entry->setProperty ("missedDeadlines", result.numMissedDeadlines);
+        entry->setProperty ("instanceBlocksPerSecond", result.instanceBlocksPerSecond);
+        entry->setProperty ("steals", result.numSteals);
+
+        if (result.cacheMissesPerInstanceBlock >= 0)
+            entry->setProperty ("cacheMissesPerInstanceBlock", result.cacheMissesPerInstanceBlock);
+
+        entries.add (juce::var (entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("cores", juce::SystemStats::getNumCpus());
+    root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+    root->setProperty ("blockSize", options.blockSize);
+    root->setProperty ("sampleRate", options.sampleRate);
+    root->setProperty ("channels", options.numChannels);
+    root->setProperty ("bands", options.numBands);
+    root->setProperty ("results", entries);
+
+    return juce::var (root);
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    ScalingOptions options;
+
+    if (args.containsOption ("--instances"))
+        options.instanceCounts = parseCounts (args.removeValueForOption ("--instances"));
+
+    if (args.containsOption ("--threads"))
+        options.threadCounts = parseCounts (args.removeValueForOption ("--threads"));
+
+    if (args.containsOption ("--block-size"))
+        options.blockSize = juce::jlimit (16, 8192, args.removeValueForOption ("--block-size").getIntValue());
+
+    if (args.containsOption ("--channels"))
+        options.numChannels = juce::jlimit (1, 64, args.removeValueForOption ("--channels").getIntValue());
+
+    if (args.containsOption ("--bands"))
+        options.numBands = juce::jlimit (1, FilterDesign::maxBands, args.removeValueForOption ("--bands").getIntValue());
+
+    if (args.containsOption ("--seconds"))
+        options.secondsPerRun = juce::jmax (0.1, args.removeValueForOption ("--seconds").getDoubleValue());
+
+    if (options.threadCounts.isEmpty())
+    {
+        auto numCores = juce::SystemStats::getNumCpus();
+
+        for (int threads = 1; threads < numCores; threads *= 2)
+            options.threadCounts.add (threads);
+
+        options.threadCounts.add (numCores);
+    }
+
+    if (options.instanceCounts.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    //==============================================================================
+    std::cerr << "instances threads   mean us    p99 us  worst us  deadline  missed  blocks/s  misses/block  steals" << std::endl;
+
+    juce::Array<ScalingResult> results;
+
+    for (auto numThreads : options.threadCounts)
+    {
+        for (auto numInstances : options.instanceCounts)
+        {
+            auto result = runScaling (options, numInstances, numThreads);
+            results.add (result);
+
+            std::cerr << juce::String (result.numInstances).paddedLeft (' ', 9)
+                      << juce::String (result.numThreads).paddedLeft (' ', 8)
+                      << juce::String (result.meanMicroseconds, 1).paddedLeft (' ', 10)
+                      << juce::String (result.p99Microseconds, 1).paddedLeft (' ', 10)
+                      << juce::String (result.worstMicroseconds, 1).paddedLeft (' ', 10)
+                      << juce::String (result.deadlineMicroseconds, 1).paddedLeft (' ', 10)
+                      << juce::String (result.numMissedDeadlines).paddedLeft (' ', 8)
+                      << juce::String (result.instanceBlocksPerSecond, 0).paddedLeft (' ', 10)
+                      << (result.cacheMissesPerInstanceBlock >= 0 ? juce::String (result.cacheMissesPerInstanceBlock, 1) : juce::String ("n/a")).paddedLeft (' ', 14)
+                      << juce::String (result.numSteals).paddedLeft (' ', 8) << std::endl;
+        }
+    }
+
+    /*
+        The most instances that kept p99 within the deadline on each thread count.
+        Only the counts that were run are tried, so the answer is a lower bound.
+    */
+    std::cerr << std::endl;
+
+    for (auto numThreads : options.threadCounts)
+    {
+        auto mostInstances = 0;
+
+        for (auto& result : results)
+            if (result.numThreads == numThreads && result.metDeadline())
+                mostInstances = juce::jmax (mostInstances, result.numInstances);
+
+        std::cerr << numThreads << " threads: at least " << mostInstances << " instances within the deadline ("
+                  << juce::String ((double) mostInstances / numThreads, 1) << " per thread)" << std::endl;
+    }
+
+    auto json = juce::JSON::toString (toJSON (options, results));
+
+    if (args.containsOption ("--output"))
+    {
+        auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output"));
+
+        if (! outputFile.replaceWithText (json))
+        {
+            std::cerr << "can't write " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return 0;
+}
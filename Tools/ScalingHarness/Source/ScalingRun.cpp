@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    ScalingRun.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "ScalingRun.h"
+#include "WorkStealingPool.h"
+#include "../../Shared/ProcessorSetup.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    /**
+        The calling thread's last-level cache misses, from the kernel's performance
+        counters. Only Linux has them, and only where perf_event_paranoid allows it.
+    */
+    class CacheMissCounter
+    {
+    public:
+        CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            perf_event_attr attributes {};
+            attributes.size = sizeof (attributes);
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            file = (int) syscall (SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            if (file >= 0)
+                close (file);
+           #endif
+        }
+
+        bool isAvailable() const noexcept       { return file >= 0; }
+
+        juce::uint64 read() const noexcept
+        {
+            juce::uint64 count = 0;
+
+           #if JUCE_LINUX
+            if (file >= 0 && ::read (file, &count, sizeof (count)) != (ssize_t) sizeof (count))
+                count = 0;
+           #endif
+
+            return count;
+        }
+
+    private:
+        int file = -1;
+
+        JUCE_DECLARE_NON_COPYABLE (CacheMissCounter)
+    };
+
+    //==============================================================================
+    struct Instance
+    {
+        Project4_TemplateAudioProcessor processor;
+        juce::AudioBuffer<float> buffer;
+    };
+
+    class ScalingJob  : public WorkStealingPool::Job
+    {
+    public:
+        ScalingJob (std::vector<std::unique_ptr<Instance>>& instancesToRun, const juce::AudioBuffer<float>& sourceToCopy, int numThreads)
+            : instances (instancesToRun), source (sourceToCopy)
+        {
+            threads.resize ((size_t) numThreads);
+        }
+
+        /** Misses counted on every thread since the last call, or -1 if any thread couldn't count them. */
+        double takeCacheMisses() noexcept
+        {
+            juce::uint64 total = 0;
+
+            for (auto& state : threads)
+            {
+                if (state.counter == nullptr || ! state.counter->isAvailable())
+                    return -1.0;
+
+                total += state.misses;
+                state.misses = 0;
+            }
+
+            return (double) total;
+        }
+
+        void beginCycle (int thread) override
+        {
+            auto& state = threads[thread];
+
+            // Opened on the thread it counts, the first time each thread runs a cycle
+            if (state.counter == nullptr)
+                state.counter.reset (new CacheMissCounter());
+
+            state.start = state.counter->read();
+        }
+
+        void runTask (int task, int) override
+        {
+            auto& instance = *instances[(size_t) task];
+            juce::MidiBuffer midi;
+
+            for (int channel = 0; channel < source.getNumChannels(); channel++)
+                instance.buffer.copyFrom (channel, 0, source, channel, 0, source.getNumSamples());
+
+            instance.processor.processBlock (instance.buffer, midi);
+        }
+
+        void endCycle (int thread) override
+        {
+            auto& state = threads[thread];
+            state.misses += state.counter->read() - state.start;
+        }
+
+    private:
+        // Each thread's own, on separate cache lines so the counting doesn't share any
+        struct alignas (64) ThreadState
+        {
+            std::unique_ptr<CacheMissCounter> counter;
+            juce::uint64 start = 0;
+            juce::uint64 misses = 0;
+        };
+
+        std::vector<std::unique_ptr<Instance>>& instances;
+        const juce::AudioBuffer<float>& source;
+        std::vector<ThreadState> threads;
+    };
+}
+
+//==============================================================================
+ScalingResult runScaling (const ScalingOptions& options, int numInstances, int numThreads)
+{
+    ScalingResult result;
+    result.numInstances = numInstances;
+    result.numThreads = numThreads;
+    result.deadlineMicroseconds = options.blockSize / options.sampleRate * 1.0e6;
+
+    // Made one after another on one thread, as a host loading a session would
+    std::vector<std::unique_ptr<Instance>> instances;
+
+    for (int i = 0; i < numInstances; i++)
+    {
+        auto instance = std::make_unique<Instance>();
+        auto& processor = instance->processor;
+
+        ProcessorSetup::setNumChannels (processor, options.numChannels);
+        ProcessorSetup::setUpBands (processor, options.numBands);
+        processor.setRateAndBufferSizeDetails (options.sampleRate, options.blockSize);
+        processor.prepareToPlay (options.sampleRate, options.blockSize);
+
+        instance->buffer.setSize (options.numChannels, options.blockSize);
+        instances.push_back (std::move (instance));
+    }
+
+    juce::AudioBuffer<float> source (options.numChannels, options.blockSize);
+    juce::Random random (1);
+
+    for (int channel = 0; channel < options.numChannels; channel++)
+        for (int i = 0; i < options.blockSize; i++)
+            source.setSample (channel, i, 0.5f * (random.nextFloat() * 2.0f - 1.0f));
+
+    //==============================================================================
+    WorkStealingPool pool (numThreads);
+    ScalingJob job (instances, source, numThreads);
+
+    auto blocksPerSecond = options.sampleRate / options.blockSize;
+    auto numWarmUpCycles = juce::roundToInt (0.25 * blocksPerSecond);
+    result.numCycles = juce::jmax (1, juce::roundToInt (options.secondsPerRun * blocksPerSecond));
+
+    for (int i = 0; i < numWarmUpCycles; i++)
+        pool.run (job, numInstances);
+
+    job.takeCacheMisses();
+    auto stealsBefore = pool.getNumSteals();
+
+    std::vector<double> durations ((size_t) result.numCycles);
+    auto ticksToMicroseconds = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    auto runStart = juce::Time::getHighResolutionTicks();
+
+    for (auto& duration : durations)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        pool.run (job, numInstances);
+        duration = (double) (juce::Time::getHighResolutionTicks() - start) * ticksToMicroseconds;
+    }
+
+    auto runMicroseconds = (double) (juce::Time::getHighResolutionTicks() - runStart) * ticksToMicroseconds;
+    auto misses = job.takeCacheMisses();
+
+    //==============================================================================
+    for (auto duration : durations)
+    {
+        result.meanMicroseconds += duration;
+
+        if (duration > result.deadlineMicroseconds)
+            ++result.numMissedDeadlines;
+    }
+
+    result.meanMicroseconds /= (double) result.numCycles;
+
+    std::sort (durations.begin(), durations.end());
+    result.p99Microseconds = durations[juce::jmin (durations.size() - 1, (size_t) std::ceil (0.99 * (double) durations.size()) - 1)];
+    result.worstMicroseconds = durations.back();
+
+    auto numInstanceBlocks = (double) numInstances * result.numCycles;
+    result.instanceBlocksPerSecond = numInstanceBlocks / (runMicroseconds * 1.0e-6);
+    result.cacheMissesPerInstanceBlock = misses >= 0 ? misses / numInstanceBlocks : -1.0;
+    result.numSteals = pool.getNumSteals() - stealsBefore;
+
+    for (auto& instance : instances)
+        instance->processor.releaseResources();
+
+    return result;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    ScalingRun.h
+
+    Many EQ instances in one process, driven like a host drives them: every
+    callback, each instance processes one block, spread over the threads of
+    a WorkStealingPool, and the callback has to finish within the block's
+    duration. One run is one instance count on one thread count.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct ScalingOptions
+{
+    juce::Array<int> instanceCounts { 1, 16, 64, 256 };
+
+    /** Empty for 1, 2, 4 ... up to the number of cores. */
+    juce::Array<int> threadCounts;
+
+    int numChannels = 2;
+    int blockSize = 256;
+    double sampleRate = 48000;
+
+    /** Bands switched on in every instance, cycling through the band types. */
+    int numBands = 4;
+
+    /** Audio time processed per run, after a quarter of a second to warm up. */
+    double secondsPerRun = 2.0;
+};
+
+struct ScalingResult
+{
+    int numInstances = 0;
+    int numThreads = 0;
+    int numCycles = 0;
+
+    /** How long each callback may take: one block at the sample rate. */
+    double deadlineMicroseconds = 0;
+
+    /** From the start of a callback to the last thread finishing it. */
+    double meanMicroseconds = 0;
+    double p99Microseconds = 0;
+    double worstMicroseconds = 0;
+    int numMissedDeadlines = 0;
+
+    /** Blocks processed per second of wall time, counting each instance's block separately. */
+    double instanceBlocksPerSecond = 0;
+
+    /** Last-level cache misses per instance per block, or -1 where the counters can't be read. */
+    double cacheMissesPerInstanceBlock = -1;
+
+    /** Tasks that ran on another thread than the one they were given to. */
+    juce::int64 numSteals = 0;
+
+    bool metDeadline() const noexcept           { return p99Microseconds <= deadlineMicroseconds; }
+};
+
+ScalingResult runScaling (const ScalingOptions& options, int numInstances, int numThreads);
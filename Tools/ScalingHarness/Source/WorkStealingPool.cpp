@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.cpp
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#include "WorkStealingPool.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #endif
+    }
+
+    /** Spins briefly, then gives the core away, until the condition holds. */
+    template <typename Condition>
+    void waitUntil (Condition&& condition)
+    {
+        for (int spins = 0; ! condition(); spins++)
+        {
+            if (spins < 4096)
+                pause();
+            else
+                std::this_thread::yield();
+        }
+    }
+}
+
+//==============================================================================
+WorkStealingPool::WorkStealingPool (int threads)
+    : numThreads (juce::jmax (1, threads))
+{
+    queues.allocate ((size_t) numThreads, true);
+
+    for (int thread = 1; thread < numThreads; thread++)
+        workers.emplace_back ([this, thread] { workerLoop (thread); });
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    shouldExit = true;
+    cycle.fetch_add (1, std::memory_order_release);
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void WorkStealingPool::run (Job& job, int numTasks)
+{
+    // Contiguous shares, so neighbouring instances start on the same thread
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        auto start = (juce::uint32) ((juce::int64) numTasks * thread / numThreads);
+        auto end = (juce::uint32) ((juce::int64) numTasks * (thread + 1) / numThreads);
+        queues[thread].range.store (pack (start, end), std::memory_order_relaxed);
+    }
+
+    currentJob = &job;
+    remainingTasks.store (numTasks, std::memory_order_relaxed);
+    threadsFinished.store (0, std::memory_order_relaxed);
+    cycle.fetch_add (1, std::memory_order_release);
+
+    runCycle (0);
+
+    // The next cycle reuses the queues and the job's per-thread state, so every worker has to be out of this one
+    waitUntil ([this] { return threadsFinished.load (std::memory_order_acquire) == numThreads - 1; });
+}
+
+void WorkStealingPool::workerLoop (int thread)
+{
+    // Not read from the counter: a worker that starts late must still see the first cycle as new
+    juce::uint32 seenCycle = 0;
+
+    for (;;)
+    {
+        waitUntil ([this, seenCycle] { return cycle.load (std::memory_order_acquire) != seenCycle; });
+        seenCycle = cycle.load (std::memory_order_acquire);
+
+        if (shouldExit)
+            return;
+
+        runCycle (thread);
+        threadsFinished.fetch_add (1, std::memory_order_release);
+    }
+}
+
+void WorkStealingPool::runCycle (int thread)
+{
+    auto& job = *currentJob;
+    job.beginCycle (thread);
+
+    int task;
+
+    while (remainingTasks.load (std::memory_order_acquire) > 0)
+    {
+        if (popOwn (thread, task) || steal (thread, task))
+        {
+            job.runTask (task, thread);
+            remainingTasks.fetch_sub (1, std::memory_order_acq_rel);
+        }
+        else
+        {
+            // Everything left is already running somewhere
+            pause();
+        }
+    }
+
+    job.endCycle (thread);
+}
+
+bool WorkStealingPool::popOwn (int thread, int& task) noexcept
+{
+    auto& range = queues[thread].range;
+    auto current = range.load (std::memory_order_acquire);
+
+    for (;;)
+    {
+        auto start = (juce::uint32) current;
+        auto end = (juce::uint32) (current >> 32);
+
+        if (start >= end)
+            return false;
+
+        if (range.compare_exchange_weak (current, pack (start, end - 1), std::memory_order_acq_rel))
+        {
+            task = (int) (end - 1);
+            return true;
+        }
+    }
+}
+
+bool WorkStealingPool::steal (int thread, int& task) noexcept
+{
+    for (int offset = 1; offset < numThreads; offset++)
+    {
+        auto& range = queues[(thread + offset) % numThreads].range;
+        auto current = range.load (std::memory_order_acquire);
+
+        for (;;)
+        {
+            auto start = (juce::uint32) current;
+            auto end = (juce::uint32) (current >> 32);
+
+            if (start >= end)
+                break;
+
+            if (range.compare_exchange_weak (current, pack (start + 1, end), std::memory_order_acq_rel))
+            {
+                task = (int) start;
+                numSteals.fetch_add (1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.h
+
+    Runs one host callback's worth of tasks across a fixed set of threads,
+    the way a host spreads its plugin instances over its audio threads. The
+    calling thread takes part, so a pool of 4 is the caller and 3 workers.
+
+    The tasks of a cycle are known before it starts, so each thread's queue
+    is just a range of task indices, packed into one 64-bit atomic: the
+    owner takes from the end and thieves from the start, both with a
+    compare-and-swap on the same word. A thread that runs out steals one
+    task at a time from the others, so a slow instance, or a thread the OS
+    has descheduled, holds the cycle up by one task rather than by its whole
+    share. Between cycles the workers spin, then yield, waiting for the next
+    one, as audio threads do; nothing in a cycle locks or allocates.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class WorkStealingPool
+{
+public:
+    /** What a cycle runs. Every thread calls beginCycle, any number of runTask, then endCycle. */
+    struct Job
+    {
+        virtual ~Job() = default;
+
+        virtual void beginCycle (int /*thread*/) {}
+        virtual void runTask (int task, int thread) = 0;
+        virtual void endCycle (int /*thread*/) {}
+    };
+
+    explicit WorkStealingPool (int numThreads);
+    ~WorkStealingPool();
+
+    int getNumThreads() const noexcept                      { return numThreads; }
+
+    /** Runs tasks 0 to numTasks - 1 and returns once every thread has finished the cycle. */
+    void run (Job& job, int numTasks);
+
+    /** Tasks that ran on another thread than the one they were given to, since the pool was made. */
+    juce::int64 getNumSteals() const noexcept               { return numSteals.load(); }
+
+private:
+    void workerLoop (int thread);
+    void runCycle (int thread);
+    bool popOwn (int thread, int& task) noexcept;
+    bool steal (int thread, int& task) noexcept;
+
+    // The start and end of each thread's remaining range, on a cache line of its own
+    struct alignas (64) Queue
+    {
+        std::atomic<juce::uint64> range { 0 };
+    };
+
+    static juce::uint64 pack (juce::uint32 start, juce::uint32 end) noexcept    { return ((juce::uint64) end << 32) | start; }
+
+    const int numThreads;
+    juce::HeapBlock<Queue> queues;
+    std::vector<std::thread> workers;
+
+    Job* currentJob = nullptr;
+    alignas (64) std::atomic<juce::uint32> cycle { 0 };
+    alignas (64) std::atomic<int> remainingTasks { 0 };
+    alignas (64) std::atomic<int> threadsFinished { 0 };
+    std::atomic<juce::int64> numSteals { 0 };
+    std::atomic<bool> shouldExit { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkStealingPool)
+};
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ProcessorSetup.h
+
+    Helpers the tools share for setting up the EQ processor the way a host
+    would: finding parameters, setting them from values or text, choosing the
+    channel layout and switching on a spread of bands. Band parameters are
+    found through the processor rather than by name, as band 1 still has the
+    names of the original single-band EQ.
+
+    Author: Brandon Ferrante
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+namespace ProcessorSetup
+{
+    using BandField = Project4_TemplateAudioProcessor::BandField;
+
+    /** Matches a parameter's ID, or its name ignoring case. */
+    inline juce::AudioProcessorParameter* findParameter (juce::AudioProcessor& processor, const juce::String& nameOrId)
+    {
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                if (withId->paramID == nameOrId)
+                    return parameter;
+
+            if (parameter->getName (1024).equalsIgnoreCase (nameOrId))
+                return parameter;
+        }
+
+        return nullptr;
+    }
+
+    /** Sets the parameter as the text it shows, e.g. "Low Shelf" or "-3.5". */
+    inline void setText (juce::AudioProcessorParameter* parameter, const juce::String& text)
+    {
+        parameter->setValueNotifyingHost (parameter->getValueForText (text));
+    }
+
+    /** Sets the parameter and returns the value it holds afterwards, which its range may have rounded. */
+    inline float setValue (juce::RangedAudioParameter* parameter, float value)
+    {
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+        return parameter->convertFrom0to1 (parameter->getValue());
+    }
+
+    /** Only the main buses change; the sidechain stays off. */
+    inline bool setNumChannels (juce::AudioProcessor& processor, int numChannels)
+    {
+        auto layout = processor.getBusesLayout();
+        layout.inputBuses.getReference (0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+        layout.outputBuses.getReference (0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+        return processor.setBusesLayout (layout);
+    }
+
+    /**
+        Switches on the first numBands bands and the rest off, spread from lowest to
+        highest and cycling through peak, low shelf, high shelf and peak, at +6 and
+        -6 dB in turn with Q 1.
+    */
+    inline void setUpBands (Project4_TemplateAudioProcessor& processor, int numBands, double lowest = 100.0, double highest = 10000.0)
+    {
+        static const char* types[] = { "Peak", "Low Shelf", "High Shelf", "Peak" };
+
+        for (int band = 0; band < FilterDesign::maxBands; band++)
+        {
+            auto enabled = band < numBands;
+            processor.getBandParameter (band, BandField::enabled)->setValueNotifyingHost (enabled ? 1.0f : 0.0f);
+
+            if (! enabled)
+                continue;
+
+            auto frequency = lowest * std::pow (highest / lowest, numBands > 1 ? band / (double) (numBands - 1) : 0.5);
+
+            setText (processor.getBandParameter (band, BandField::type), types[band % 4]);
+            setValue (processor.getBandParameter (band, BandField::frequency), (float) juce::roundToInt (frequency));
+            setValue (processor.getBandParameter (band, BandField::gain), band % 2 == 0 ? 6.0f : -6.0f);
+            setValue (processor.getBandParameter (band, BandField::q), 1.0f);
+        }
+    }
+}